@@ -0,0 +1,210 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/*
+ * Status packet parsing benchmark (Google Benchmark)
+ *
+ * Sync read responses are served by an in-memory port, in random chunks of 1 to 64 bytes
+ * (several status packets or a part of one per readPort()). Noise is injected before a
+ * status packet with the given probability (%) : up to 31 random bytes and a fake FF FF header.
+ * Before the benchmarks are run, the data of every id is checked in every response.
+ *
+ * The benchmark argument is the noise probability (%).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dynamixel_sdk/dynamixel_sdk.h"
+
+using namespace dynamixel;
+
+#define BENCH_ID_COUNT        6
+#define BENCH_DATA_LENGTH     10
+#define BENCH_START_ADDRESS   126
+#define BENCH_RESPONSES       256     // different responses served in turn
+#define BENCH_MAX_CHUNK       64
+
+// serves one response in random chunks, no timing
+class MemoryPortHandler : public PortHandler
+{
+ public:
+  std::vector<uint8_t> stream;
+  size_t position;
+  std::mt19937 rng;
+
+  MemoryPortHandler() : position(0), rng(1) { is_using_ = false; }
+
+  bool    setupGpio() { return true; }
+  void    gpioHigh() { }
+  void    gpioLow() { }
+  bool    openPort() { return true; }
+  void    closePort() { }
+  void    clearPort() { }
+  void    setPortName(const char *port_name) { }
+  char   *getPortName() { return NULL; }
+  bool    setBaudRate(const int baudrate) { return true; }
+  int     getBaudRate() { return DEFAULT_BAUDRATE_; }
+  int     getBytesAvailable() { return stream.size() - position; }
+  int     writePort(uint8_t *packet, int length) { return length; }
+  void    setPacketTimeout(uint16_t packet_length) { }
+  void    setPacketTimeout(double msec) { }
+  bool    isPacketTimeout() { return position >= stream.size(); }
+
+  int readPort(uint8_t *packet, int length)
+  {
+    int chunk = rng() % BENCH_MAX_CHUNK + 1;
+    if (chunk > length)
+      chunk = length;
+    if ((size_t)chunk > stream.size() - position)
+      chunk = stream.size() - position;
+    memcpy(packet, &stream[position], chunk);
+    position += chunk;
+    return chunk;
+  }
+};
+
+static uint8_t getDataByte(uint8_t id, int index)
+{
+  return (uint8_t)(id * 16 + index);
+}
+
+// status packets of ids 1 to BENCH_ID_COUNT, noise before a packet with probability noise_percent
+static std::vector<std::vector<uint8_t> > makeResponses(int noise_percent)
+{
+  std::mt19937 rng(noise_percent);
+  std::vector<std::vector<uint8_t> > responses(BENCH_RESPONSES);
+
+  for (std::vector<uint8_t> &response : responses)
+  {
+    for (int id = 1; id <= BENCH_ID_COUNT; id++)
+    {
+      if ((int)(rng() % 100) < noise_percent)
+      {
+        int noise_length = rng() % 32;
+        for (int i = 0; i < noise_length; i++)
+          response.push_back(rng() & 0xFF);
+        response.push_back(0xFF);
+        response.push_back(0xFF);
+      }
+
+      uint8_t packet[11 + BENCH_DATA_LENGTH] = { 0xFF, 0xFF, 0xFD, 0x00, (uint8_t)id,
+                                                 BENCH_DATA_LENGTH + 4, 0x00, INST_STATUS, 0x00 };
+      for (int i = 0; i < BENCH_DATA_LENGTH; i++)
+        packet[9 + i] = getDataByte(id, i);
+      uint16_t crc = Crc16::update(0, packet, 9 + BENCH_DATA_LENGTH);
+      packet[9 + BENCH_DATA_LENGTH] = DXL_LOBYTE(crc);
+      packet[10 + BENCH_DATA_LENGTH] = DXL_HIBYTE(crc);
+      response.insert(response.end(), packet, packet + sizeof(packet));
+    }
+  }
+  return responses;
+}
+
+static bool readResponse(MemoryPortHandler &port, GroupSyncRead &group, const std::vector<uint8_t> &response)
+{
+  port.stream = response;
+  port.position = 0;
+  group.txPacket();
+  return group.rxPacket() == COMM_SUCCESS;
+}
+
+// every data byte of every id : two 4-byte and one 2-byte registers
+static bool checkData(GroupSyncRead &group)
+{
+  for (int id = 1; id <= BENCH_ID_COUNT; id++)
+  {
+    if (group.getData(id, BENCH_START_ADDRESS, 4) != DXL_MAKEDWORD(DXL_MAKEWORD(getDataByte(id, 0), getDataByte(id, 1)),
+                                                                   DXL_MAKEWORD(getDataByte(id, 2), getDataByte(id, 3))) ||
+        group.getData(id, BENCH_START_ADDRESS + 4, 4) != DXL_MAKEDWORD(DXL_MAKEWORD(getDataByte(id, 4), getDataByte(id, 5)),
+                                                                       DXL_MAKEWORD(getDataByte(id, 6), getDataByte(id, 7))) ||
+        group.getData(id, BENCH_START_ADDRESS + 8, 2) != DXL_MAKEWORD(getDataByte(id, 8), getDataByte(id, 9)))
+      return false;
+  }
+  return true;
+}
+
+static void BM_SyncReadParse(benchmark::State &state)
+{
+  MemoryPortHandler port;
+  GroupSyncRead group(&port, PacketHandler::getPacketHandler(2.0), BENCH_START_ADDRESS, BENCH_DATA_LENGTH);
+  for (int id = 1; id <= BENCH_ID_COUNT; id++)
+    group.addParam(id);
+  std::vector<std::vector<uint8_t> > responses = makeResponses(state.range(0));
+
+  size_t index = 0;
+  int64_t bytes = 0;
+  int failures = 0;
+  for (auto _ : state)
+  {
+    const std::vector<uint8_t> &response = responses[index];
+    index = (index + 1) % responses.size();
+    if (!readResponse(port, group, response))
+      failures++;
+    bytes += response.size();
+  }
+  if (failures > 0)
+    state.SkipWithError("sync read failed");
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_SyncReadParse)->Arg(0)->Arg(20)->Arg(100);
+
+int main(int argc, char **argv)
+{
+  const int noise_percents[] = { 0, 20, 100 };
+  for (int noise_percent : noise_percents)
+  {
+    MemoryPortHandler port;
+    GroupSyncRead group(&port, PacketHandler::getPacketHandler(2.0), BENCH_START_ADDRESS, BENCH_DATA_LENGTH);
+    for (int id = 1; id <= BENCH_ID_COUNT; id++)
+      group.addParam(id);
+
+    std::vector<std::vector<uint8_t> > responses = makeResponses(noise_percent);
+    for (size_t i = 0; i < responses.size(); i++)
+    {
+      if (!readResponse(port, group, responses[i]) || !checkData(group))
+      {
+        fprintf(stderr, "wrong data in response %zu (noise %d%%)\n", i, noise_percent);
+        return 1;
+      }
+    }
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
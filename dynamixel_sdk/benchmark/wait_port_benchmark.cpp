@@ -0,0 +1,166 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/*
+ * waitPort() micro-benchmark
+ *
+ * A pseudo terminal stands for the bus : a responder thread answers each ping
+ * after a fixed return delay. The same transactions are timed with
+ * - PortHandlerLinux::waitPort() (ppoll until bytes are received or the packet timeout)
+ * - a port handler that keeps polling readPort() (waitPort() returns at once)
+ * and the wall time and CPU time of the calling thread are printed per transaction.
+ *
+ * usage : wait_port_benchmark [transactions] [return delay (us)]
+ */
+
+#include <fcntl.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <atomic>
+#include <thread>
+
+#include "dynamixel_sdk/dynamixel_sdk.h"
+
+using namespace dynamixel;
+
+#define DXL_ID          1
+
+static std::atomic<bool> responder_keep_alive(true);
+
+// waitPort() of the PortHandler base class : the caller spins on readPort()
+class PollingPortHandler : public PortHandlerLinux
+{
+ public:
+  PollingPortHandler(const char *port_name) : PortHandlerLinux(port_name) { }
+  bool waitPort() { return true; }
+};
+
+// answers each instruction packet with a ping status packet after return_delay us
+static void responder(int fd, int return_delay)
+{
+  uint8_t rx[256];
+  uint8_t status[14] = { 0xFF, 0xFF, 0xFD, 0x00, DXL_ID, 0x07, 0x00, 0x55, 0x00, 0x06, 0x04, 0x26, 0x00, 0x00 };
+  uint16_t crc = Crc16::update(0, status, 12);
+  status[12] = DXL_LOBYTE(crc);
+  status[13] = DXL_HIBYTE(crc);
+
+  while (responder_keep_alive)
+  {
+    int n = read(fd, rx, sizeof(rx));
+    if (n <= 0)
+    {
+      usleep(100);
+      continue;
+    }
+    usleep(return_delay);
+    if (write(fd, status, sizeof(status)) != sizeof(status))
+      fprintf(stderr, "responder : write failed\n");
+  }
+}
+
+static double getElapsedUs(const struct timespec &start, const struct timespec &end)
+{
+  return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+static double getCpuUs(const struct rusage &usage)
+{
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void runBenchmark(const char *name, PortHandler *port, int transactions)
+{
+  PacketHandler *packet_handler = PacketHandler::getPacketHandler(2.0);
+  int success = 0;
+
+  if (!port->openPort() || !port->setBaudRate(1000000))
+  {
+    fprintf(stderr, "%s : failed to open the pty\n", name);
+    return;
+  }
+
+  struct rusage usage_start, usage_end;
+  struct timespec wall_start, wall_end;
+  getrusage(RUSAGE_THREAD, &usage_start);
+  clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+  for (int i = 0; i < transactions; i++)
+  {
+    uint16_t model_number;
+    uint8_t error;
+    if (packet_handler->ping(port, DXL_ID, &model_number, &error) == COMM_SUCCESS)
+      success++;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &wall_end);
+  getrusage(RUSAGE_THREAD, &usage_end);
+  port->closePort();
+
+  printf("%-10s success %d/%d  wall %.0f us/transaction  cpu %.0f us/transaction\n", name, success, transactions,
+         getElapsedUs(wall_start, wall_end) / transactions,
+         (getCpuUs(usage_end) - getCpuUs(usage_start)) / transactions);
+}
+
+int main(int argc, char **argv)
+{
+  int transactions = (argc > 1) ? atoi(argv[1]) : 300;
+  int return_delay = (argc > 2) ? atoi(argv[2]) : 2000;
+
+  int master_fd, slave_fd;
+  char slave_name[64];
+  struct termios raw;
+  memset(&raw, 0, sizeof(raw));
+  cfmakeraw(&raw);
+  if (openpty(&master_fd, &slave_fd, slave_name, &raw, NULL) < 0)
+  {
+    perror("openpty");
+    return 1;
+  }
+  fcntl(master_fd, F_SETFL, O_NONBLOCK);   // the responder checks responder_keep_alive between reads
+
+  std::thread responder_thread(responder, master_fd, return_delay);
+
+  PortHandlerLinux wait_port(slave_name);
+  PollingPortHandler polling_port(slave_name);
+  runBenchmark("waitPort", &wait_port, transactions);
+  runBenchmark("polling", &polling_port, transactions);
+
+  responder_keep_alive = false;
+  responder_thread.join();
+  close(slave_fd);
+  close(master_fd);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_CRC16_H_
+#define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_CRC16_H_
+
+#ifdef __linux__
+#define WINDECLSPEC
+#elif defined(_WIN32) || defined(_WIN64)
+#ifdef WINDLLEXPORT
+#define WINDECLSPEC __declspec(dllexport)
+#else
+#define WINDECLSPEC __declspec(dllimport)
+#endif
+#endif
+
+#include <stdint.h>
+
+namespace dynamixel
+{
+
+/*
+ * CRC-16 of protocol 2.0 packets (polynomial 0x8005, initial value 0, not reflected)
+ * Tables are generated at compile time. Blocks of 8 bytes are processed with 8 tables
+ * (slicing-by-8), the remaining bytes one at a time.
+ *
+ * Incremental use : crc.add() on each received chunk, crc.get() when the last byte is received
+ */
+class WINDECLSPEC Crc16
+{
+ private:
+  uint16_t  crc_;
+
+ public:
+  static uint16_t update(uint16_t crc_accum, const uint8_t *data, uint32_t length);
+
+  Crc16() : crc_(0) { }
+
+  void      reset()                                 { crc_ = 0; }
+  void      add(const uint8_t *data, uint32_t length) { crc_ = update(crc_, data, length); }
+  uint16_t  get()                                   { return crc_; }
+};
+
+}
+
+
+#endif /* DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_CRC16_H_ */
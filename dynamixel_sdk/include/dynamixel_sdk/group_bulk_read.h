@@ -34,7 +34,6 @@
 #define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_GROUPBULKREAD_H_
 
 
-#include <map>
 #include <vector>
 #include "dynamixel_sdk/port_handler.h"
 #include "dynamixel_sdk/packet_handler.h"
@@ -48,15 +47,23 @@ class WINDECLSPEC GroupBulkRead
   PortHandler    *port_;
   PacketHandler  *ph_;
 
+  // flat storage : allocated when the id list changes, reused by every txRxPacket()
   std::vector<uint8_t>            id_list_;
-  std::map<uint8_t, uint16_t>     address_list_;  // <id, start_address>
-  std::map<uint8_t, uint16_t>     length_list_;   // <id, data_length>
-  std::map<uint8_t, uint8_t *>    data_list_;     // <id, data>
+  int16_t                         id_index_[256]; // <id, index in id_list_> (-1 : not added)
+  std::vector<uint16_t>           address_list_;  // start_address of id_list_[i]
+  std::vector<uint16_t>           length_list_;   // data_length of id_list_[i]
+  std::vector<uint16_t>           offset_list_;   // data of id_list_[i] at data_list_[offset_list_[i]]
+  std::vector<uint8_t>            data_list_;     // (if not read in place)
+  std::vector<const uint8_t *>    data_ptr_list_; // data of id_list_[i] : in the port receive buffer, or in data_list_
 
   bool            last_result_;
   bool            is_param_changed_;
+  bool            fast_read_;     // Fast Bulk Read instruction : all ids answer in one status packet
+  int             failed_index_;  // index in id_list_ of the status packet that failed (-1 : none or unknown)
 
-  uint8_t        *param_;
+  std::vector<uint8_t>            param_;
+  std::vector<uint8_t>            txpacket_;
+  std::vector<uint8_t>            rxpacket_;
 
   void    makeParam();
 
@@ -67,6 +74,15 @@ class WINDECLSPEC GroupBulkRead
   PortHandler     *getPortHandler()   { return port_; }
   PacketHandler   *getPacketHandler() { return ph_; }
 
+  const std::vector<uint8_t> &getIdList() { return id_list_; }
+
+  // all ids must support the Fast Bulk Read instruction (protocol 2.0 only)
+  void            setFastRead(bool fast_read) { fast_read_ = fast_read; }
+  bool            getFastRead()       { return fast_read_; }
+
+  // id whose status packet made the last rxPacket() fail, -1 if none or not known (tx error, whole fast read packet)
+  int             getFailedId()       { return failed_index_ < 0 ? -1 : id_list_[failed_index_]; }
+
   bool    addParam    (uint8_t id, uint16_t start_address, uint16_t data_length);
   void    removeParam (uint8_t id);
   void    clearParam  ();
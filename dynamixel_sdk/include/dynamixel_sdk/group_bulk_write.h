@@ -34,7 +34,6 @@
 #define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_GROUPBULKWRITE_H_
 
 
-#include <map>
 #include <vector>
 #include "dynamixel_sdk/port_handler.h"
 #include "dynamixel_sdk/packet_handler.h"
@@ -48,17 +47,18 @@ class WINDECLSPEC GroupBulkWrite
   PortHandler    *port_;
   PacketHandler  *ph_;
 
+  // flat storage : the param_ block of each id is written in place, reused by every txPacket()
   std::vector<uint8_t>            id_list_;
-  std::map<uint8_t, uint16_t>     address_list_;  // <id, start_address>
-  std::map<uint8_t, uint16_t>     length_list_;   // <id, data_length>
-  std::map<uint8_t, uint8_t *>    data_list_;     // <id, data>
+  int16_t                         id_index_[256]; // <id, index in id_list_> (-1 : not added)
+  std::vector<uint16_t>           offset_list_;   // param_ block of id_list_[i] : ID ADDR_L ADDR_H LEN_L LEN_H DATA...
 
   bool            is_param_changed_;
 
-  uint8_t        *param_;
-  uint16_t        param_length_;
+  std::vector<uint8_t>            param_;
+  std::vector<uint8_t>            txpacket_;
 
   void    makeParam();
+  void    setParam    (int index, uint16_t start_address, uint16_t data_length, uint8_t *data);
 
  public:
   GroupBulkWrite(PortHandler *port, PacketHandler *ph);
@@ -67,6 +67,8 @@ class WINDECLSPEC GroupBulkWrite
   PortHandler     *getPortHandler()   { return port_; }
   PacketHandler   *getPacketHandler() { return ph_; }
 
+  const std::vector<uint8_t> &getIdList() { return id_list_; }
+
   bool    addParam    (uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data);
   void    removeParam (uint8_t id);
   bool    changeParam (uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data);
@@ -34,7 +34,6 @@
 #define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_GROUPSYNCWRITE_H_
 
 
-#include <map>
 #include <vector>
 #include "dynamixel_sdk/port_handler.h"
 #include "dynamixel_sdk/packet_handler.h"
@@ -48,12 +47,15 @@ class WINDECLSPEC GroupSyncWrite
   PortHandler    *port_;
   PacketHandler  *ph_;
 
+  // flat storage : allocated when the id list changes, reused by every txPacket()
   std::vector<uint8_t>            id_list_;
-  std::map<uint8_t, uint8_t* >    data_list_; // <id, data>
+  int16_t                         id_index_[256]; // <id, index in id_list_> (-1 : not added)
+  std::vector<uint8_t>            data_list_;     // data of id_list_[i] at i * data_length_
 
   bool            is_param_changed_;
 
-  uint8_t        *param_;
+  std::vector<uint8_t>            param_;
+  std::vector<uint8_t>            txpacket_;
   uint16_t        start_address_;
   uint16_t        data_length_;
 
@@ -66,6 +68,10 @@ class WINDECLSPEC GroupSyncWrite
   PortHandler     *getPortHandler()   { return port_; }
   PacketHandler   *getPacketHandler() { return ph_; }
 
+  uint16_t        getStartAddress()   { return start_address_; }
+  uint16_t        getDataLength()     { return data_length_; }
+  const std::vector<uint8_t> &getIdList() { return id_list_; }
+
   bool    addParam    (uint8_t id, uint8_t *data);
   void    removeParam (uint8_t id);
   bool    changeParam (uint8_t id, uint8_t *data);
@@ -41,6 +41,9 @@
 #define BROADCAST_ID        0xFE    // 254
 #define MAX_ID              0xFC    // 252
 
+// size of a caller-provided packet buffer (tx or rx), enough for any protocol 2.0 packet
+#define DXL_PACKET_BUFFER_LEN   (4*1024)
+
 /* Macro for Control Table Value */
 #define DXL_MAKEWORD(a, b)  ((unsigned short)(((unsigned char)(((unsigned long)(a)) & 0xff)) | ((unsigned short)((unsigned char)(((unsigned long)(b)) & 0xff))) << 8))
 #define DXL_MAKEDWORD(a, b) ((unsigned int)(((unsigned short)(((unsigned long)(a)) & 0xffff)) | ((unsigned int)((unsigned short)(((unsigned long)(b)) & 0xffff))) << 16))
@@ -63,6 +66,8 @@
 #define INST_STATUS             85      // 0x55
 #define INST_SYNC_READ          130     // 0x82
 #define INST_BULK_WRITE         147     // 0x93
+#define INST_FAST_SYNC_READ     138     // 0x8A
+#define INST_FAST_BULK_READ     154     // 0x9A
 
 // Communication Result
 #define COMM_SUCCESS        0       // tx or rx packet communication success
@@ -150,6 +155,38 @@ class WINDECLSPEC PacketHandler
   // BulkReadTxRx -> GroupBulkRead class
 
   virtual int bulkWriteTxOnly (PortHandler *port, uint8_t *param, uint16_t param_length) = 0;
+
+  // Same as above with a caller-provided packet buffer (no allocation)
+  // txpacket : param_length + 14 + (param_length / 3) bytes (room for stuffing), rxpacket : DXL_PACKET_BUFFER_LEN bytes
+  // Default : fallback on the allocating version
+  virtual int readRx          (PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error, uint8_t *rxpacket)
+    { return readRx(port, id, length, data, error); }
+  virtual int syncReadTx      (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return syncReadTx(port, start_address, data_length, param, param_length); }
+  virtual int syncWriteTxOnly (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return syncWriteTxOnly(port, start_address, data_length, param, param_length); }
+  virtual int bulkReadTx      (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return bulkReadTx(port, param, param_length); }
+  virtual int bulkWriteTxOnly (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return bulkWriteTxOnly(port, param, param_length); }
+
+  // data of the status packet left in the port receive buffer (no copy), valid until the next instruction packet
+  // Default : COMM_NOT_AVAILABLE, use readRx() instead
+  virtual int readRxView      (PortHandler *port, uint8_t id, uint16_t length, const uint8_t **data, uint8_t *error = 0)
+    { return COMM_NOT_AVAILABLE; }
+
+  // Fast Sync Read / Fast Bulk Read : all devices answer in one status packet
+  // (same params as syncReadTx / bulkReadTx, caller-provided txpacket)
+  // Default : COMM_NOT_AVAILABLE, use syncReadTx / bulkReadTx instead
+  virtual int fastSyncReadTx  (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return COMM_NOT_AVAILABLE; }
+  virtual int fastBulkReadTx  (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+    { return COMM_NOT_AVAILABLE; }
+
+  // data : ERR1 ID1 DATA1 CRC1 ERR2 ID2 DATA2 CRC2 ... (CRCn is the packet CRC), left in the port receive buffer,
+  // valid until the next instruction packet
+  virtual int fastReadRxView  (PortHandler *port, const uint8_t **data, uint16_t *data_length)
+    { return COMM_NOT_AVAILABLE; }
 };
 
 }
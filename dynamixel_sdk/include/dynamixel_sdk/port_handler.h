@@ -44,6 +44,13 @@
 #endif
 
 #include <stdint.h>
+#include "dynamixel_sdk/status_packet_parser.h"
+
+// Half-duplex direction control
+#define DIRECTION_CONTROL_GPIO_SLEEP  0 // direction GPIO high, write, sleep estimated tx time, GPIO low
+#define DIRECTION_CONTROL_GPIO_DRAIN  1 // direction GPIO high, write, wait until uart is drained (tcdrain), GPIO low
+                                        // (opt-in : tcdrain may return up to a few ms after the last stop bit)
+#define DIRECTION_CONTROL_RS485       2 // RTS driven by the kernel serial driver (RS-485 mode), write does not wait
 
 namespace dynamixel
 {
@@ -56,6 +63,7 @@ class WINDECLSPEC PortHandler
   static PortHandler *getPortHandler(const char *port_name);
 
   bool   is_using_;
+  StatusPacketParser rx_parser_;    // received status packets (protocol 2.0)
 
   virtual ~PortHandler() { }
 
@@ -76,11 +84,35 @@ class WINDECLSPEC PortHandler
   virtual int     getBytesAvailable() = 0;
 
   virtual int     readPort(uint8_t *packet, int length) = 0;
+  virtual double  getReadTime() { return 0.0; }   // time of the last readPort() that returned bytes (ms), 0 if not recorded
   virtual int     writePort(uint8_t *packet, int length) = 0;
 
   virtual void    setPacketTimeout(uint16_t packet_length) = 0;
   virtual void    setPacketTimeout(double msec) = 0;
   virtual bool    isPacketTimeout() = 0;
+
+  // blocks until bytes can be read or the packet timeout expires, returns false on timeout
+  // (default : returns immediately, callers keep polling readPort())
+  virtual bool    waitPort() { return true; }
+
+  // returns false if the mode is not supported (previous or fallback mode is kept)
+  virtual bool    setDirectionControl(int mode) { return mode == DIRECTION_CONTROL_GPIO_SLEEP; }
+  virtual int     getDirectionControl() { return DIRECTION_CONTROL_GPIO_SLEEP; }
+
+  // time spent in writePort() before the bus is released for the status packet (ms),
+  // not measured with DIRECTION_CONTROL_RS485 (writePort() does not wait for the transmission)
+  virtual double  getTurnaroundTime() { return 0.0; }
+  virtual double  getMaxTurnaroundTime() { return 0.0; }
+  virtual void    resetTurnaroundTime() { }
+
+  // adaptive response timeout : response latency (return delay time + turnaround) learned per id
+  // from successful transactions. Timeout = status packet tx time + latency percentile + margin (ms)
+  virtual void    setAdaptiveTimeout(bool enable, double percentile, double margin_msec) { }
+  virtual void    setResponseTimeout(uint8_t id, uint16_t packet_length) { } // after setPacketTimeout(), for the status packet of id
+  // read_time : time of the read that completed the status packet (0 : now), the latency is learned only
+  // if learn is true (a packet completed by the same read as the previous one has no usable latency)
+  virtual void    setResponseReceived(uint8_t id, uint16_t packet_length, double read_time, bool learn) { }
+  virtual double  getResponseLatency(uint8_t id) { return -1.0; } // learned latency (ms), -1 if not learned yet
 };
 
 }
@@ -45,6 +45,10 @@
 
 #include "dynamixel_sdk/port_handler.h"
 
+#define RESPONSE_LATENCY_SAMPLES        32  // last successful responses kept per id
+#define RESPONSE_LATENCY_MIN_SAMPLES    8   // default timeout is used until this number of responses
+#define RESPONSE_TIMEOUT_MAX_FAIL       5   // consecutive timeouts before the learned latency of an id is reset
+
 namespace dynamixel
 {
 
@@ -59,7 +63,25 @@ class PortHandlerLinux : public PortHandler
   double  packet_timeout_;
   double  tx_time_per_byte;
 
+  int     direction_control_;
+  double  turnaround_time_;
+  double  max_turnaround_time_;
+
+  bool    adaptive_timeout_;
+  double  timeout_percentile_;
+  double  timeout_margin_;
+  double  response_start_time_;   // end of tx, or end of previous status packet (sync/bulk read)
+  double  read_time_;             // time of the last read that returned bytes (adaptive timeout only)
+  int     response_id_;           // id of the awaited status packet, -1 if unknown
+  float   response_latency_samples_[256][RESPONSE_LATENCY_SAMPLES];
+  uint8_t response_latency_count_[256];
+  uint8_t response_latency_index_[256];
+  uint8_t response_timeout_count_[256];
+  double  response_latency_[256];
+
   bool    setupPort(const int cflag_baud);
+  bool    applyDirectionControl();
+  void    resetResponseLatency(uint8_t id);
   bool    setCustomBaudrate(int speed);
   int     getCFlagBaud(const int baudrate);
 
@@ -87,11 +109,25 @@ class PortHandlerLinux : public PortHandler
   int     getBytesAvailable();
 
   int     readPort(uint8_t *packet, int length);
+  double  getReadTime();
   int     writePort(uint8_t *packet, int length);
 
   void    setPacketTimeout(uint16_t packet_length);
   void    setPacketTimeout(double msec);
   bool    isPacketTimeout();
+  bool    waitPort();
+
+  bool    setDirectionControl(int mode);
+  int     getDirectionControl();
+
+  double  getTurnaroundTime();
+  double  getMaxTurnaroundTime();
+  void    resetTurnaroundTime();
+
+  void    setAdaptiveTimeout(bool enable, double percentile, double margin_msec);
+  void    setResponseTimeout(uint8_t id, uint16_t packet_length);
+  void    setResponseReceived(uint8_t id, uint16_t packet_length, double read_time, bool learn);
+  double  getResponseLatency(uint8_t id);
 };
 
 }
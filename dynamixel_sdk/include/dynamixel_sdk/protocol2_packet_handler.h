@@ -49,6 +49,7 @@ class WINDECLSPEC Protocol2PacketHandler : public PacketHandler
   uint16_t    updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size);
   void        addStuffing(uint8_t *packet);
   void        removeStuffing(uint8_t *packet);
+  int         receivePacket(PortHandler *port, uint8_t **packet);
 
  public:
   static Protocol2PacketHandler *getInstance() { return unique_instance_; }
@@ -120,6 +121,20 @@ class WINDECLSPEC Protocol2PacketHandler : public PacketHandler
 
   // param : ID1 START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H DATA0 DATA1 ... DATAn ID2 START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H DATA0 DATA1 ... DATAn
   int bulkWriteTxOnly (PortHandler *port, uint8_t *param, uint16_t param_length);
+
+  // caller-provided packet buffers (see PacketHandler)
+  int readRx          (PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error, uint8_t *rxpacket);
+  int syncReadTx      (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+  int syncWriteTxOnly (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+  int bulkReadTx      (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+  int bulkWriteTxOnly (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+
+  int readRxView      (PortHandler *port, uint8_t id, uint16_t length, const uint8_t **data, uint8_t *error = 0);
+
+  // param : same as syncReadTx / bulkReadTx
+  int fastSyncReadTx  (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+  int fastBulkReadTx  (PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket);
+  int fastReadRxView  (PortHandler *port, const uint8_t **data, uint16_t *data_length);
 };
 
 }
@@ -0,0 +1,111 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_STATUSPACKETPARSER_H_
+#define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_STATUSPACKETPARSER_H_
+
+#ifdef __linux__
+#define WINDECLSPEC
+#elif defined(_WIN32) || defined(_WIN64)
+#ifdef WINDLLEXPORT
+#define WINDECLSPEC __declspec(dllexport)
+#else
+#define WINDECLSPEC __declspec(dllimport)
+#endif
+#endif
+
+#include <stdint.h>
+#include "dynamixel_sdk/crc16.h"
+
+#define STATUS_PACKET_BUFFER_LEN    (4*1024)
+#define STATUS_PACKET_MAX_READS     32      // reads timestamped per instruction packet, the last one is extended when full
+
+namespace dynamixel
+{
+
+/*
+ * Receive buffer of the protocol 2.0 status packets
+ * - bytes are appended as they are read from the port (several status packets per read in sync/bulk read)
+ * - the header FF FF FD 00 is searched with memchr, garbage before a header is dropped by moving head_
+ * - the CRC of a packet is computed as its bytes are received
+ * - packets are returned as pointers into the buffer (no copy), valid until clear()
+ * The buffer is cleared before each instruction packet, so a whole sync/bulk read response
+ * is stored without moving bytes. Bytes are moved to the front only if the end of the buffer
+ * is reached and no packet has been returned since clear().
+ * The end offset and time of each read are kept, so a packet is timed by the read that completed it
+ * (and not by the time it is parsed, which can be much later in a sync/bulk read).
+ */
+class WINDECLSPEC StatusPacketParser
+{
+ private:
+  uint8_t   buffer_[STATUS_PACKET_BUFFER_LEN];
+  uint16_t  head_;          // first byte not parsed yet
+  uint16_t  tail_;          // end of received bytes
+  bool      packet_given_;  // a returned packet points into buffer_ : bytes can't be moved
+
+  Crc16     crc_;
+  int       crc_start_;     // first byte of the packet in crc_ (-1 : none)
+  uint16_t  crc_end_;       // bytes before crc_end_ are in crc_
+
+  uint16_t  read_end_[STATUS_PACKET_MAX_READS];   // end offset of the bytes of each read
+  double    read_time_[STATUS_PACKET_MAX_READS];  // time of each read (ms)
+  int       read_count_;
+  int       packet_read_;       // read that completed the last found packet
+  int       last_packet_read_;  // read that completed the last consumed packet (-1 : none)
+  bool      packet_first_of_read_;
+
+ public:
+  StatusPacketParser() : head_(0), tail_(0), packet_given_(false), crc_start_(-1), crc_end_(0),
+    read_count_(0), packet_read_(-1), last_packet_read_(-1), packet_first_of_read_(false) { }
+
+  void      clear() { head_ = 0; tail_ = 0; packet_given_ = false; crc_start_ = -1; read_count_ = 0; packet_read_ = -1; last_packet_read_ = -1; }
+
+  uint8_t  *getFreeSpace();
+  uint16_t  getFreeSpaceLength();
+  void      addBytes(uint16_t length, double read_time = 0.0);   // after writing length bytes at getFreeSpace()
+
+  uint16_t  getAvailableLength() { return tail_ - head_; }
+
+  // COMM_SUCCESS : *packet is a complete and valid status packet, call consumePacket() once used
+  // COMM_RX_WAITING : more bytes are needed
+  // COMM_RX_CORRUPT : wrong CRC, the packet is skipped
+  int       findPacket(uint8_t **packet, uint16_t *packet_length);
+  void      consumePacket(uint16_t packet_length);
+
+  // for the packet returned by findPacket() : time of the read that completed it,
+  // and whether no previous packet was completed by the same read
+  double    getPacketReadTime() { return (packet_read_ < 0) ? 0.0 : read_time_[packet_read_]; }
+  bool      isFirstPacketOfRead() { return packet_first_of_read_; }
+};
+
+}
+
+
+#endif /* DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_STATUSPACKETPARSER_H_ */
@@ -0,0 +1,87 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/*
+ * LTTng-UST event definitions for provider "dynamixel_sdk"
+ * - do not include directly, use DXL_TRACEPOINT() from tracing.h
+ * - probes are created in src/tp_call.c
+ */
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER dynamixel_sdk
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "dynamixel_sdk/tp_call.h"
+
+#if !defined(DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_TP_CALL_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_TP_CALL_H_
+
+#include <lttng/tracepoint.h>
+#include <stdint.h>
+
+// instruction packet written to the port (length : bytes written, with header and CRC)
+TRACEPOINT_EVENT(
+  dynamixel_sdk,
+  instruction_packet,
+  TP_ARGS(
+    uint8_t, id_arg,
+    uint8_t, instruction_arg,
+    uint16_t, length_arg,
+    int, result_arg
+  ),
+  TP_FIELDS(
+    ctf_integer(uint8_t, id, id_arg)
+    ctf_integer_hex(uint8_t, instruction, instruction_arg)
+    ctf_integer(uint16_t, length, length_arg)
+    ctf_integer(int, result, result_arg)
+  )
+)
+
+// status packet received (or receive error), id / error / length are 0 if result is not COMM_SUCCESS
+TRACEPOINT_EVENT(
+  dynamixel_sdk,
+  status_packet,
+  TP_ARGS(
+    uint8_t, id_arg,
+    uint8_t, error_arg,
+    uint16_t, length_arg,
+    int, result_arg
+  ),
+  TP_FIELDS(
+    ctf_integer(uint8_t, id, id_arg)
+    ctf_integer_hex(uint8_t, error, error_arg)
+    ctf_integer(uint16_t, length, length_arg)
+    ctf_integer(int, result, result_arg)
+  )
+)
+
+#endif
+
+#include <lttng/tracepoint-event.h>
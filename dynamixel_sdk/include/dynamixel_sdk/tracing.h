@@ -0,0 +1,48 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_TRACING_H_
+#define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_TRACING_H_
+
+/*
+ * LTTng tracepoints of the protocol 2.0 packets (provider "dynamixel_sdk")
+ * Built with -DDYNAMIXEL_SDK_TRACING=ON only, otherwise DXL_TRACEPOINT() expands to nothing
+ * and its arguments are not evaluated. Events are declared in tp_call.h.
+ */
+#ifdef DYNAMIXEL_SDK_TRACING_ENABLED
+#include "dynamixel_sdk/tp_call.h"
+#define DXL_TRACEPOINT(event_name, ...) \
+  tracepoint(dynamixel_sdk, event_name, __VA_ARGS__)
+#else
+#define DXL_TRACEPOINT(event_name, ...) \
+  ((void)0)
+#endif
+
+#endif /* DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_TRACING_H_ */
@@ -0,0 +1,93 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#endif
+
+#include "dynamixel_sdk/crc16.h"
+
+#define CRC16_POLYNOMIAL    0x8005
+#define CRC16_SLICES        8
+
+using namespace dynamixel;
+
+namespace
+{
+
+// table[0][b] : CRC of byte b, table[k][b] : CRC of byte b followed by k zero bytes
+struct Crc16Table
+{
+  uint16_t table[CRC16_SLICES][256];
+
+  constexpr Crc16Table() : table()
+  {
+    for (int b = 0; b < 256; b++)
+    {
+      uint16_t crc = (uint16_t)(b << 8);
+      for (int bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLYNOMIAL) : (uint16_t)(crc << 1);
+      table[0][b] = crc;
+    }
+    for (int k = 1; k < CRC16_SLICES; k++)
+    {
+      for (int b = 0; b < 256; b++)
+        table[k][b] = (uint16_t)(table[k-1][b] << 8) ^ table[0][table[k-1][b] >> 8];
+    }
+  }
+};
+
+constexpr Crc16Table crc16_table;
+
+static_assert(crc16_table.table[0][1] == 0x8005 && crc16_table.table[0][255] == 0x0202, "wrong CRC-16 table");
+
+}
+
+uint16_t Crc16::update(uint16_t crc_accum, const uint8_t *data, uint32_t length)
+{
+  const uint16_t (*t)[256] = crc16_table.table;
+
+  // slicing-by-8 : the 16 bit crc is combined with the first 2 bytes of each block
+  while (length >= CRC16_SLICES)
+  {
+    crc_accum = t[7][data[0] ^ (crc_accum >> 8)] ^ t[6][data[1] ^ (crc_accum & 0xFF)] ^
+                t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data   += CRC16_SLICES;
+    length -= CRC16_SLICES;
+  }
+
+  while (length > 0)
+  {
+    crc_accum = (uint16_t)(crc_accum << 8) ^ t[0][(uint8_t)((crc_accum >> 8) ^ *data++)];
+    length--;
+  }
+
+  return crc_accum;
+}
@@ -45,8 +45,12 @@ GroupBulkRead::GroupBulkRead(PortHandler *port, PacketHandler *ph)
     ph_(ph),
     last_result_(false),
     is_param_changed_(false),
-    param_(0)
+    fast_read_(false),
+    failed_index_(-1)
 {
+  for (int i = 0; i < 256; i++)
+    id_index_[i] = -1;
+  rxpacket_.resize(DXL_PACKET_BUFFER_LEN);
   clearParam();
 }
 
@@ -55,18 +59,15 @@ void GroupBulkRead::makeParam()
   if (id_list_.size() == 0)
     return;
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
-
   if (ph_->getProtocolVersion() == 1.0)
   {
-    param_ = new uint8_t[id_list_.size() * 3];  // ID(1) + ADDR(1) + LENGTH(1)
+    param_.resize(id_list_.size() * 3);  // ID(1) + ADDR(1) + LENGTH(1)
   }
   else    // 2.0
   {
-    param_ = new uint8_t[id_list_.size() * 5];  // ID(1) + ADDR(2) + LENGTH(2)
+    param_.resize(id_list_.size() * 5);  // ID(1) + ADDR(2) + LENGTH(2)
   }
+  txpacket_.resize(param_.size() + 10 + (param_.size() / 3));
 
   int idx = 0;
   for (unsigned int i = 0; i < id_list_.size(); i++)
@@ -74,30 +75,35 @@ void GroupBulkRead::makeParam()
     uint8_t id = id_list_[i];
     if (ph_->getProtocolVersion() == 1.0)
     {
-      param_[idx++] = (uint8_t)length_list_[id];    // LEN
+      param_[idx++] = (uint8_t)length_list_[i];     // LEN
       param_[idx++] = id;                           // ID
-      param_[idx++] = (uint8_t)address_list_[id];   // ADDR
+      param_[idx++] = (uint8_t)address_list_[i];    // ADDR
     }
     else    // 2.0
     {
       param_[idx++] = id;                               // ID
-      param_[idx++] = DXL_LOBYTE(address_list_[id]);    // ADDR_L
-      param_[idx++] = DXL_HIBYTE(address_list_[id]);    // ADDR_H
-      param_[idx++] = DXL_LOBYTE(length_list_[id]);     // LEN_L
-      param_[idx++] = DXL_HIBYTE(length_list_[id]);     // LEN_H
+      param_[idx++] = DXL_LOBYTE(address_list_[i]);     // ADDR_L
+      param_[idx++] = DXL_HIBYTE(address_list_[i]);     // ADDR_H
+      param_[idx++] = DXL_LOBYTE(length_list_[i]);      // LEN_L
+      param_[idx++] = DXL_HIBYTE(length_list_[i]);      // LEN_H
     }
   }
+
+  is_param_changed_ = false;
 }
 
 bool GroupBulkRead::addParam(uint8_t id, uint16_t start_address, uint16_t data_length)
 {
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (id_index_[id] >= 0)   // id already exist
     return false;
 
+  id_index_[id] = id_list_.size();
   id_list_.push_back(id);
-  length_list_[id]    = data_length;
-  address_list_[id]   = start_address;
-  data_list_[id]      = new uint8_t[data_length];
+  address_list_.push_back(start_address);
+  length_list_.push_back(data_length);
+  offset_list_.push_back(data_list_.size());
+  data_list_.resize(data_list_.size() + data_length);
+  data_ptr_list_.push_back(0);
 
   is_param_changed_   = true;
   return true;
@@ -105,15 +111,23 @@ bool GroupBulkRead::addParam(uint8_t id, uint16_t start_address, uint16_t data_l
 
 void GroupBulkRead::removeParam(uint8_t id)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  address_list_.erase(id);
-  length_list_.erase(id);
-  delete[] data_list_[id];
-  data_list_.erase(id);
+  uint16_t length = length_list_[index];
+  data_list_.erase(data_list_.begin() + offset_list_[index], data_list_.begin() + offset_list_[index] + length);
+  id_list_.erase(id_list_.begin() + index);
+  address_list_.erase(address_list_.begin() + index);
+  length_list_.erase(length_list_.begin() + index);
+  offset_list_.erase(offset_list_.begin() + index);
+  data_ptr_list_.erase(data_ptr_list_.begin() + index);
+  id_index_[id] = -1;
+  for (unsigned int i = index; i < id_list_.size(); i++)
+  {
+    id_index_[id_list_[i]] = i;
+    offset_list_[i] -= length;
+  }
 
   is_param_changed_   = true;
 }
@@ -124,15 +138,17 @@ void GroupBulkRead::clearParam()
     return;
 
   for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
+    id_index_[id_list_[i]] = -1;
 
+  // keep capacity : no allocation when the same ids are added again
   id_list_.clear();
   address_list_.clear();
   length_list_.clear();
+  offset_list_.clear();
   data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  data_ptr_list_.clear();
+  param_.clear();
+  is_param_changed_ = true;
 }
 
 int GroupBulkRead::txPacket()
@@ -140,17 +156,13 @@ int GroupBulkRead::txPacket()
   if (id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
+  if (is_param_changed_ == true || param_.size() == 0)
     makeParam();
 
-  if (ph_->getProtocolVersion() == 1.0)
-  {
-    return ph_->bulkReadTx(port_, param_, id_list_.size() * 3);
-  }
-  else    // 2.0
-  {
-    return ph_->bulkReadTx(port_, param_, id_list_.size() * 5);
-  }
+  if (fast_read_)
+    return ph_->fastBulkReadTx(port_, &param_[0], param_.size(), &txpacket_[0]);
+
+  return ph_->bulkReadTx(port_, &param_[0], param_.size(), &txpacket_[0]);
 }
 
 int GroupBulkRead::rxPacket()
@@ -159,17 +171,55 @@ int GroupBulkRead::rxPacket()
   int result          = COMM_RX_FAIL;
 
   last_result_ = false;
+  failed_index_ = -1;
 
   if (cnt == 0)
     return COMM_NOT_AVAILABLE;
 
+  if (fast_read_)
+  {
+    // one status packet : ERR ID DATA CRC16 for each id, in the order of the instruction packet
+    const uint8_t *data = 0;
+    uint16_t length = 0;
+
+    result = ph_->fastReadRxView(port_, &data, &length);
+    if (result != COMM_SUCCESS)
+      return result;
+
+    int offset = 0;
+    for (int i = 0; i < cnt; i++)
+    {
+      if (offset + length_list_[i] + 4 > length || data[offset + 1] != id_list_[i])
+      {
+        failed_index_ = i;
+        return COMM_RX_CORRUPT;
+      }
+      data_ptr_list_[i] = data + offset + 2;
+      offset += length_list_[i] + 4;
+    }
+    if (offset != length)
+      return COMM_RX_CORRUPT;
+
+    last_result_ = true;
+    return result;
+  }
+
   for (int i = 0; i < cnt; i++)
   {
     uint8_t id = id_list_[i];
 
-    result = ph_->readRx(port_, id, length_list_[id], data_list_[id]);
+    // data is decoded where it was received, until the next instruction packet
+    result = ph_->readRxView(port_, id, length_list_[i], &data_ptr_list_[i], 0);
+    if (result == COMM_NOT_AVAILABLE)
+    {
+      result = ph_->readRx(port_, id, length_list_[i], &data_list_[offset_list_[i]], 0, &rxpacket_[0]);
+      data_ptr_list_[i] = &data_list_[offset_list_[i]];
+    }
     if (result != COMM_SUCCESS)
+    {
+      failed_index_ = i;
       return result;
+    }
   }
 
   if (result == COMM_SUCCESS)
@@ -182,6 +232,7 @@ int GroupBulkRead::txRxPacket()
 {
   int result         = COMM_TX_FAIL;
 
+  failed_index_ = -1;
   result = txPacket();
   if (result != COMM_SUCCESS)
     return result;
@@ -193,12 +244,12 @@ bool GroupBulkRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_leng
 {
   uint16_t start_addr;
 
-  if (last_result_ == false || data_list_.find(id) == data_list_.end())
+  if (last_result_ == false || id_index_[id] < 0)
     return false;
 
-  start_addr = address_list_[id];
+  start_addr = address_list_[id_index_[id]];
 
-  if (address < start_addr || start_addr + length_list_[id] - data_length < address)
+  if (address < start_addr || start_addr + length_list_[id_index_[id]] - data_length < address)
     return false;
 
   return true;
@@ -209,19 +260,19 @@ uint32_t GroupBulkRead::getData(uint8_t id, uint16_t address, uint16_t data_leng
   if (isAvailable(id, address, data_length) == false)
     return 0;
 
-  uint16_t start_addr = address_list_[id];
+  int index = id_index_[id];
+  const uint8_t *data = data_ptr_list_[index] + (address - address_list_[index]);
 
   switch(data_length)
   {
     case 1:
-      return data_list_[id][address - start_addr];
+      return data[0];
 
     case 2:
-      return DXL_MAKEWORD(data_list_[id][address - start_addr], data_list_[id][address - start_addr + 1]);
+      return DXL_MAKEWORD(data[0], data[1]);
 
     case 4:
-      return DXL_MAKEDWORD(DXL_MAKEWORD(data_list_[id][address - start_addr + 0], data_list_[id][address - start_addr + 1]),
-                           DXL_MAKEWORD(data_list_[id][address - start_addr + 2], data_list_[id][address - start_addr + 3]));
+      return DXL_MAKEDWORD(DXL_MAKEWORD(data[0], data[1]), DXL_MAKEWORD(data[2], data[3]));
 
     default:
       return 0;
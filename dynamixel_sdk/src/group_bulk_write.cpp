@@ -42,10 +42,10 @@ using namespace dynamixel;
 GroupBulkWrite::GroupBulkWrite(PortHandler *port, PacketHandler *ph)
   : port_(port),
     ph_(ph),
-    is_param_changed_(false),
-    param_(0),
-    param_length_(0)
+    is_param_changed_(false)
 {
+  for (int i = 0; i < 256; i++)
+    id_index_[i] = -1;
   clearParam();
 }
 
@@ -54,31 +54,22 @@ void GroupBulkWrite::makeParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  txpacket_.resize(param_.size() + 10 + (param_.size() / 3));
 
-  param_length_ = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    param_length_ += 1 + 2 + 2 + length_list_[id_list_[i]];
+  is_param_changed_ = false;
+}
 
-  param_ = new uint8_t[param_length_];
+void GroupBulkWrite::setParam(int index, uint16_t start_address, uint16_t data_length, uint8_t *data)
+{
+  int idx = offset_list_[index];
 
-  int idx = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    uint8_t id = id_list_[i];
-    if (data_list_[id] == 0)
-      return;
-
-    param_[idx++] = id;
-    param_[idx++] = DXL_LOBYTE(address_list_[id]);
-    param_[idx++] = DXL_HIBYTE(address_list_[id]);
-    param_[idx++] = DXL_LOBYTE(length_list_[id]);
-    param_[idx++] = DXL_HIBYTE(length_list_[id]);
-    for (int c = 0; c < length_list_[id]; c++)
-      param_[idx++] = (data_list_[id])[c];
-  }
+  param_[idx++] = id_list_[index];
+  param_[idx++] = DXL_LOBYTE(start_address);
+  param_[idx++] = DXL_HIBYTE(start_address);
+  param_[idx++] = DXL_LOBYTE(data_length);
+  param_[idx++] = DXL_HIBYTE(data_length);
+  for (int c = 0; c < data_length; c++)
+    param_[idx++] = data[c];
 }
 
 bool GroupBulkWrite::addParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
@@ -86,78 +77,86 @@ bool GroupBulkWrite::addParam(uint8_t id, uint16_t start_address, uint16_t data_
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (id_index_[id] >= 0)   // id already exist
     return false;
 
+  id_index_[id] = id_list_.size();
   id_list_.push_back(id);
-  address_list_[id]   = start_address;
-  length_list_[id]    = data_length;
-  data_list_[id]      = new uint8_t[data_length];
-  for (int c = 0; c < data_length; c++)
-    data_list_[id][c] = data[c];
+  offset_list_.push_back(param_.size());
+  param_.resize(param_.size() + 1 + 2 + 2 + data_length);  // ID(1) + ADDR(2) + LENGTH(2) + DATA(data_length)
+  setParam(id_index_[id], start_address, data_length, data);
 
   is_param_changed_   = true;
   return true;
 }
+
 void GroupBulkWrite::removeParam(uint8_t id)
 {
   if (ph_->getProtocolVersion() == 1.0)
     return;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  address_list_.erase(id);
-  length_list_.erase(id);
-  delete[] data_list_[id];
-  data_list_.erase(id);
+  uint16_t offset = offset_list_[index];
+  uint16_t length = 1 + 2 + 2 + DXL_MAKEWORD(param_[offset + 3], param_[offset + 4]);
+  param_.erase(param_.begin() + offset, param_.begin() + offset + length);
+  id_list_.erase(id_list_.begin() + index);
+  offset_list_.erase(offset_list_.begin() + index);
+  id_index_[id] = -1;
+  for (unsigned int i = index; i < id_list_.size(); i++)
+  {
+    id_index_[id_list_[i]] = i;
+    offset_list_[i] -= length;
+  }
 
   is_param_changed_   = true;
 }
+
 bool GroupBulkWrite::changeParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
 {
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return false;
 
-  address_list_[id]   = start_address;
-  length_list_[id]    = data_length;
-  delete[] data_list_[id];
-  data_list_[id]      = new uint8_t[data_length];
-  for (int c = 0; c < data_length; c++)
-    data_list_[id][c] = data[c];
+  uint16_t offset = offset_list_[index];
+  if (DXL_MAKEWORD(param_[offset + 3], param_[offset + 4]) == data_length)
+  {
+    // in place : no allocation
+    setParam(index, start_address, data_length, data);
+    return true;
+  }
 
-  is_param_changed_   = true;
-  return true;
+  removeParam(id);
+  return addParam(id, start_address, data_length, data);
 }
+
 void GroupBulkWrite::clearParam()
 {
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
   for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
+    id_index_[id_list_[i]] = -1;
 
+  // keep capacity : no allocation when the same ids are added again
   id_list_.clear();
-  address_list_.clear();
-  length_list_.clear();
-  data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  offset_list_.clear();
+  param_.clear();
+  is_param_changed_ = true;
 }
+
 int GroupBulkWrite::txPacket()
 {
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
+  if (is_param_changed_ == true || txpacket_.size() == 0)
     makeParam();
 
-  return ph_->bulkWriteTxOnly(port_, param_, param_length_);
+  return ph_->bulkWriteTxOnly(port_, &param_[0], param_.size(), &txpacket_[0]);
 }
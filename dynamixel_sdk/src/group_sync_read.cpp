@@ -44,10 +44,15 @@ GroupSyncRead::GroupSyncRead(PortHandler *port, PacketHandler *ph, uint16_t star
     ph_(ph),
     last_result_(false),
     is_param_changed_(false),
-    param_(0),
+    fast_read_(false),
+    failed_index_(-1),
     start_address_(start_address),
     data_length_(data_length)
 {
+  for (int i = 0; i < 256; i++)
+    id_index_[i] = -1;
+  if (ph_->getProtocolVersion() != 1.0)
+    rxpacket_.resize(DXL_PACKET_BUFFER_LEN);
   clearParam();
 }
 
@@ -56,15 +61,10 @@ void GroupSyncRead::makeParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  param_.assign(id_list_.begin(), id_list_.end());  // ID(1)
+  txpacket_.resize(param_.size() + 14 + (param_.size() / 3));
 
-  param_ = new uint8_t[id_list_.size() * 1];  // ID(1)
-
-  int idx = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    param_[idx++] = id_list_[i];
+  is_param_changed_ = false;
 }
 
 bool GroupSyncRead::addParam(uint8_t id)
@@ -72,11 +72,13 @@ bool GroupSyncRead::addParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (id_index_[id] >= 0)   // id already exist
     return false;
 
+  id_index_[id] = id_list_.size();
   id_list_.push_back(id);
-  data_list_[id] = new uint8_t[data_length_];
+  data_list_.resize(id_list_.size() * data_length_);
+  data_ptr_list_.push_back(0);
 
   is_param_changed_   = true;
   return true;
@@ -86,13 +88,16 @@ void GroupSyncRead::removeParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  data_list_.erase(id);
+  id_list_.erase(id_list_.begin() + index);
+  data_list_.erase(data_list_.begin() + index * data_length_, data_list_.begin() + (index + 1) * data_length_);
+  data_ptr_list_.erase(data_ptr_list_.begin() + index);
+  id_index_[id] = -1;
+  for (unsigned int i = index; i < id_list_.size(); i++)
+    id_index_[id_list_[i]] = i;
 
   is_param_changed_   = true;
 }
@@ -102,13 +107,14 @@ void GroupSyncRead::clearParam()
     return;
 
   for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
+    id_index_[id_list_[i]] = -1;
 
+  // keep capacity : no allocation when the same number of ids is added again
   id_list_.clear();
   data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  data_ptr_list_.clear();
+  param_.clear();
+  is_param_changed_ = true;
 }
 
 int GroupSyncRead::txPacket()
@@ -116,15 +122,19 @@ int GroupSyncRead::txPacket()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
+  if (is_param_changed_ == true || param_.size() == 0)
     makeParam();
 
-  return ph_->syncReadTx(port_, start_address_, data_length_, param_, (uint16_t)id_list_.size() * 1);
+  if (fast_read_)
+    return ph_->fastSyncReadTx(port_, start_address_, data_length_, &param_[0], (uint16_t)id_list_.size() * 1, &txpacket_[0]);
+
+  return ph_->syncReadTx(port_, start_address_, data_length_, &param_[0], (uint16_t)id_list_.size() * 1, &txpacket_[0]);
 }
 
 int GroupSyncRead::rxPacket()
 {
   last_result_ = false;
+  failed_index_ = -1;
 
   if (ph_->getProtocolVersion() == 1.0)
     return COMM_NOT_AVAILABLE;
@@ -135,13 +145,49 @@ int GroupSyncRead::rxPacket()
   if (cnt == 0)
     return COMM_NOT_AVAILABLE;
 
+  if (fast_read_)
+  {
+    // one status packet : ERR ID DATA CRC16 for each id, in the order of the instruction packet
+    const uint8_t *data = 0;
+    uint16_t length = 0;
+
+    result = ph_->fastReadRxView(port_, &data, &length);
+    if (result != COMM_SUCCESS)
+      return result;
+    if (length != cnt * (data_length_ + 4))
+      return COMM_RX_CORRUPT;
+
+    for (int i = 0; i < cnt; i++)
+    {
+      const uint8_t *block = data + i * (data_length_ + 4);
+      if (block[1] != id_list_[i])
+      {
+        failed_index_ = i;
+        return COMM_RX_CORRUPT;
+      }
+      data_ptr_list_[i] = block + 2;
+    }
+
+    last_result_ = true;
+    return result;
+  }
+
   for (int i = 0; i < cnt; i++)
   {
     uint8_t id = id_list_[i];
 
-    result = ph_->readRx(port_, id, data_length_, data_list_[id]);
+    // data is decoded where it was received, until the next instruction packet
+    result = ph_->readRxView(port_, id, data_length_, &data_ptr_list_[i], 0);
+    if (result == COMM_NOT_AVAILABLE)
+    {
+      result = ph_->readRx(port_, id, data_length_, &data_list_[i * data_length_], 0, &rxpacket_[0]);
+      data_ptr_list_[i] = &data_list_[i * data_length_];
+    }
     if (result != COMM_SUCCESS)
+    {
+      failed_index_ = i;
       return result;
+    }
   }
 
   if (result == COMM_SUCCESS)
@@ -157,6 +203,7 @@ int GroupSyncRead::txRxPacket()
 
   int result         = COMM_TX_FAIL;
 
+  failed_index_ = -1;
   result = txPacket();
   if (result != COMM_SUCCESS)
     return result;
@@ -166,7 +213,7 @@ int GroupSyncRead::txRxPacket()
 
 bool GroupSyncRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_length)
 {
-  if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || data_list_.find(id) == data_list_.end())
+  if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || id_index_[id] < 0)
     return false;
 
   if (address < start_address_ || start_address_ + data_length_ - data_length < address)
@@ -180,17 +227,18 @@ uint32_t GroupSyncRead::getData(uint8_t id, uint16_t address, uint16_t data_leng
   if (isAvailable(id, address, data_length) == false)
     return 0;
 
+  const uint8_t *data = data_ptr_list_[id_index_[id]] + (address - start_address_);
+
   switch(data_length)
   {
     case 1:
-      return data_list_[id][address - start_address_];
+      return data[0];
 
     case 2:
-      return DXL_MAKEWORD(data_list_[id][address - start_address_], data_list_[id][address - start_address_ + 1]);
+      return DXL_MAKEWORD(data[0], data[1]);
 
     case 4:
-      return DXL_MAKEDWORD(DXL_MAKEWORD(data_list_[id][address - start_address_ + 0], data_list_[id][address - start_address_ + 1]),
-                 DXL_MAKEWORD(data_list_[id][address - start_address_ + 2], data_list_[id][address - start_address_ + 3]));
+      return DXL_MAKEDWORD(DXL_MAKEWORD(data[0], data[1]), DXL_MAKEWORD(data[2], data[3]));
 
     default:
       return 0;
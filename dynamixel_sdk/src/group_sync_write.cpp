@@ -43,10 +43,11 @@ GroupSyncWrite::GroupSyncWrite(PortHandler *port, PacketHandler *ph, uint16_t st
   : port_(port),
     ph_(ph),
     is_param_changed_(false),
-    param_(0),
     start_address_(start_address),
     data_length_(data_length)
 {
+  for (int i = 0; i < 256; i++)
+    id_index_[i] = -1;
   clearParam();
 }
 
@@ -54,34 +55,30 @@ void GroupSyncWrite::makeParam()
 {
   if (id_list_.size() == 0) return;
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
-
-  param_ = new uint8_t[id_list_.size() * (1 + data_length_)]; // ID(1) + DATA(data_length)
+  param_.resize(id_list_.size() * (1 + data_length_)); // ID(1) + DATA(data_length)
+  txpacket_.resize(param_.size() + 14 + (param_.size() / 3));
 
   int idx = 0;
   for (unsigned int i = 0; i < id_list_.size(); i++)
   {
-    uint8_t id = id_list_[i];
-    if (data_list_[id] == 0)
-      return;
-
-    param_[idx++] = id;
+    param_[idx++] = id_list_[i];
     for (int c = 0; c < data_length_; c++)
-      param_[idx++] = (data_list_[id])[c];
+      param_[idx++] = data_list_[i * data_length_ + c];
   }
+
+  is_param_changed_ = false;
 }
 
 bool GroupSyncWrite::addParam(uint8_t id, uint8_t *data)
 {
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (id_index_[id] >= 0)   // id already exist
     return false;
 
+  id_index_[id] = id_list_.size();
   id_list_.push_back(id);
-  data_list_[id]    = new uint8_t[data_length_];
+  data_list_.resize(id_list_.size() * data_length_);
   for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
+    data_list_[id_index_[id] * data_length_ + c] = data[c];
 
   is_param_changed_   = true;
   return true;
@@ -89,27 +86,28 @@ bool GroupSyncWrite::addParam(uint8_t id, uint8_t *data)
 
 void GroupSyncWrite::removeParam(uint8_t id)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  data_list_.erase(id);
+  id_list_.erase(id_list_.begin() + index);
+  data_list_.erase(data_list_.begin() + index * data_length_, data_list_.begin() + (index + 1) * data_length_);
+  id_index_[id] = -1;
+  for (unsigned int i = index; i < id_list_.size(); i++)
+    id_index_[id_list_[i]] = i;
 
   is_param_changed_   = true;
 }
 
 bool GroupSyncWrite::changeParam(uint8_t id, uint8_t *data)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int index = id_index_[id];
+  if (index < 0)    // NOT exist
     return false;
 
-  delete[] data_list_[id];
-  data_list_[id]    = new uint8_t[data_length_];
+  // in place : no allocation
   for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
+    data_list_[index * data_length_ + c] = data[c];
 
   is_param_changed_   = true;
   return true;
@@ -121,13 +119,13 @@ void GroupSyncWrite::clearParam()
     return;
 
   for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
+    id_index_[id_list_[i]] = -1;
 
+  // keep capacity : no allocation when the same number of ids is added again
   id_list_.clear();
   data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  param_.clear();
+  is_param_changed_ = true;
 }
 
 int GroupSyncWrite::txPacket()
@@ -135,8 +133,8 @@ int GroupSyncWrite::txPacket()
   if (id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
+  if (is_param_changed_ == true || param_.size() == 0)
     makeParam();
 
-  return ph_->syncWriteTxOnly(port_, start_address_, data_length_, param_, id_list_.size() * (1 + data_length_));
+  return ph_->syncWriteTxOnly(port_, start_address_, data_length_, &param_[0], id_list_.size() * (1 + data_length_), &txpacket_[0]);
 }
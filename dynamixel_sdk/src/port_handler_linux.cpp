@@ -40,7 +40,9 @@
 /* Author: zerom, Ryu Woon Jung (Leon) */
 
 #include <stdio.h>
+#include <math.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <string.h>
 #include <unistd.h>
 #include <termios.h>
@@ -48,6 +50,7 @@
 #include <sys/time.h>
 #include <sys/ioctl.h>
 #include <linux/serial.h>
+#include <algorithm>
 
 #include "dynamixel_sdk/port_handler_linux.h"
 
@@ -60,10 +63,21 @@ PortHandlerLinux::PortHandlerLinux(const char *port_name)
     baudrate_(DEFAULT_BAUDRATE_),
     packet_start_time_(0.0),
     packet_timeout_(0.0),
-    tx_time_per_byte(0.0)
+    tx_time_per_byte(0.0),
+    direction_control_(DIRECTION_CONTROL_GPIO_SLEEP),
+    turnaround_time_(0.0),
+    max_turnaround_time_(0.0),
+    adaptive_timeout_(false),
+    timeout_percentile_(0.99),
+    timeout_margin_(1.0),
+    response_start_time_(0.0),
+    read_time_(0.0),
+    response_id_(-1)
 {
   is_using_ = false;
   setPortName(port_name);
+  for (int id = 0; id < 256; id++)
+    resetResponseLatency(id);
 }
 
 #include <fcntl.h>
@@ -73,6 +87,7 @@ PortHandlerLinux::PortHandlerLinux(const char *port_name)
 #include <time.h>
 
 #define GPIO_HALF_DUPLEX_DIRECTION 17
+#define GPIO_HALF_DUPLEX_DIRECTION_RTS_ALT 7 // FSEL_ALT3 : GPIO 17 is UART0 RTS
 
 bool PortHandlerLinux::setupGpio()
 {
@@ -170,36 +185,146 @@ int PortHandlerLinux::getBytesAvailable()
 
 int PortHandlerLinux::readPort(uint8_t *packet, int length)
 {
-  return read(socket_fd_, packet, length);
+  int result = read(socket_fd_, packet, length);
+  if (result > 0 && adaptive_timeout_)
+    read_time_ = getCurrentTime();
+  return result;
+}
+
+double PortHandlerLinux::getReadTime()
+{
+  return adaptive_timeout_ ? read_time_ : 0.0;
 }
 
 int PortHandlerLinux::writePort(uint8_t *packet, int length)
 {
-  gpioHigh();
+  int write_result;
 
-  int write_result = write(socket_fd_, packet, length);
+  if (direction_control_ == DIRECTION_CONTROL_RS485)
+  {
+    // RTS is raised and dropped by the uart driver around the transmission. write() returns
+    // when bytes are queued, before they are sent : turnaround time is not measured
+    write_result = write(socket_fd_, packet, length);
+  }
+  else
+  {
+    double start_time = getCurrentTime();
+    gpioHigh();
+
+    write_result = write(socket_fd_, packet, length);
+
+    if (direction_control_ == DIRECTION_CONTROL_GPIO_DRAIN)
+    {
+      // returns when the last byte has left the uart (no estimate, no margin)
+      tcdrain(socket_fd_);
+    }
+    else
+    {
+      double time_to_wait_secs = (double)length / ((double)baudrate_ / 10.0);
+      struct timespec tim;
+      tim.tv_sec = 0;
+      tim.tv_nsec = (long) (time_to_wait_secs * 1000000000.0);
+      nanosleep(&tim, NULL);
+    }
+
+    gpioLow();
+
+    turnaround_time_ = getCurrentTime() - start_time;
+    if (turnaround_time_ > max_turnaround_time_)
+      max_turnaround_time_ = turnaround_time_;
+  }
 
-  double time_to_wait_secs = (double)length / ((double)baudrate_ / 10.0);
-  struct timespec tim;
-  tim.tv_sec = 0;
-  tim.tv_nsec = (long) (time_to_wait_secs * 1000000000.0);
-  nanosleep(&tim, NULL);
+  return write_result;
+}
 
-  gpioLow();
+bool PortHandlerLinux::setDirectionControl(int mode)
+{
+  if (mode != DIRECTION_CONTROL_GPIO_SLEEP && mode != DIRECTION_CONTROL_GPIO_DRAIN && mode != DIRECTION_CONTROL_RS485)
+    return false;
 
-  return write_result;
+  direction_control_ = mode;
+  if (socket_fd_ < 0)
+    return true; // applied when port is opened
+
+  return applyDirectionControl();
+}
+
+int PortHandlerLinux::getDirectionControl()
+{
+  return direction_control_;
+}
+
+/*
+ * Enables or disables the kernel RS-485 mode on the opened port
+ * If RS-485 mode is not supported by the uart driver, fallback on gpio sleep
+ */
+bool PortHandlerLinux::applyDirectionControl()
+{
+  struct serial_rs485 rs485conf;
+  memset(&rs485conf, 0, sizeof(rs485conf));
+  ioctl(socket_fd_, TIOCGRS485, &rs485conf);
+
+  if (direction_control_ == DIRECTION_CONTROL_RS485)
+  {
+    rs485conf.flags |= SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+    rs485conf.flags &= ~(SER_RS485_RTS_AFTER_SEND);
+    rs485conf.delay_rts_before_send = 0;
+    rs485conf.delay_rts_after_send = 0;
+
+    if (ioctl(socket_fd_, TIOCSRS485, &rs485conf) < 0)
+    {
+      printf("[PortHandlerLinux::applyDirectionControl] RS-485 mode not supported, fallback on gpio sleep\n");
+      direction_control_ = DIRECTION_CONTROL_GPIO_SLEEP;
+      return false;
+    }
+#ifdef __aarch64__
+    pinModeAlt(GPIO_HALF_DUPLEX_DIRECTION, GPIO_HALF_DUPLEX_DIRECTION_RTS_ALT);
+#endif
+  }
+  else
+  {
+    if (rs485conf.flags & SER_RS485_ENABLED)
+    {
+      rs485conf.flags &= ~(SER_RS485_ENABLED);
+      ioctl(socket_fd_, TIOCSRS485, &rs485conf);
+    }
+#ifdef __aarch64__
+    pinMode(GPIO_HALF_DUPLEX_DIRECTION, OUTPUT);
+    gpioLow();
+#endif
+  }
+  return true;
+}
+
+double PortHandlerLinux::getTurnaroundTime()
+{
+  return turnaround_time_;
+}
+
+double PortHandlerLinux::getMaxTurnaroundTime()
+{
+  return max_turnaround_time_;
+}
+
+void PortHandlerLinux::resetTurnaroundTime()
+{
+  max_turnaround_time_ = 0.0;
 }
 
 void PortHandlerLinux::setPacketTimeout(uint16_t packet_length)
 {
   packet_start_time_  = getCurrentTime();
   packet_timeout_     = (tx_time_per_byte * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0;
+  response_start_time_ = packet_start_time_;
+  response_id_        = -1;
 }
 
 void PortHandlerLinux::setPacketTimeout(double msec)
 {
   packet_start_time_  = getCurrentTime();
   packet_timeout_     = msec;
+  response_start_time_ = packet_start_time_;
+  response_id_        = -1;
 }
 
 bool PortHandlerLinux::isPacketTimeout()
@@ -207,11 +332,115 @@ bool PortHandlerLinux::isPacketTimeout()
   if(getTimeSinceStart() > packet_timeout_)
   {
     packet_timeout_ = 0;
+    if (response_id_ >= 0)
+    {
+      // relearn from default timeout if the latency of this id has changed (ex: return delay time modified)
+      if (++response_timeout_count_[response_id_] >= RESPONSE_TIMEOUT_MAX_FAIL)
+        resetResponseLatency(response_id_);
+      response_id_ = -1;
+    }
+    // next status packet of a sync/bulk read is awaited from now
+    response_start_time_ = getCurrentTime();
     return true;
   }
   return false;
 }
 
+/*
+ * Sleeps in ppoll() until bytes are received, instead of spinning on readPort()
+ * for the whole status packet window
+ */
+bool PortHandlerLinux::waitPort()
+{
+  double remaining_time = packet_timeout_ - getTimeSinceStart(); // ms
+  if (remaining_time <= 0.0)
+    return false;
+
+  struct pollfd poll_fd;
+  poll_fd.fd      = socket_fd_;
+  poll_fd.events  = POLLIN;
+  poll_fd.revents = 0;
+
+  struct timespec tim;
+  tim.tv_sec  = (time_t)(remaining_time / 1000.0);
+  tim.tv_nsec = (long)((remaining_time - (double)tim.tv_sec * 1000.0) * 1000000.0);
+
+  return ppoll(&poll_fd, 1, &tim, NULL) > 0;
+}
+
+void PortHandlerLinux::setAdaptiveTimeout(bool enable, double percentile, double margin_msec)
+{
+  adaptive_timeout_   = enable;
+  timeout_percentile_ = (percentile < 0.0) ? 0.0 : (percentile > 1.0) ? 1.0 : percentile;
+  timeout_margin_     = (margin_msec < 0.0) ? 0.0 : margin_msec;
+  for (int id = 0; id < 256; id++)
+    resetResponseLatency(id);
+}
+
+void PortHandlerLinux::resetResponseLatency(uint8_t id)
+{
+  response_latency_count_[id] = 0;
+  response_latency_index_[id] = 0;
+  response_timeout_count_[id] = 0;
+  response_latency_[id]       = -1.0;
+}
+
+/*
+ * Timeout for the status packet of id, counted from the end of tx
+ * (or from the end of the previous status packet, for sync/bulk read)
+ * Keeps the default timeout if the latency of this id is not learned yet
+ */
+void PortHandlerLinux::setResponseTimeout(uint8_t id, uint16_t packet_length)
+{
+  if (!adaptive_timeout_)
+    return;
+
+  response_id_ = id;
+  packet_start_time_ = response_start_time_;
+  if (response_latency_[id] < 0.0)
+    packet_timeout_ = (tx_time_per_byte * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0;
+  else
+    packet_timeout_ = (tx_time_per_byte * (double)packet_length) + response_latency_[id] + timeout_margin_;
+}
+
+void PortHandlerLinux::setResponseReceived(uint8_t id, uint16_t packet_length, double read_time, bool learn)
+{
+  double now = (read_time > 0.0) ? read_time : getCurrentTime();
+
+  if (adaptive_timeout_ && learn)
+  {
+    float latency = (float)(now - response_start_time_ - tx_time_per_byte * (double)packet_length);
+    if (latency < 0.0)
+      latency = 0.0;
+
+    response_latency_samples_[id][response_latency_index_[id]] = latency;
+    response_latency_index_[id] = (response_latency_index_[id] + 1) % RESPONSE_LATENCY_SAMPLES;
+    if (response_latency_count_[id] < RESPONSE_LATENCY_SAMPLES)
+      response_latency_count_[id]++;
+    response_timeout_count_[id] = 0;
+
+    int count = response_latency_count_[id];
+    if (count >= RESPONSE_LATENCY_MIN_SAMPLES)
+    {
+      float sorted[RESPONSE_LATENCY_SAMPLES];
+      memcpy(sorted, response_latency_samples_[id], count * sizeof(float));
+      int rank = (int)ceil(timeout_percentile_ * count) - 1;
+      if (rank < 0)
+        rank = 0;
+      std::nth_element(sorted, sorted + rank, sorted + count);
+      response_latency_[id] = sorted[rank];
+    }
+  }
+
+  response_id_ = -1;
+  response_start_time_ = now;
+}
+
+double PortHandlerLinux::getResponseLatency(uint8_t id)
+{
+  return response_latency_[id];
+}
+
 double PortHandlerLinux::getCurrentTime()
 {
   struct timespec tv;
@@ -255,6 +484,8 @@ bool PortHandlerLinux::setupPort(int cflag_baud)
   tcsetattr(socket_fd_, TCSANOW, &newtio);
 
   tx_time_per_byte = (1000.0 / (double)baudrate_) * 10.0;
+
+  applyDirectionControl(); // on failure, fallback mode is used
   return true;
 }
 
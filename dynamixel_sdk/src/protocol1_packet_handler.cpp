@@ -232,6 +232,8 @@ int Protocol1PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
           }
           else
           {
+            // sleep until the rest of the packet is received
+            port->waitPort();
             continue;
           }
         }
@@ -276,6 +278,8 @@ int Protocol1PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
         }
         break;
       }
+      // sleep until bytes are received (or timeout)
+      port->waitPort();
     }
   }
   port->is_using_ = false;
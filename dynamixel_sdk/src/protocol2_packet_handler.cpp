@@ -37,7 +37,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include "dynamixel_sdk/crc16.h"
 #include "dynamixel_sdk/protocol2_packet_handler.h"
+#include "dynamixel_sdk/tracing.h"
 
 #define TXPACKET_MAX_LEN    (4*1024)
 #define RXPACKET_MAX_LEN    (4*1024)
@@ -195,53 +197,7 @@ void Protocol2PacketHandler::printRxPacketError(uint8_t error)
 
 unsigned short Protocol2PacketHandler::updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size)
 {
-  uint16_t i;
-  uint16_t crc_table[256] = {0x0000,
-  0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
-  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
-  0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
-  0x8077, 0x0072, 0x0050, 0x8055, 0x805F, 0x005A, 0x804B,
-  0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
-  0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF,
-  0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1, 0x00A0, 0x80A5,
-  0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093,
-  0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
-  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197,
-  0x0192, 0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE,
-  0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB,
-  0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9,
-  0x01C8, 0x81CD, 0x81C7, 0x01C2, 0x0140, 0x8145, 0x814F,
-  0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176,
-  0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162, 0x8123,
-  0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
-  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104,
-  0x8101, 0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D,
-  0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B,
-  0x032E, 0x0324, 0x8321, 0x0360, 0x8365, 0x836F, 0x036A,
-  0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C,
-  0x8359, 0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5,
-  0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1, 0x83F3,
-  0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
-  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7,
-  0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E,
-  0x0384, 0x8381, 0x0280, 0x8285, 0x828F, 0x028A, 0x829B,
-  0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
-  0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC,
-  0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2, 0x02D0, 0x82D5,
-  0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243,
-  0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
-  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264,
-  0x8261, 0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E,
-  0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219, 0x0208,
-  0x820D, 0x8207, 0x0202 };
-
-  for (uint16_t j = 0; j < data_blk_size; j++)
-  {
-    i = ((uint16_t)(crc_accum >> 8) ^ *data_blk_ptr++) & 0xFF;
-    crc_accum = (crc_accum << 8) ^ crc_table[i];
-  }
-
-  return crc_accum;
+  return Crc16::update(crc_accum, data_blk_ptr, data_blk_size);
 }
 
 void Protocol2PacketHandler::addStuffing(uint8_t *packet)
@@ -268,11 +224,8 @@ void Protocol2PacketHandler::addStuffing(uint8_t *packet)
   temp[index++] = packet[PKT_INSTRUCTION+packet_length_in-1];
 
 
-  //////////////////////////
-  if (packet_length_in != packet_length_out)
-    packet = (uint8_t *)realloc(packet, index * sizeof(uint8_t));
-
-  ///////////////////////////
+  // packet buffer is not reallocated (it may be caller-provided) :
+  // it must have room for stuffing bytes (length / 3)
 
   for (uint8_t s = 0; s < index; s++)
     packet[s] = temp[s];
@@ -287,6 +240,10 @@ void Protocol2PacketHandler::removeStuffing(uint8_t *packet)
   int packet_length_in = DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
   int packet_length_out = packet_length_in;
 
+  // no FD in the packet : nothing to remove
+  if (memchr(&packet[PKT_INSTRUCTION], 0xFD, packet_length_in - 2) == NULL)
+    return;
+
   index = PKT_INSTRUCTION;
   for (i = 0; i < packet_length_in - 2; i++)  // except CRC
   {
@@ -338,7 +295,10 @@ int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
 
   // tx packet
   port->clearPort();
+  port->rx_parser_.clear();
   written_packet_length = port->writePort(txpacket, total_packet_length);
+  DXL_TRACEPOINT(instruction_packet, txpacket[PKT_ID], txpacket[PKT_INSTRUCTION], written_packet_length,
+                 (total_packet_length == written_packet_length) ? COMM_SUCCESS : COMM_TX_FAIL);
 
   if (total_packet_length != written_packet_length)
   {
@@ -349,112 +309,77 @@ int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
   return COMM_SUCCESS;
 }
 
-int Protocol2PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
+/*
+ * Reads the port until a valid status packet is in the port receive buffer
+ * *packet points into the buffer (stuffing removed in place)
+ */
+int Protocol2PacketHandler::receivePacket(PortHandler *port, uint8_t **packet)
 {
   int     result         = COMM_TX_FAIL;
 
-  uint16_t rx_length     = 0;
-  uint16_t wait_length   = 11; // minimum length (HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR CRC16_L CRC16_H)
+  StatusPacketParser &parser = port->rx_parser_;
+  uint16_t packet_length = 0;
 
   while(true)
   {
-    rx_length += port->readPort(&rxpacket[rx_length], wait_length - rx_length);
-    if (rx_length >= wait_length)
+    // read all available bytes (several status packets for sync/bulk read)
+    uint8_t *free_space = parser.getFreeSpace();
+    int read_length = port->readPort(free_space, parser.getFreeSpaceLength());
+    if (read_length > 0)
+      parser.addBytes(read_length, port->getReadTime());
+
+    // header, length and CRC16 checked as bytes are received
+    result = parser.findPacket(packet, &packet_length);
+    if (result == COMM_SUCCESS)
     {
-      uint16_t idx = 0;
-
-      // find packet header
-      for (idx = 0; idx < (rx_length - 3); idx++)
-      {
-        if ((rxpacket[idx] == 0xFF) && (rxpacket[idx+1] == 0xFF) && (rxpacket[idx+2] == 0xFD) && (rxpacket[idx+3] != 0xFD))
-          break;
-      }
+      parser.consumePacket(packet_length);
+      break;
+    }
+    else if (result == COMM_RX_CORRUPT)
+    {
+      break;
+    }
 
-      if (idx == 0)   // found at the beginning of the packet
+    // check timeout
+    if (port->isPacketTimeout() == true)
+    {
+      if (parser.getAvailableLength() == 0)
       {
-        if (rxpacket[PKT_RESERVED] != 0x00 ||
-           rxpacket[PKT_ID] > 0xFC ||
-           DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) > RXPACKET_MAX_LEN ||
-           rxpacket[PKT_INSTRUCTION] != 0x55)
-        {
-          // remove the first byte in the packet
-          for (uint8_t s = 0; s < rx_length - 1; s++)
-            rxpacket[s] = rxpacket[1 + s];
-          //memcpy(&rxpacket[0], &rxpacket[idx], rx_length - idx);
-          rx_length -= 1;
-          continue;
-        }
-
-        // re-calculate the exact length of the rx packet
-        if (wait_length != DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1)
-        {
-          wait_length = DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1;
-          continue;
-        }
-
-        if (rx_length < wait_length)
-        {
-          // check timeout
-          if (port->isPacketTimeout() == true)
-          {
-            if (rx_length == 0)
-            {
-              result = COMM_RX_TIMEOUT;
-            }
-            else
-            {
-              result = COMM_RX_CORRUPT;
-            }
-            break;
-          }
-          else
-          {
-            continue;
-          }
-        }
-
-        // verify CRC16
-        uint16_t crc = DXL_MAKEWORD(rxpacket[wait_length-2], rxpacket[wait_length-1]);
-        if (updateCRC(0, rxpacket, wait_length - 2) == crc)
-        {
-          result = COMM_SUCCESS;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
+        result = COMM_RX_TIMEOUT;
       }
       else
       {
-        // remove unnecessary packets
-        for (uint8_t s = 0; s < rx_length - idx; s++)
-          rxpacket[s] = rxpacket[idx + s];
-        //memcpy(&rxpacket[0], &rxpacket[idx], rx_length - idx);
-        rx_length -= idx;
-      }
-    }
-    else
-    {
-      // check timeout
-      if (port->isPacketTimeout() == true)
-      {
-        if (rx_length == 0)
-        {
-          result = COMM_RX_TIMEOUT;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
+        result = COMM_RX_CORRUPT;
       }
+      break;
     }
+    // sleep until bytes are received (or timeout)
+    port->waitPort();
   }
   port->is_using_ = false;
 
   if (result == COMM_SUCCESS)
-    removeStuffing(rxpacket);
+  {
+    port->setResponseReceived((*packet)[PKT_ID], packet_length, parser.getPacketReadTime(), parser.isFirstPacketOfRead());
+    removeStuffing(*packet);
+    DXL_TRACEPOINT(status_packet, (*packet)[PKT_ID], (*packet)[PKT_ERROR], packet_length, result);
+  }
+  else
+  {
+    DXL_TRACEPOINT(status_packet, 0, 0, 0, result);
+  }
+
+  return result;
+}
+
+int Protocol2PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
+{
+  uint8_t *packet = 0;
+
+  int result = receivePacket(port, &packet);
+  if (result == COMM_SUCCESS)
+    memcpy(rxpacket, packet, DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]) + 7);
+    // 7: HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H
 
   return result;
 }
@@ -470,7 +395,8 @@ int Protocol2PacketHandler::txRxPacket(PortHandler *port, uint8_t *txpacket, uin
     return result;
 
   // (Instruction == BulkRead or SyncRead) == this function is not available.
-  if (txpacket[PKT_INSTRUCTION] == INST_BULK_READ || txpacket[PKT_INSTRUCTION] == INST_SYNC_READ)
+  if (txpacket[PKT_INSTRUCTION] == INST_BULK_READ || txpacket[PKT_INSTRUCTION] == INST_SYNC_READ
+      || txpacket[PKT_INSTRUCTION] == INST_FAST_BULK_READ || txpacket[PKT_INSTRUCTION] == INST_FAST_SYNC_READ)
     result = COMM_NOT_AVAILABLE;
 
   // (ID == Broadcast ID) == no need to wait for status packet or not available.
@@ -485,10 +411,12 @@ int Protocol2PacketHandler::txRxPacket(PortHandler *port, uint8_t *txpacket, uin
   if (txpacket[PKT_INSTRUCTION] == INST_READ)
   {
     port->setPacketTimeout((uint16_t)(DXL_MAKEWORD(txpacket[PKT_PARAMETER0+2], txpacket[PKT_PARAMETER0+3]) + 11));
+    port->setResponseTimeout(txpacket[PKT_ID], (uint16_t)(DXL_MAKEWORD(txpacket[PKT_PARAMETER0+2], txpacket[PKT_PARAMETER0+3]) + 11));
   }
   else
   {
     port->setPacketTimeout((uint16_t)11);
+    port->setResponseTimeout(txpacket[PKT_ID], (uint16_t)11);
     // HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR CRC16_L CRC16_H
   }
 
@@ -566,6 +494,7 @@ int Protocol2PacketHandler::broadcastPing(PortHandler *port, std::vector<uint8_t
     rx_length += port->readPort(&rxpacket[rx_length], wait_length - rx_length);
     if (port->isPacketTimeout() == true)// || rx_length >= wait_length)
       break;
+    port->waitPort();
   }
   
   port->is_using_ = false;
@@ -695,26 +624,46 @@ int Protocol2PacketHandler::readTx(PortHandler *port, uint8_t id, uint16_t addre
 
 int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error)
 {
-  int result                  = COMM_TX_FAIL;
   uint8_t *rxpacket           = (uint8_t *)malloc(RXPACKET_MAX_LEN);
   //(length + 11 + (length/3));  // (length/3): consider stuffing
   //uint8_t *rxpacket           = new uint8_t[length + 11 + (length/3)];    // (length/3): consider stuffing
 
+  int result = readRx(port, id, length, data, error, rxpacket);
+
+  free(rxpacket);
+  //delete[] rxpacket;
+  return result;
+}
+
+int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error, uint8_t *rxpacket)
+{
+  const uint8_t *rx_data      = 0;
+
+  int result = readRxView(port, id, length, &rx_data, error);
+  if (result == COMM_SUCCESS)
+    memcpy(data, rx_data, length);
+
+  return result;
+}
+
+int Protocol2PacketHandler::readRxView(PortHandler *port, uint8_t id, uint16_t length, const uint8_t **data, uint8_t *error)
+{
+  int result                  = COMM_TX_FAIL;
+  uint8_t *rxpacket           = 0;
+
+  port->setResponseTimeout(id, length + 11);
+
   do {
-    result = rxPacket(port, rxpacket);
+    result = receivePacket(port, &rxpacket);
   } while (result == COMM_SUCCESS && rxpacket[PKT_ID] != id);
 
-  if (result == COMM_SUCCESS && rxpacket[PKT_ID] == id)
+  if (result == COMM_SUCCESS)
   {
     if (error != 0)
       *error = (uint8_t)rxpacket[PKT_ERROR];
-    for (uint8_t s = 0; s < length; s++)
-      data[s] = rxpacket[PKT_PARAMETER0 + 1 + s];
-    //memcpy(data, &rxpacket[PKT_PARAMETER0+1], length);
+    *data = &rxpacket[PKT_PARAMETER0 + 1];
   }
 
-  free(rxpacket);
-  //delete[] rxpacket;
   return result;
 }
 
@@ -821,7 +770,7 @@ int Protocol2PacketHandler::writeTxOnly(PortHandler *port, uint8_t id, uint16_t
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length+12);
+  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));   // (length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[length+12];
 
   txpacket[PKT_ID]            = id;
@@ -847,7 +796,7 @@ int Protocol2PacketHandler::writeTxRx(PortHandler *port, uint8_t id, uint16_t ad
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12);
+  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));   // (length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[length+12];
   uint8_t rxpacket[11]        = {0};
 
@@ -906,7 +855,7 @@ int Protocol2PacketHandler::regWriteTxOnly(PortHandler *port, uint8_t id, uint16
 {
   int result                 = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12);
+  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));   // (length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[length+12];
 
   txpacket[PKT_ID]            = id;
@@ -932,7 +881,7 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
 {
   int result                 = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12);
+  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));   // (length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[length+12];
   uint8_t rxpacket[11]        = {0};
 
@@ -956,11 +905,19 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
 
 int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length)
 {
-  int result                 = COMM_TX_FAIL;
-
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14);
+  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));   // (param_length / 3): consider stuffing
   // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
+  int result = syncReadTx(port, start_address, data_length, param, param_length, txpacket);
+
+  free(txpacket);
+  return result;
+}
+
+int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -978,18 +935,26 @@ int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address
   if (result == COMM_SUCCESS)
     port->setPacketTimeout((uint16_t)((11 + data_length) * param_length));
 
-  free(txpacket);
   return result;
 }
 
 int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length)
 {
-  int result                 = COMM_TX_FAIL;
-
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14);
+  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));   // (param_length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[param_length + 14];
   // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
+  int result = syncWriteTxOnly(port, start_address, data_length, param, param_length, txpacket);
+
+  free(txpacket);
+  //delete[] txpacket;
+  return result;
+}
+
+int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -1005,19 +970,26 @@ int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_ad
 
   result = txRxPacket(port, txpacket, 0, 0);
 
-  free(txpacket);
-  //delete[] txpacket;
   return result;
 }
 
 int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16_t param_length)
 {
-  int result                 = COMM_TX_FAIL;
-
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10);
+  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10 + (param_length / 3));   // (param_length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[param_length + 10];
   // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
 
+  int result = bulkReadTx(port, param, param_length, txpacket);
+
+  free(txpacket);
+  //delete[] txpacket;
+  return result;
+}
+
+int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
@@ -1036,19 +1008,26 @@ int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16
     port->setPacketTimeout((uint16_t)wait_length);
   }
 
-  free(txpacket);
-  //delete[] txpacket;
   return result;
 }
 
 int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, uint16_t param_length)
 {
-  int result                 = COMM_TX_FAIL;
-
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10);
+  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10 + (param_length / 3));   // (param_length / 3): consider stuffing
   //uint8_t *txpacket           = new uint8_t[param_length + 10];
   // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
 
+  int result = bulkWriteTxOnly(port, param, param_length, txpacket);
+
+  free(txpacket);
+  //delete[] txpacket;
+  return result;
+}
+
+int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
@@ -1060,7 +1039,76 @@ int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, u
 
   result = txRxPacket(port, txpacket, 0, 0);
 
-  free(txpacket);
-  //delete[] txpacket;
+  return result;
+}
+
+int Protocol2PacketHandler::fastSyncReadTx(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_FAST_SYNC_READ;
+  txpacket[PKT_PARAMETER0+0]  = DXL_LOBYTE(start_address);
+  txpacket[PKT_PARAMETER0+1]  = DXL_HIBYTE(start_address);
+  txpacket[PKT_PARAMETER0+2]  = DXL_LOBYTE(data_length);
+  txpacket[PKT_PARAMETER0+3]  = DXL_HIBYTE(data_length);
+
+  memcpy(&txpacket[PKT_PARAMETER0+4], param, param_length);
+
+  result = txPacket(port, txpacket);
+  if (result == COMM_SUCCESS)
+  {
+    // one status packet : HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST + (ERR ID DATA CRC16_L CRC16_H) per device
+    uint16_t wait_length = 8 + (data_length + 4) * param_length;
+    port->setPacketTimeout(wait_length);
+    port->setResponseTimeout(BROADCAST_ID, wait_length);
+  }
+
+  return result;
+}
+
+int Protocol2PacketHandler::fastBulkReadTx(PortHandler *port, uint8_t *param, uint16_t param_length, uint8_t *txpacket)
+{
+  int result                 = COMM_TX_FAIL;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_FAST_BULK_READ;
+
+  memcpy(&txpacket[PKT_PARAMETER0], param, param_length);
+
+  result = txPacket(port, txpacket);
+  if (result == COMM_SUCCESS)
+  {
+    uint16_t wait_length = 8;
+    for (int i = 0; i < param_length; i += 5)
+      wait_length += DXL_MAKEWORD(param[i+3], param[i+4]) + 4;
+    port->setPacketTimeout(wait_length);
+    port->setResponseTimeout(BROADCAST_ID, wait_length);
+  }
+
+  return result;
+}
+
+int Protocol2PacketHandler::fastReadRxView(PortHandler *port, const uint8_t **data, uint16_t *data_length)
+{
+  int result                  = COMM_TX_FAIL;
+  uint8_t *rxpacket           = 0;
+
+  do {
+    result = receivePacket(port, &rxpacket);
+  } while (result == COMM_SUCCESS && rxpacket[PKT_ID] != BROADCAST_ID);
+
+  if (result == COMM_SUCCESS)
+  {
+    if (rxpacket[PKT_INSTRUCTION] != INST_STATUS)
+      return COMM_RX_CORRUPT;
+    *data = &rxpacket[PKT_ERROR];
+    *data_length = DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) - 1; // 1: INST
+  }
+
   return result;
 }
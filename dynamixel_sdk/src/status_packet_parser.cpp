@@ -0,0 +1,182 @@
+/*******************************************************************************
+* Copyright (c) 2016, ROBOTIS CO., LTD.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of ROBOTIS nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#endif
+
+#include <string.h>
+#include "dynamixel_sdk/packet_handler.h"
+#include "dynamixel_sdk/status_packet_parser.h"
+
+///////////////// for Protocol 2.0 Packet /////////////////
+#define PKT_HEADER0             0
+#define PKT_HEADER1             1
+#define PKT_HEADER2             2
+#define PKT_RESERVED            3
+#define PKT_ID                  4
+#define PKT_LENGTH_L            5
+#define PKT_LENGTH_H            6
+#define PKT_INSTRUCTION         7
+
+#define PKT_MIN_LENGTH          11  // HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR CRC16_L CRC16_H
+
+using namespace dynamixel;
+
+uint8_t *StatusPacketParser::getFreeSpace()
+{
+  if (head_ == tail_ && !packet_given_)
+  {
+    head_ = 0;
+    tail_ = 0;
+    read_count_ = 0;
+  }
+  else if (tail_ == STATUS_PACKET_BUFFER_LEN && head_ > 0 && !packet_given_)
+  {
+    // end of buffer reached with a partial packet : move it to the front
+    memmove(buffer_, &buffer_[head_], tail_ - head_);
+    if (crc_start_ >= 0)
+    {
+      crc_start_ -= head_;
+      crc_end_ -= head_;
+    }
+    // no packet returned since clear() : the reads of the parsed bytes can be dropped
+    int reads = 0;
+    for (int i = 0; i < read_count_; i++)
+    {
+      if (read_end_[i] > head_)
+      {
+        read_end_[reads] = read_end_[i] - head_;
+        read_time_[reads] = read_time_[i];
+        reads++;
+      }
+    }
+    read_count_ = reads;
+    tail_ -= head_;
+    head_ = 0;
+  }
+  return &buffer_[tail_];
+}
+
+uint16_t StatusPacketParser::getFreeSpaceLength()
+{
+  return STATUS_PACKET_BUFFER_LEN - tail_;
+}
+
+void StatusPacketParser::addBytes(uint16_t length, double read_time)
+{
+  tail_ += length;
+  if (read_count_ == STATUS_PACKET_MAX_READS)
+    read_count_--;    // extend the last read
+  read_end_[read_count_] = tail_;
+  read_time_[read_count_] = read_time;
+  read_count_++;
+}
+
+int StatusPacketParser::findPacket(uint8_t **packet, uint16_t *packet_length)
+{
+  while (tail_ - head_ >= PKT_MIN_LENGTH)
+  {
+    // find packet header
+    uint8_t *start = (uint8_t *)memchr(&buffer_[head_], 0xFF, tail_ - head_);
+    if (start == NULL)
+    {
+      head_ = tail_;
+      return COMM_RX_WAITING;
+    }
+    head_ = start - buffer_;
+    if (tail_ - head_ < PKT_MIN_LENGTH)
+      return COMM_RX_WAITING;
+
+    uint16_t length = DXL_MAKEWORD(start[PKT_LENGTH_L], start[PKT_LENGTH_H]);
+    if (start[PKT_HEADER1] != 0xFF ||
+        start[PKT_HEADER2] != 0xFD ||
+        start[PKT_RESERVED] != 0x00 ||
+        (start[PKT_ID] > 0xFC && start[PKT_ID] != BROADCAST_ID) ||   // BROADCAST_ID : fast sync/bulk read
+        length < PKT_MIN_LENGTH - PKT_INSTRUCTION ||
+        length > STATUS_PACKET_BUFFER_LEN - PKT_INSTRUCTION ||
+        start[PKT_INSTRUCTION] != INST_STATUS)
+    {
+      head_++;
+      continue;
+    }
+
+    // CRC of the bytes received so far : done when the last byte is received
+    uint16_t total_length = length + PKT_INSTRUCTION;
+    uint16_t crc_stop = head_ + total_length - 2;   // 2: CRC16_L CRC16_H
+    if (crc_start_ != head_)
+    {
+      crc_.reset();
+      crc_start_ = head_;
+      crc_end_ = head_;
+    }
+    uint16_t received_end = (tail_ < crc_stop) ? tail_ : crc_stop;
+    if (received_end > crc_end_)
+    {
+      crc_.add(&buffer_[crc_end_], received_end - crc_end_);
+      crc_end_ = received_end;
+    }
+
+    // wait for the whole packet
+    if (tail_ - head_ < total_length)
+      return COMM_RX_WAITING;
+
+    crc_start_ = -1;
+    if (crc_.get() != DXL_MAKEWORD(start[total_length - 2], start[total_length - 1]))
+    {
+      head_++;
+      return COMM_RX_CORRUPT;
+    }
+
+    // read that completed the packet
+    packet_read_ = read_count_ - 1;
+    for (int i = 0; i < read_count_; i++)
+    {
+      if (read_end_[i] >= head_ + total_length)
+      {
+        packet_read_ = i;
+        break;
+      }
+    }
+    packet_first_of_read_ = (packet_read_ != last_packet_read_);
+
+    *packet = start;
+    *packet_length = total_length;
+    return COMM_SUCCESS;
+  }
+  return COMM_RX_WAITING;
+}
+
+void StatusPacketParser::consumePacket(uint16_t packet_length)
+{
+  head_ += packet_length;
+  packet_given_ = true;
+  last_packet_read_ = packet_read_;
+}
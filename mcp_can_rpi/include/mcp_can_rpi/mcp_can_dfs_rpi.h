@@ -93,6 +93,9 @@
 #define MCP_STAT_RXIF_MASK   (0x03)
 #define MCP_STAT_RX0IF       (1<<0)
 #define MCP_STAT_RX1IF       (1<<1)
+#define MCP_STAT_TX0REQ      (1<<2)
+#define MCP_STAT_TX1REQ      (1<<4)
+#define MCP_STAT_TX2REQ      (1<<6)
 
 #define MCP_EFLG_RX1OVR     (1<<7)
 #define MCP_EFLG_RX0OVR     (1<<6)
@@ -415,6 +418,10 @@
 #define MCP_RXBUF_0 (MCP_RXB0SIDH)
 #define MCP_RXBUF_1 (MCP_RXB1SIDH)
 
+#define MCP_RXBUF_FRAME_SIZE (13)                                       /* SIDH SIDL EID8 EID0 DLC D0-D7*/
+#define MCP_RXB_SRR_M        0x10                                       /* In RXBnSIDL (std remote req) */
+#define MCP_TXBUF_FRAME_SIZE (13)                                       /* SIDH SIDL EID8 EID0 DLC D0-D7*/
+
 //#define MCP2515_SELECT()   digitalWrite(MCPCS, LOW)
 //#define MCP2515_UNSELECT() digitalWrite(MCPCS, HIGH)
 
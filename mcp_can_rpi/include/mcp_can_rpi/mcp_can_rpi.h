@@ -43,23 +43,31 @@
 #ifndef MCP_CAN_RPI_H
 #define MCP_CAN_RPI_H
 
-#ifdef __aarch64__
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
-#endif
-
 // for debug
 #include <stdio.h>
 #include <chrono>
+#include <memory>
 #include <thread>
 
 #include <time.h>
 
 #include "mcp_can_rpi/mcp_can_dfs_rpi.h"
+#include "mcp_can_rpi/mcp_spi_transport.h"
 #define MAX_CHAR_IN_MESSAGE 8
 
 #define CAN_MODEL_NUMBER 10000
 
+#define MCP_GPIO_CHIP_DEVICE "/dev/gpiochip0"                          // gpio character device used for interrupt edges
+
+#define MCP_TX_QUEUE_SIZE 32                                            // software transmit queue (frames)
+
+struct CAN_FRAME
+{
+    INT32U  id;                                                         // CAN ID (with ext/rtr flags, as readMsgBuf)
+    INT8U   len;                                                        // Data Length Code
+    INT8U   data[MAX_CHAR_IN_MESSAGE];                                  // Data array
+};
+
 class MCP_CAN
 {
     private:
@@ -71,22 +79,32 @@ class MCP_CAN
     INT8U   m_nDta[MAX_CHAR_IN_MESSAGE];                            	// Data array
     INT8U   m_nRtr;                                                     // Remote request flag
     INT8U   m_nfilhit;                                                  // The number of the filter that matched the message
-    //INT8U   MCPCS;  (NOT NEEDED, wiringPi already handles CS pin)     // Chip Select pin number 
+    //INT8U   MCPCS;  (NOT NEEDED, spi driver already handles CS pin)   // Chip Select pin number 
     INT8U   mcpMode;                                                    // Mode to return to after configurations are performed.
     
     int spi_channel;
     int spi_baudrate;
     INT8U gpio_can_interrupt;
 
+    std::unique_ptr<MCP_SPI_TRANSPORT> spi;                             // spidev (default), wiringPi or fake
+
+    int gpio_event_fd;                                                  // Falling edge events on interrupt GPIO
+    int wakeup_event_fd;                                                // eventfd used to wake up (or fake) an edge wait
+
+    CAN_FRAME tx_queue[MCP_TX_QUEUE_SIZE];                              // Frames waiting for a free TX buffer
+    INT8U   tx_queue_head;                                              // Next frame to load in a TX buffer
+    INT8U   tx_queue_count;                                             // Number of frames in tx_queue
+    bool    tx_interrupt_enabled;                                       // TXnIF and MERRF raise INT line
+    INT32U  tx_error_count;                                             // Frames reported with TXERR
+
 /*********************************************************************************************************
  *  mcp2515 driver function 
  *********************************************************************************************************/
    // private:
    private:
 
-    struct timespec delay_spi_can = {0};
-    
     void spiTransfer(uint8_t byte_number, unsigned char *buf);
+    void spiTransferChain(MCP_SPI_TRANSFER *transfers, int count);      // Several instructions in one call
     
     void mcp2515_reset(void);                                           // Soft Reset MCP2515
 
@@ -132,7 +150,16 @@ class MCP_CAN
 
     void mcp2515_write_canMsg( const INT8U buffer_sidh_addr );          // Write CAN message
     void mcp2515_read_canMsg( const INT8U buffer_sidh_addr);            // Read CAN message
+    void mcp2515_read_rxBuffer( const INT8U instruction,                // Read a whole RX buffer in one transfer
+                                CAN_FRAME *frame );
+    void mcp2515_decode_rxBuffer( const INT8U *tbufdata,                // RX buffer registers to frame
+                                  CAN_FRAME *frame );
     INT8U mcp2515_getNextFreeTXBuf(INT8U *txbuf_n);                     // Find empty transmit buffer
+    void mcp2515_load_txBuffer( const INT8U instruction,                // Load a whole TX buffer in one transfer
+                                const CAN_FRAME *frame );
+    INT8U mcp2515_encode_txBuffer( const CAN_FRAME *frame,              // Frame to TX buffer registers
+                                   INT8U *tbufdata );
+    void mcp2515_requestToSend( const INT8U instruction );              // Start transmission (RTS) of TX buffer(s)
 
 /*********************************************************************************************************
  *  CAN operator function
@@ -145,6 +172,9 @@ class MCP_CAN
 
 public:
     MCP_CAN(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt);
+    MCP_CAN(MCP_SPI_TRANSPORT *spi, int spi_channel,                    // Given spi transport (owned by MCP_CAN)
+            int spi_baudrate, INT8U gpio_can_interrupt);
+    ~MCP_CAN();
     INT8U begin(INT8U idmodeset, INT8U speedset, INT8U clockset);       // Initilize controller prameters
     INT8U init_Mask(INT8U num, INT8U ext, INT32U ulData);               // Initilize Mask(s)
     INT8U init_Mask(INT8U num, INT32U ulData);                          // Initilize Mask(s)
@@ -155,6 +185,13 @@ public:
     INT8U sendMsgBuf(INT32U id, INT8U len, INT8U *buf);                 // Send message to transmit buffer
     INT8U readMsgBuf(INT32U *id, INT8U *ext, INT8U *len, INT8U *buf);   // Read message from receive buffer
     INT8U readMsgBuf(INT32U *id, INT8U *len, INT8U *buf);               // Read message from receive buffer
+    INT8U readMsgBatch(CAN_FRAME *frames, INT8U max);                   // Read all pending messages (both buffers)
+    INT8U queueMsgBuf(INT32U id, INT8U len, INT8U *buf);                // Add message to software transmit queue
+    INT8U flushTxQueue(void);                                           // Load queued messages in free TX buffers
+    INT8U serviceTxQueue(void);                                         // Ack TX interrupt flags, then flush queue
+    INT8U setTxInterrupt(bool enable);                                  // Raise INT on TX completion and error
+    INT8U getTxQueueCount(void);                                        // Number of messages waiting in queue
+    INT32U getTxErrorCount(void);                                       // Number of transmission errors
     INT8U checkReceive(void);                                           // Check for received data
     INT8U checkError(void);                                             // Check for errors
     INT8U getError(void);                                               // Check for errors
@@ -166,6 +203,10 @@ public:
     bool setupInterruptGpio();
     bool setupSpi();
     bool canReadData();
+
+    bool setupInterruptEvent();                                         // Request edge events on interrupt GPIO
+    INT8U waitForInterrupt(int timeout_ms);                             // Block until interrupt edge or timeout
+    void notifyInterrupt();                                             // Wake up waitForInterrupt (fake edge)
 };
 
 #endif
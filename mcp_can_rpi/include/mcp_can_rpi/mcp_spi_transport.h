@@ -0,0 +1,90 @@
+/*
+    mcp_spi_transport.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MCP_SPI_TRANSPORT_H
+#define MCP_SPI_TRANSPORT_H
+
+#include <time.h>
+
+#include "mcp_can_rpi/mcp_can_dfs_rpi.h"
+
+#define MCP_SPIDEV_DEVICE "/dev/spidev0."                               // + spi channel
+
+#define MCP_SPI_MAX_CHAIN 8                                             // max transfers in one chain
+#define MCP_SPI_MAX_SPEED_HZ 10000000                                   // MCP2515 max SPI clock
+
+/*
+ * One MCP2515 instruction : CS is asserted during the transfer and released after it
+ */
+struct MCP_SPI_TRANSFER
+{
+    unsigned char *buf;                                                 // sent bytes, replaced by received bytes
+    INT8U   len;
+    uint16_t delay_usecs;                                               // delay after transfer, before CS is released
+};
+
+/*
+ * SPI access used by MCP_CAN. A chain of transfers is sent in order, in one call :
+ * a fake transport can be given to MCP_CAN to run it without hardware (see tools/mcp_can_fake_spi.cpp).
+ */
+class MCP_SPI_TRANSPORT
+{
+    public:
+    virtual ~MCP_SPI_TRANSPORT() {}
+
+    virtual bool open(int spi_channel, int spi_speed_hz) = 0;
+    virtual bool transfer(MCP_SPI_TRANSFER *transfers, int count) = 0;
+};
+
+/*
+ * Linux spidev : a whole chain is one SPI_IOC_MESSAGE(n) ioctl (CS toggled between transfers by the driver)
+ */
+class MCP_SPIDEV : public MCP_SPI_TRANSPORT
+{
+    private:
+    int fd;
+    int speed_hz;
+
+    public:
+    MCP_SPIDEV();
+    ~MCP_SPIDEV();
+
+    bool open(int spi_channel, int spi_speed_hz);
+    bool transfer(MCP_SPI_TRANSFER *transfers, int count);
+};
+
+#ifdef MCP_CAN_USE_WIRINGPI
+/*
+ * wiringPi : one wiringPiSPIDataRW call per transfer, then 5 us sleep
+ */
+class MCP_WIRINGPI_SPI : public MCP_SPI_TRANSPORT
+{
+    private:
+    int spi_channel;
+    struct timespec delay_spi_can;
+
+    public:
+    MCP_WIRINGPI_SPI();
+
+    bool open(int spi_channel, int spi_speed_hz);
+    bool transfer(MCP_SPI_TRANSFER *transfers, int count);
+};
+#endif
+
+#endif
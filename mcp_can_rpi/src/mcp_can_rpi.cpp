@@ -42,25 +42,51 @@
 #include "mcp_can_rpi/mcp_can_rpi.h"
 #include <rclcpp/rclcpp.hpp>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#ifdef __aarch64__
+#include <linux/gpio.h>
+#endif
+#ifdef MCP_CAN_USE_WIRINGPI
+#include <wiringPi.h>
+#endif
+
 /*********************************************************************************************************
 ** Function name:           spiTransfer
-** Descriptions:            Performs a spi transfer on Raspberry Pi (using wiringPi)
+** Descriptions:            Performs a spi transfer (one MCP2515 instruction)
 *********************************************************************************************************/
 void MCP_CAN::spiTransfer(uint8_t byte_number, unsigned char *buf)
 {
-#ifdef __aarch64__
-    wiringPiSPIDataRW(spi_channel, buf, byte_number);
-    nanosleep(&delay_spi_can, (struct timespec *)NULL); 
-#endif
+    MCP_SPI_TRANSFER transfer = { buf, byte_number, 0 };
+    spiTransferChain(&transfer, 1);
+}
+
+/*********************************************************************************************************
+** Function name:           spiTransferChain
+** Descriptions:            Performs several spi transfers (CS released between them) in one transport call :
+**                          one ioctl with spidev
+*********************************************************************************************************/
+void MCP_CAN::spiTransferChain(MCP_SPI_TRANSFER *transfers, int count)
+{
+    if (!spi->transfer(transfers, count)) {
+        for (int i = 0; i < count; i++) {                               /* reads as if the bus was idle */
+            memset(transfers[i].buf, 0xFF, transfers[i].len);
+        }
+    }
 }
 
 /*********************************************************************************************************
 ** Function name:           setupInterruptGpio
-** Descriptions:            Setups interrupt GPIO pin as input on Raspberry Pi (using wiringPi)
+** Descriptions:            Setups interrupt GPIO pin as input on Raspberry Pi (wiringPi, or gpio character device)
 *********************************************************************************************************/
 bool MCP_CAN::setupInterruptGpio()
 {
-#ifdef __aarch64__
+#if defined(MCP_CAN_USE_WIRINGPI)
     int result = wiringPiSetupGpio();
     if (!result) {
         RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Gpio started\n");
@@ -73,6 +99,9 @@ bool MCP_CAN::setupInterruptGpio()
     pinMode(gpio_can_interrupt, INPUT);
     nanosleep((const struct timespec[]){{0, 500000L}}, NULL);
     return true;
+#elif defined(__aarch64__)
+    // line requested as input (with edge events) on the gpio character device, also used by canReadData
+    return setupInterruptEvent();
 #else
     RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Can't use GPIO on non-ARM processor");
     return false;
@@ -81,37 +110,152 @@ bool MCP_CAN::setupInterruptGpio()
 
 /*********************************************************************************************************
 ** Function name:           setupSpi
-** Descriptions:            Setups spi communication on Raspberry Pi (using wiringPi)
+** Descriptions:            Setups spi communication (spidev by default, up to 10 MHz)
 *********************************************************************************************************/
 bool MCP_CAN::setupSpi()
 {
-#ifdef __aarch64__
-	int result_spi = wiringPiSPISetup(spi_channel, spi_baudrate);
-    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Started SPI : %d\n", result_spi);
-    if (result_spi < 0) {
+    return spi->open(spi_channel, spi_baudrate);
+}
+
+/*********************************************************************************************************
+** Function name:           canReadData
+** Descriptions:            Checks GPIO interrupt pin to see if data is available (INT line is active low)
+*********************************************************************************************************/
+bool MCP_CAN::canReadData()
+{
+#if defined(MCP_CAN_USE_WIRINGPI)
+    return !digitalRead(gpio_can_interrupt);
+#elif defined(__aarch64__)
+    if (gpio_event_fd < 0) {
         return false;
     }
-    nanosleep((const struct timespec[]){{0, 500000L}}, NULL);
-    return true;
+    struct gpiohandle_data data;
+    memset(&data, 0, sizeof(data));
+    if (ioctl(gpio_event_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0) {
+        return false;
+    }
+    return data.values[0] == 0;
 #else
-    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Can't use SPI on non-ARM processor");
     return false;
 #endif
 }
 
 /*********************************************************************************************************
-** Function name:           canReadData
-** Descriptions:            Checks GPIO interrupt pin to see if data is available (using wiringPi)
+** Function name:           setupInterruptEvent
+** Descriptions:            Requests falling edge events on the interrupt GPIO (gpio character device), so
+**                          that a thread can sleep until the MCP2515 pulls its INT line low.
+**                          An eventfd is also created, to wake up the waiting thread or fake an edge.
 *********************************************************************************************************/
-bool MCP_CAN::canReadData()
+bool MCP_CAN::setupInterruptEvent()
 {
+    if (wakeup_event_fd < 0) {
+        wakeup_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_event_fd < 0) {
+            RCLCPP_ERROR(rclcpp::get_logger("MCP_CAN"),"Failed to create wakeup eventfd : %s", strerror(errno));
+            return false;
+        }
+    }
+
 #ifdef __aarch64__
-    return !digitalRead(gpio_can_interrupt);
+    if (gpio_event_fd >= 0) {
+        return true;
+    }
+
+    int chip_fd = open(MCP_GPIO_CHIP_DEVICE, O_RDONLY | O_CLOEXEC);
+    if (chip_fd < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("MCP_CAN"),"Failed to open %s : %s", MCP_GPIO_CHIP_DEVICE, strerror(errno));
+        return false;
+    }
+
+    struct gpioevent_request req;
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = gpio_can_interrupt;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+    strncpy(req.consumer_label, "mcp2515_int", sizeof(req.consumer_label) - 1);
+
+    int result = ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req);
+    close(chip_fd);
+    if (result < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("MCP_CAN"),"Failed to request edge events on GPIO %d : %s", gpio_can_interrupt, strerror(errno));
+        return false;
+    }
+
+    fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+    gpio_event_fd = req.fd;
+    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Edge events enabled on GPIO %d", gpio_can_interrupt);
+    return true;
 #else
+    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Can't use GPIO edge events on non-ARM processor");
     return false;
 #endif
 }
 
+/*********************************************************************************************************
+** Function name:           waitForInterrupt
+** Descriptions:            Blocks until the interrupt GPIO gets a falling edge, notifyInterrupt() is called
+**                          or timeout_ms expires. Returns immediately if the INT line is already low.
+**                          Returns CAN_MSGAVAIL if woken up by an edge, CAN_NOMSG on timeout.
+*********************************************************************************************************/
+INT8U MCP_CAN::waitForInterrupt(int timeout_ms)
+{
+    if (canReadData()) {
+        return CAN_MSGAVAIL;                                            /* level already low, no wait   */
+    }
+
+    struct pollfd fds[2];
+    int nfds = 0;
+    if (wakeup_event_fd >= 0) {
+        fds[nfds].fd = wakeup_event_fd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        nfds++;
+    }
+    if (gpio_event_fd >= 0) {
+        fds[nfds].fd = gpio_event_fd;
+        fds[nfds].events = POLLIN | POLLPRI;
+        fds[nfds].revents = 0;
+        nfds++;
+    }
+
+    int result = poll(fds, nfds, timeout_ms);
+    if (result <= 0) {
+        return CAN_NOMSG;                                               /* timeout or EINTR             */
+    }
+
+    for (int i = 0; i < nfds; i++) {
+        if (fds[i].revents == 0) {
+            continue;
+        }
+        if (fds[i].fd == wakeup_event_fd) {
+            uint64_t value;
+            while (read(wakeup_event_fd, &value, sizeof(value)) > 0) {}
+        }
+#ifdef __aarch64__
+        else {
+            struct gpioevent_data event;                                /* consume all pending edges    */
+            while (read(gpio_event_fd, &event, sizeof(event)) > 0) {}
+        }
+#endif
+    }
+    return CAN_MSGAVAIL;
+}
+
+/*********************************************************************************************************
+** Function name:           notifyInterrupt
+** Descriptions:            Wakes up a thread blocked in waitForInterrupt (used to stop it, or as a fake
+**                          edge source when no interrupt GPIO is available)
+*********************************************************************************************************/
+void MCP_CAN::notifyInterrupt()
+{
+    if (wakeup_event_fd >= 0) {
+        uint64_t value = 1;
+        if (write(wakeup_event_fd, &value, sizeof(value)) < 0) {
+            RCLCPP_WARN(rclcpp::get_logger("MCP_CAN"),"Failed to notify interrupt : %s", strerror(errno));
+        }
+    }
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp2515_reset
 ** Descriptions:            Performs a software reset
@@ -149,7 +293,7 @@ void MCP_CAN::mcp2515_readRegisterS(const INT8U address, INT8U values[], const I
     INT8U i;
 
     int buf_size = 2 + n; 
-    unsigned char * buf = new unsigned char[buf_size];
+    unsigned char buf[2 + 0xFF];
     buf[0] = MCP_READ;
     buf[1] = address;
 
@@ -180,7 +324,7 @@ void MCP_CAN::mcp2515_setRegisterS(const INT8U address, const INT8U values[], co
     INT8U i;
     
     int buf_size = 2 + n;
-    unsigned char * buf = new unsigned char[buf_size];
+    unsigned char buf[2 + 0xFF];
     buf[0] = MCP_WRITE;
     buf[1] = address;
     for (i = 0; i < n ; ++i) {
@@ -790,6 +934,116 @@ void MCP_CAN::mcp2515_read_canMsg( const INT8U buffer_sidh_addr)        /* read
     mcp2515_readRegisterS( mcp_addr+5, &(m_nDta[0]), m_nDlc );
 }
 
+/*********************************************************************************************************
+** Function name:           mcp2515_read_rxBuffer
+** Descriptions:            Read message with READ RX BUFFER instruction : id, dlc and data are read in a
+**                          single spi transfer, and RXnIF flag is cleared by the MCP2515 at the end of it
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_read_rxBuffer( const INT8U instruction, CAN_FRAME *frame )
+{
+    unsigned char buf[1 + MCP_RXBUF_FRAME_SIZE] = { instruction };
+    spiTransfer(1 + MCP_RXBUF_FRAME_SIZE, buf);
+
+    mcp2515_decode_rxBuffer(&buf[1], frame);
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_decode_rxBuffer
+** Descriptions:            Decodes RX buffer registers (SIDH SIDL EID8 EID0 DLC D0-D7) into a frame
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_decode_rxBuffer( const INT8U *tbufdata, CAN_FRAME *frame )
+{
+    INT32U id = (tbufdata[MCP_SIDH]<<3) + (tbufdata[MCP_SIDL]>>5);
+    INT8U dlc = tbufdata[4];
+    bool rtr;
+
+    if ( (tbufdata[MCP_SIDL] & MCP_TXB_EXIDE_M) ==  MCP_TXB_EXIDE_M ) 
+    {
+                                                                        /* extended id                  */
+        id = (id<<2) + (tbufdata[MCP_SIDL] & 0x03);
+        id = (id<<8) + tbufdata[MCP_EID8];
+        id = (id<<8) + tbufdata[MCP_EID0];
+        id |= 0x80000000;
+        rtr = (dlc & MCP_RXB_RTR_M);
+    }
+    else
+    {
+        rtr = (tbufdata[MCP_SIDL] & MCP_RXB_SRR_M);
+    }
+
+    if (rtr)
+        id |= 0x40000000;
+
+    frame->id = id;
+    frame->len = dlc & MCP_DLC_MASK;
+    if (frame->len > MAX_CHAR_IN_MESSAGE)
+        frame->len = MAX_CHAR_IN_MESSAGE;
+
+    for (int i = 0; i < frame->len; i++)
+        frame->data[i] = tbufdata[5 + i];
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_load_txBuffer
+** Descriptions:            Load message with LOAD TX BUFFER instruction : id, dlc and data are written in a
+**                          single spi transfer (transmission is started later with RTS)
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_load_txBuffer( const INT8U instruction, const CAN_FRAME *frame )
+{
+    unsigned char buf[1 + MCP_TXBUF_FRAME_SIZE] = { instruction };
+    INT8U len = mcp2515_encode_txBuffer(frame, &buf[1]);
+
+    spiTransfer(1 + len, buf);
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_encode_txBuffer
+** Descriptions:            Encodes a frame into TX buffer registers (SIDH SIDL EID8 EID0 DLC D0-D7).
+**                          Returns the number of registers to write.
+*********************************************************************************************************/
+INT8U MCP_CAN::mcp2515_encode_txBuffer( const CAN_FRAME *frame, INT8U *tbufdata )
+{
+    uint16_t canid = (uint16_t)(frame->id & 0x0FFFF);
+
+    if ( (frame->id & 0x80000000) == 0x80000000 )
+    {
+                                                                        /* extended id                  */
+        tbufdata[MCP_EID0] = (INT8U) (canid & 0xFF);
+        tbufdata[MCP_EID8] = (INT8U) (canid >> 8);
+        canid = (uint16_t)((frame->id & 0x1FFFFFFF) >> 16);
+        tbufdata[MCP_SIDL] = (INT8U) (canid & 0x03);
+        tbufdata[MCP_SIDL] += (INT8U) ((canid & 0x1C) << 3);
+        tbufdata[MCP_SIDL] |= MCP_TXB_EXIDE_M;
+        tbufdata[MCP_SIDH] = (INT8U) (canid >> 5 );
+    }
+    else
+    {
+        tbufdata[MCP_SIDH] = (INT8U) (canid >> 3 );
+        tbufdata[MCP_SIDL] = (INT8U) ((canid & 0x07 ) << 5);
+        tbufdata[MCP_EID0] = 0;
+        tbufdata[MCP_EID8] = 0;
+    }
+
+    tbufdata[4] = frame->len;
+    if ( (frame->id & 0x40000000) == 0x40000000 )                       /* if RTR set bit in byte       */
+        tbufdata[4] |= MCP_RTR_MASK;
+
+    for (int i = 0; i < frame->len; i++)
+        tbufdata[5 + i] = frame->data[i];
+
+    return 5 + frame->len;
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_requestToSend
+** Descriptions:            Request to send TX buffer(s) with RTS instruction (MCP_RTS_TXn bits can be or-ed)
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_requestToSend( const INT8U instruction )
+{
+    unsigned char buf[1] = { instruction };
+    spiTransfer(1, buf);
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp2515_getNextFreeTXBuf
 ** Descriptions:            Send message
@@ -820,13 +1074,46 @@ INT8U MCP_CAN::mcp2515_getNextFreeTXBuf(INT8U *txbuf_n)                 /* get N
 ** Descriptions:            Public function to declare CAN class and the /CS pin.
 *********************************************************************************************************/
 MCP_CAN::MCP_CAN(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt)
+#ifdef MCP_CAN_USE_WIRINGPI
+    : MCP_CAN(new MCP_WIRINGPI_SPI(), spi_channel, spi_baudrate, gpio_can_interrupt)
+#else
+    : MCP_CAN(new MCP_SPIDEV(), spi_channel, spi_baudrate, gpio_can_interrupt)
+#endif
+{
+}
+
+/*********************************************************************************************************
+** Function name:           MCP_CAN
+** Descriptions:            Same, with a given spi transport (deleted with MCP_CAN), e.g. a fake one for tests
+*********************************************************************************************************/
+MCP_CAN::MCP_CAN(MCP_SPI_TRANSPORT *spi, int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt)
+    : spi(spi)
 {
     this->spi_channel = spi_channel;
     this->spi_baudrate = spi_baudrate;
     this->gpio_can_interrupt = gpio_can_interrupt;
-    
-    delay_spi_can.tv_sec = 0;
-    delay_spi_can.tv_nsec = 5000L; // wait 5 microseconds between 2 spi transfers
+
+    gpio_event_fd = -1;
+    wakeup_event_fd = -1;
+
+    tx_queue_head = 0;
+    tx_queue_count = 0;
+    tx_interrupt_enabled = false;
+    tx_error_count = 0;
+}
+
+/*********************************************************************************************************
+** Function name:           ~MCP_CAN
+** Descriptions:            Releases interrupt GPIO events
+*********************************************************************************************************/
+MCP_CAN::~MCP_CAN()
+{
+    if (gpio_event_fd >= 0) {
+        close(gpio_event_fd);
+    }
+    if (wakeup_event_fd >= 0) {
+        close(wakeup_event_fd);
+    }
 }
 
 /*********************************************************************************************************
@@ -837,6 +1124,10 @@ INT8U MCP_CAN::begin(INT8U idmodeset, INT8U speedset, INT8U clockset)
 {
     INT8U res;
  
+    tx_queue_head = 0;                                                  /* pending frames are dropped   */
+    tx_queue_count = 0;
+    tx_interrupt_enabled = false;                                       /* CANINTE is reset by init     */
+
     res = mcp2515_init(idmodeset, speedset, clockset);
     if (res == MCP2515_OK)
         return CAN_OK;
@@ -1235,6 +1526,187 @@ INT8U MCP_CAN::readMsgBuf(INT32U *id, INT8U *len, INT8U buf[])
     return CAN_OK;
 }
 
+/*********************************************************************************************************
+** Function name:           readMsgBatch
+** Descriptions:            Public function, Reads all pending messages (RX buffer 0 and 1) until both
+**                          buffers are empty or max messages are read. Returns the number of messages read.
+**                          Full buffers and the next READ STATUS are read in one chain of transfers
+**                          (RXnIF is cleared when CS is released after each READ RX BUFFER).
+*********************************************************************************************************/
+INT8U MCP_CAN::readMsgBatch(CAN_FRAME *frames, INT8U max)
+{
+    unsigned char rx0[1 + MCP_RXBUF_FRAME_SIZE];
+    unsigned char rx1[1 + MCP_RXBUF_FRAME_SIZE];
+    unsigned char status[2];
+    MCP_SPI_TRANSFER chain[3];
+    INT8U stat, count = 0;
+
+    stat = mcp2515_readStatus();
+    while (count < max && (stat & MCP_STAT_RXIF_MASK))                  /* until both buffers are empty */
+    {
+        int n = 0;
+        bool read_rx0 = false, read_rx1 = false;
+
+        if ( stat & MCP_STAT_RX0IF )                                    /* Msg in Buffer 0              */
+        {
+            rx0[0] = MCP_READ_RX0;
+            chain[n++] = { rx0, sizeof(rx0), 0 };
+            read_rx0 = true;
+        }
+        if ( (stat & MCP_STAT_RX1IF) && count + n < max )               /* Msg in Buffer 1              */
+        {
+            rx1[0] = MCP_READ_RX1;
+            chain[n++] = { rx1, sizeof(rx1), 0 };
+            read_rx1 = true;
+        }
+        status[0] = MCP_READ_STATUS;
+        status[1] = 0x00;
+        chain[n++] = { status, sizeof(status), 0 };
+
+        spiTransferChain(chain, n);
+
+        if (read_rx0)
+            mcp2515_decode_rxBuffer(&rx0[1], &frames[count++]);
+        if (read_rx1)
+            mcp2515_decode_rxBuffer(&rx1[1], &frames[count++]);
+        stat = status[1];
+    }
+
+    return count;
+}
+
+/*********************************************************************************************************
+** Function name:           queueMsgBuf
+** Descriptions:            Public function, Adds message to software transmit queue, without waiting for a
+**                          free TX buffer. Message is sent on next flushTxQueue (or serviceTxQueue) call.
+*********************************************************************************************************/
+INT8U MCP_CAN::queueMsgBuf(INT32U id, INT8U len, INT8U *buf)
+{
+    if (tx_queue_count >= MCP_TX_QUEUE_SIZE)
+        return CAN_FAILTX;                                              /* queue is full                */
+
+    CAN_FRAME *frame = &tx_queue[(tx_queue_head + tx_queue_count) % MCP_TX_QUEUE_SIZE];
+    frame->id = id;
+    frame->len = (len > MAX_CHAR_IN_MESSAGE) ? MAX_CHAR_IN_MESSAGE : len;
+    for (int i = 0; i < frame->len; i++)
+        frame->data[i] = buf[i];
+
+    tx_queue_count++;
+    return CAN_OK;
+}
+
+/*********************************************************************************************************
+** Function name:           flushTxQueue
+** Descriptions:            Public function, Loads queued messages in free TX buffers (one READ STATUS, then one
+**                          chain : LOAD TX BUFFER per message, one RTS for all). With equal TXP priorities the MCP2515
+**                          sends highest buffer first, so new messages only go in buffers below the lowest
+**                          pending one : messages leave the bus in queue order. Returns number of messages loaded.
+*********************************************************************************************************/
+INT8U MCP_CAN::flushTxQueue(void)
+{
+    const INT8U txreq[MCP_N_TXBUFFERS] = { MCP_STAT_TX0REQ, MCP_STAT_TX1REQ, MCP_STAT_TX2REQ };
+    const INT8U load_tx[MCP_N_TXBUFFERS] = { MCP_LOAD_TX0, MCP_LOAD_TX1, MCP_LOAD_TX2 };
+    const INT8U rts_tx[MCP_N_TXBUFFERS] = { MCP_RTS_TX0, MCP_RTS_TX1, MCP_RTS_TX2 };
+    unsigned char load[MCP_N_TXBUFFERS][1 + MCP_TXBUF_FRAME_SIZE];
+    unsigned char rts_buf[1];
+    MCP_SPI_TRANSFER chain[MCP_N_TXBUFFERS + 1];
+    INT8U stat, rts = 0, count = 0;
+    int i, first_free = MCP_N_TXBUFFERS;
+
+    if (tx_queue_count == 0)
+        return 0;
+
+    stat = mcp2515_readStatus();
+    for (i = 0; i < MCP_N_TXBUFFERS; i++) {
+        if (stat & txreq[i]) {                                          /* lowest pending buffer        */
+            first_free = i;
+            break;
+        }
+    }
+
+    for (i = first_free - 1; i >= 0 && tx_queue_count > 0; i--) {
+        load[count][0] = load_tx[i];
+        INT8U len = mcp2515_encode_txBuffer(&tx_queue[tx_queue_head], &load[count][1]);
+        chain[count] = { load[count], (INT8U)(1 + len), 0 };
+        tx_queue_head = (tx_queue_head + 1) % MCP_TX_QUEUE_SIZE;
+        tx_queue_count--;
+        rts |= rts_tx[i];
+        count++;
+    }
+
+    if (rts) {
+        rts_buf[0] = rts;
+        chain[count] = { rts_buf, 1, 0 };
+        spiTransferChain(chain, count + 1);
+    }
+
+    return count;
+}
+
+/*********************************************************************************************************
+** Function name:           serviceTxQueue
+** Descriptions:            Public function, Clears TX interrupt flags (TXnIF, MERRF) so that INT line only
+**                          reports received messages, counts transmission errors, then flushes the queue.
+*********************************************************************************************************/
+INT8U MCP_CAN::serviceTxQueue(void)
+{
+    const INT8U ctrlregs[MCP_N_TXBUFFERS] = { MCP_TXB0CTRL, MCP_TXB1CTRL, MCP_TXB2CTRL };
+
+    if (tx_interrupt_enabled)
+    {
+        INT8U flags = mcp2515_readRegister(MCP_CANINTF) & (MCP_TX0IF | MCP_TX1IF | MCP_TX2IF | MCP_MERRF);
+
+        if (flags & MCP_MERRF)
+        {
+            for (int i = 0; i < MCP_N_TXBUFFERS; i++) {
+                if (mcp2515_readRegister(ctrlregs[i]) & MCP_TXB_TXERR_M)
+                    tx_error_count++;
+            }
+        }
+
+        if (flags)
+            mcp2515_modifyRegister(MCP_CANINTF, flags, 0);
+    }
+
+    return flushTxQueue();
+}
+
+/*********************************************************************************************************
+** Function name:           setTxInterrupt
+** Descriptions:            Public function, Enables (or disables) INT line on transmission complete and message
+**                          error, in addition to received messages.
+*********************************************************************************************************/
+INT8U MCP_CAN::setTxInterrupt(bool enable)
+{
+    INT8U inte = MCP_RX0IF | MCP_RX1IF;
+
+    if (enable)
+        inte |= MCP_TX0IF | MCP_TX1IF | MCP_TX2IF | MCP_MERRF;
+
+    mcp2515_setRegister(MCP_CANINTE, inte);
+    tx_interrupt_enabled = enable;
+
+    return MCP2515_OK;
+}
+
+/*********************************************************************************************************
+** Function name:           getTxQueueCount
+** Descriptions:            Public function, Returns number of messages waiting in software transmit queue
+*********************************************************************************************************/
+INT8U MCP_CAN::getTxQueueCount(void)
+{
+    return tx_queue_count;
+}
+
+/*********************************************************************************************************
+** Function name:           getTxErrorCount
+** Descriptions:            Public function, Returns number of transmission errors seen by serviceTxQueue
+*********************************************************************************************************/
+INT32U MCP_CAN::getTxErrorCount(void)
+{
+    return tx_error_count;
+}
+
 /*********************************************************************************************************
 ** Function name:           checkReceive
 ** Descriptions:            Public function, Checks for received data.  (Used if not using the interrupt output)
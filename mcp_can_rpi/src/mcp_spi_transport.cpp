@@ -0,0 +1,152 @@
+/*
+    mcp_spi_transport.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mcp_can_rpi/mcp_spi_transport.h"
+#include <rclcpp/rclcpp.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#ifdef MCP_CAN_USE_WIRINGPI
+#include <wiringPiSPI.h>
+#endif
+
+/*********************************************************************************************************
+** Function name:           MCP_SPIDEV
+** Descriptions:            Linux spidev transport (device is opened by open())
+*********************************************************************************************************/
+MCP_SPIDEV::MCP_SPIDEV()
+{
+    fd = -1;
+    speed_hz = 0;
+}
+
+MCP_SPIDEV::~MCP_SPIDEV()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/*********************************************************************************************************
+** Function name:           open
+** Descriptions:            Opens /dev/spidev0.<spi_channel> : mode 0, 8 bits per word, spi_speed_hz clock
+*********************************************************************************************************/
+bool MCP_SPIDEV::open(int spi_channel, int spi_speed_hz)
+{
+    char device[32];
+    snprintf(device, sizeof(device), MCP_SPIDEV_DEVICE "%d", spi_channel);
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    fd = ::open(device, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("MCP_CAN"),"Failed to open %s : %s", device, strerror(errno));
+        return false;
+    }
+
+    if (spi_speed_hz > MCP_SPI_MAX_SPEED_HZ) {
+        RCLCPP_WARN(rclcpp::get_logger("MCP_CAN"),"SPI clock %d Hz above MCP2515 max, using %d Hz", spi_speed_hz, MCP_SPI_MAX_SPEED_HZ);
+        spi_speed_hz = MCP_SPI_MAX_SPEED_HZ;
+    }
+
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8;
+    uint32_t speed = spi_speed_hz;
+    if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("MCP_CAN"),"Failed to configure %s : %s", device, strerror(errno));
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    speed_hz = spi_speed_hz;
+    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Started SPI : %s at %d Hz", device, speed_hz);
+    return true;
+}
+
+/*********************************************************************************************************
+** Function name:           transfer
+** Descriptions:            Sends a chain of transfers in a single ioctl. CS is released after each transfer
+**                          (cs_change), so each transfer is a separate MCP2515 instruction.
+*********************************************************************************************************/
+bool MCP_SPIDEV::transfer(MCP_SPI_TRANSFER *transfers, int count)
+{
+    struct spi_ioc_transfer xfer[MCP_SPI_MAX_CHAIN];
+
+    if (fd < 0 || count <= 0 || count > MCP_SPI_MAX_CHAIN) {
+        return false;
+    }
+
+    memset(xfer, 0, sizeof(xfer[0]) * count);
+    for (int i = 0; i < count; i++) {
+        xfer[i].tx_buf = (unsigned long)transfers[i].buf;
+        xfer[i].rx_buf = (unsigned long)transfers[i].buf;
+        xfer[i].len = transfers[i].len;
+        xfer[i].speed_hz = speed_hz;
+        xfer[i].bits_per_word = 8;
+        xfer[i].delay_usecs = transfers[i].delay_usecs;
+        xfer[i].cs_change = (i < count - 1) ? 1 : 0;                    /* last one : released by the driver */
+    }
+
+    return ioctl(fd, SPI_IOC_MESSAGE(count), xfer) >= 0;
+}
+
+#ifdef MCP_CAN_USE_WIRINGPI
+/*********************************************************************************************************
+** Function name:           MCP_WIRINGPI_SPI
+** Descriptions:            wiringPi transport (one call per transfer)
+*********************************************************************************************************/
+MCP_WIRINGPI_SPI::MCP_WIRINGPI_SPI()
+{
+    spi_channel = 0;
+    delay_spi_can.tv_sec = 0;
+    delay_spi_can.tv_nsec = 5000L; // wait 5 microseconds between 2 spi transfers
+}
+
+bool MCP_WIRINGPI_SPI::open(int spi_channel, int spi_speed_hz)
+{
+    this->spi_channel = spi_channel;
+    int result_spi = wiringPiSPISetup(spi_channel, spi_speed_hz);
+    RCLCPP_INFO(rclcpp::get_logger("MCP_CAN"),"Started SPI : %d\n", result_spi);
+    if (result_spi < 0) {
+        return false;
+    }
+    nanosleep((const struct timespec[]){{0, 500000L}}, NULL);
+    return true;
+}
+
+bool MCP_WIRINGPI_SPI::transfer(MCP_SPI_TRANSFER *transfers, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (wiringPiSPIDataRW(spi_channel, transfers[i].buf, transfers[i].len) < 0) {
+            return false;
+        }
+        nanosleep(&delay_spi_can, (struct timespec *)NULL);
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,382 @@
+/*
+    mcp_can_fake_spi.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * MCP_CAN checked against a fake MCP2515 behind a fake MCP_SPI_TRANSPORT (no spidev, no hardware)
+ *
+ * The fake decodes the SPI instructions used by MCP_CAN (RESET, READ, WRITE, BIT MODIFY,
+ * READ STATUS, READ RX BUFFER, LOAD TX BUFFER, RTS) on a register map, and counts transport
+ * calls and transfers. Received frames wait on a fake bus and fill RXB0 then RXB1 when their
+ * RXnIF flag is cleared (at the end of a transfer, as the MCP2515 does when CS is released).
+ * Transmission is the highest pending TX buffer first (equal TXP priorities).
+ *
+ * Checks :
+ * - begin() and init_Mask() : mode changes and mask registers written by setRegisterS
+ * - sendMsgBuf() / readMsgBuf() : TX data written by setRegisterS, RX id and data read by readRegisterS
+ * - readMsgBatch() : frames in order, both RX buffers and the next READ STATUS in one chain, max respected
+ * - flushTxQueue() : LOAD TX BUFFER from TXB2 down, one RTS with the bits of the loaded buffers,
+ *   nothing loaded above a pending buffer, frames sent in queue order
+ *
+ * Prints each failed check, returns 1 if any check failed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "mcp_can_rpi/mcp_can_rpi.h"
+
+#define FAKE_REGISTER_COUNT 128
+
+static const INT8U tx_ctrl_registers[MCP_N_TXBUFFERS] = { MCP_TXB0CTRL, MCP_TXB1CTRL, MCP_TXB2CTRL };
+static const INT8U tx_interrupt_flags[MCP_N_TXBUFFERS] = { MCP_TX0IF, MCP_TX1IF, MCP_TX2IF };
+
+/*
+ * MCP2515 register map behind the transport. The transport object is owned by MCP_CAN :
+ * the checks keep a pointer to it.
+ */
+class FAKE_MCP2515_SPI : public MCP_SPI_TRANSPORT
+{
+    public:
+    INT8U regs[FAKE_REGISTER_COUNT];
+    std::deque<CAN_FRAME> bus_rx;                                       // frames waiting for a free RX buffer
+    std::vector<CAN_FRAME> bus_tx;                                      // frames sent, in bus order
+    bool hold_tx;                                                       // TX buffers stay pending until transmit()
+
+    int transport_calls;                                                // transfer() calls (one ioctl with spidev)
+    int transfers;
+    std::vector<std::vector<INT8U> > last_chain;                        // transfers of the last call
+    std::vector<std::vector<INT8U> > history;                           // transfers since resetCounters()
+
+    FAKE_MCP2515_SPI() : hold_tx(false) { reset(); resetCounters(); }
+
+    bool open(int, int) { return true; }
+
+    bool transfer(MCP_SPI_TRANSFER *chain, int count)
+    {
+        transport_calls++;
+        last_chain.clear();
+        for (int i = 0; i < count; i++) {
+            last_chain.push_back(std::vector<INT8U>(chain[i].buf, chain[i].buf + chain[i].len));
+            history.push_back(last_chain.back());
+            transfers++;
+            execute(chain[i].buf, chain[i].len);
+            deliverRx();                                                /* CS released                  */
+            if (!hold_tx)
+                transmit(MCP_N_TXBUFFERS);
+        }
+        return true;
+    }
+
+    void resetCounters() { transport_calls = 0; transfers = 0; last_chain.clear(); history.clear(); }
+
+    // sends up to count pending TX buffers, highest buffer first
+    void transmit(int count)
+    {
+        for (int i = MCP_N_TXBUFFERS - 1; i >= 0 && count > 0; i--) {
+            INT8U ctrl = tx_ctrl_registers[i];
+            if (regs[ctrl] & MCP_TXB_TXREQ_M) {
+                bus_tx.push_back(decodeFrame(&regs[ctrl + 1]));
+                regs[ctrl] &= ~MCP_TXB_TXREQ_M;
+                regs[MCP_CANINTF] |= tx_interrupt_flags[i];
+                count--;
+            }
+        }
+    }
+
+    static CAN_FRAME makeFrame(INT32U id, INT8U len, INT8U seed)
+    {
+        CAN_FRAME frame;
+        frame.id = id;
+        frame.len = len;
+        for (int i = 0; i < MAX_CHAR_IN_MESSAGE; i++)
+            frame.data[i] = (i < len) ? (INT8U)(seed + i) : 0;
+        return frame;
+    }
+
+    static bool sameFrame(const CAN_FRAME &a, const CAN_FRAME &b)
+    {
+        return a.id == b.id && a.len == b.len && memcmp(a.data, b.data, a.len) == 0;
+    }
+
+    private:
+    void reset()
+    {
+        memset(regs, 0, sizeof(regs));
+        regs[MCP_CANCTRL] = 0x87;                                       /* configuration mode           */
+    }
+
+    INT8U readStatus()
+    {
+        INT8U intf = regs[MCP_CANINTF];
+        INT8U status = intf & (MCP_RX0IF | MCP_RX1IF);
+        if (regs[MCP_TXB0CTRL] & MCP_TXB_TXREQ_M) status |= MCP_STAT_TX0REQ;
+        if (intf & MCP_TX0IF)                     status |= (1 << 3);
+        if (regs[MCP_TXB1CTRL] & MCP_TXB_TXREQ_M) status |= MCP_STAT_TX1REQ;
+        if (intf & MCP_TX1IF)                     status |= (1 << 5);
+        if (regs[MCP_TXB2CTRL] & MCP_TXB_TXREQ_M) status |= MCP_STAT_TX2REQ;
+        if (intf & MCP_TX2IF)                     status |= (1 << 7);
+        return status;
+    }
+
+    void execute(unsigned char *buf, int len)
+    {
+        INT8U instruction = buf[0];
+
+        if (instruction == MCP_RESET) {
+            reset();
+        }
+        else if (instruction == MCP_READ) {
+            for (int i = 2; i < len; i++)
+                buf[i] = regs[(buf[1] + i - 2) % FAKE_REGISTER_COUNT];
+        }
+        else if (instruction == MCP_WRITE) {
+            for (int i = 2; i < len; i++)
+                regs[(buf[1] + i - 2) % FAKE_REGISTER_COUNT] = buf[i];
+        }
+        else if (instruction == MCP_BITMOD) {
+            INT8U address = buf[1] % FAKE_REGISTER_COUNT;
+            regs[address] = (regs[address] & ~buf[2]) | (buf[3] & buf[2]);
+        }
+        else if (instruction == MCP_READ_STATUS) {
+            for (int i = 1; i < len; i++)
+                buf[i] = readStatus();
+        }
+        else if ((instruction & 0xF9) == 0x90) {                        /* READ RX BUFFER               */
+            int n = (instruction >> 2) & 1;
+            INT8U address = (n ? MCP_RXBUF_1 : MCP_RXBUF_0) + ((instruction & 0x02) ? 5 : 0);
+            for (int i = 1; i < len; i++)
+                buf[i] = regs[(address + i - 1) % FAKE_REGISTER_COUNT];
+            regs[MCP_CANINTF] &= ~(n ? MCP_RX1IF : MCP_RX0IF);          /* cleared when CS is released  */
+        }
+        else if ((instruction & 0xF8) == 0x40 && (instruction & 0x07) < 6) { /* LOAD TX BUFFER           */
+            int n = (instruction >> 1) & 0x03;
+            INT8U address = tx_ctrl_registers[n] + 1 + ((instruction & 0x01) ? 5 : 0);
+            for (int i = 1; i < len; i++)
+                regs[(address + i - 1) % FAKE_REGISTER_COUNT] = buf[i];
+        }
+        else if ((instruction & 0xF8) == 0x80) {                        /* RTS                          */
+            for (int i = 0; i < MCP_N_TXBUFFERS; i++) {
+                if (instruction & (1 << i))
+                    regs[tx_ctrl_registers[i]] |= MCP_TXB_TXREQ_M;
+            }
+        }
+    }
+
+    // next frames of the bus go in RXB0, then RXB1 (rollover)
+    void deliverRx()
+    {
+        const INT8U flags[2] = { MCP_RX0IF, MCP_RX1IF };
+        const INT8U sidh[2] = { MCP_RXBUF_0, MCP_RXBUF_1 };
+
+        for (int n = 0; n < 2 && !bus_rx.empty(); n++) {
+            if (regs[MCP_CANINTF] & flags[n])
+                continue;
+            encodeFrame(bus_rx.front(), &regs[sidh[n]]);
+            bus_rx.pop_front();
+            regs[MCP_CANINTF] |= flags[n];
+        }
+    }
+
+    // SIDH SIDL EID8 EID0 DLC D0-D7, ids with 0x80000000 are extended
+    static void encodeFrame(const CAN_FRAME &frame, INT8U *buffer)
+    {
+        INT32U id = frame.id & 0x1FFFFFFF;
+        if (frame.id & 0x80000000) {
+            buffer[MCP_SIDH] = (INT8U)(id >> 21);
+            buffer[MCP_SIDL] = (INT8U)(((id >> 13) & 0xE0) | MCP_TXB_EXIDE_M | ((id >> 16) & 0x03));
+            buffer[MCP_EID8] = (INT8U)(id >> 8);
+            buffer[MCP_EID0] = (INT8U)id;
+        }
+        else {
+            buffer[MCP_SIDH] = (INT8U)(id >> 3);
+            buffer[MCP_SIDL] = (INT8U)((id & 0x07) << 5);
+            buffer[MCP_EID8] = 0;
+            buffer[MCP_EID0] = 0;
+        }
+        buffer[4] = frame.len;
+        memcpy(&buffer[5], frame.data, frame.len);
+    }
+
+    static CAN_FRAME decodeFrame(const INT8U *buffer)
+    {
+        CAN_FRAME frame;
+        INT32U id = (buffer[MCP_SIDH] << 3) | (buffer[MCP_SIDL] >> 5);
+        if (buffer[MCP_SIDL] & MCP_TXB_EXIDE_M)
+            id = 0x80000000 | (id << 18) | ((buffer[MCP_SIDL] & 0x03) << 16) | (buffer[MCP_EID8] << 8) | buffer[MCP_EID0];
+        frame.id = id;
+        frame.len = buffer[4] & MCP_DLC_MASK;
+        memset(frame.data, 0, sizeof(frame.data));
+        memcpy(frame.data, &buffer[5], frame.len);
+        return frame;
+    }
+};
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition) {
+        printf("FAILED : %s\n", description);
+        failures++;
+    }
+}
+
+static void checkBeginAndMask(MCP_CAN &can, FAKE_MCP2515_SPI *spi)
+{
+    check(can.begin(MCP_ANY, CAN_1000KBPS, MCP_16MHZ) == CAN_OK, "begin() returns CAN_OK");
+    check(can.setMode(MCP_NORMAL) == MCP2515_OK, "setMode(MCP_NORMAL) returns MCP2515_OK");
+    check((spi->regs[MCP_CANCTRL] & MODE_MASK) == MCP_NORMAL, "CANCTRL is in normal mode");
+
+    // setRegisterS : SIDH SIDL EID8 EID0 in one WRITE of 6 bytes
+    spi->resetCounters();
+    can.init_Mask(0, 0, 0x07FF0000);
+    const INT8U expected[4] = { 0xFF, 0xE0, 0x00, 0x00 };
+    check(memcmp(&spi->regs[MCP_RXM0SIDH], expected, 4) == 0, "init_Mask() writes RXM0 SIDH SIDL EID8 EID0");
+    bool one_write = false;
+    for (size_t i = 0; i < spi->history.size(); i++) {
+        const std::vector<INT8U> &t = spi->history.at(i);
+        one_write = one_write || (t.size() == 6 && t.at(0) == MCP_WRITE && t.at(1) == MCP_RXM0SIDH);
+    }
+    check(one_write, "init_Mask() : one WRITE of the 4 mask registers (setRegisterS)");
+}
+
+static void checkSingleFrames(MCP_CAN &can, FAKE_MCP2515_SPI *spi)
+{
+    // TX data through setRegisterS, transmitted when TXREQ is set
+    INT8U data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    spi->bus_tx.clear();
+    check(can.sendMsgBuf(0x123, 8, data) == CAN_OK, "sendMsgBuf() returns CAN_OK");
+    check(spi->bus_tx.size() == 1 && FAKE_MCP2515_SPI::sameFrame(spi->bus_tx.at(0),
+                FAKE_MCP2515_SPI::makeFrame(0x123, 8, 1)), "sendMsgBuf() frame on the bus");
+
+    // RX id and data through readRegisterS
+    INT32U id = 0;
+    INT8U ext = 1, len = 0, rx_data[8] = { 0 };
+    CAN_FRAME frame = FAKE_MCP2515_SPI::makeFrame(0x2A5, 6, 0x40);
+    spi->bus_rx.push_back(frame);
+    can.checkReceive();                                                 /* fake bus delivers on a transfer */
+    check(can.readMsgBuf(&id, &ext, &len, rx_data) == CAN_OK, "readMsgBuf() returns CAN_OK");
+    check(id == 0x2A5 && ext == 0 && len == 6 && memcmp(rx_data, frame.data, 6) == 0, "readMsgBuf() id and data");
+    check(can.checkReceive() == CAN_NOMSG, "RX0IF cleared after readMsgBuf()");
+}
+
+static void checkReadBatch(MCP_CAN &can, FAKE_MCP2515_SPI *spi)
+{
+    std::vector<CAN_FRAME> sent;
+    CAN_FRAME frames[8];
+
+    for (int i = 0; i < 5; i++) {
+        sent.push_back(FAKE_MCP2515_SPI::makeFrame(0x80000000 | (0x10000 + i), 8, 0x10 * i));
+        spi->bus_rx.push_back(sent.back());
+    }
+    can.checkReceive();                                                 /* RXB0 and RXB1 filled */
+
+    // RXB0 RXB1 STATUS, RXB0 RXB1 STATUS, RXB0 STATUS : 1 READ STATUS + 3 chains
+    spi->resetCounters();
+    INT8U count = can.readMsgBatch(frames, 8);
+    check(count == 5, "readMsgBatch() reads the 5 pending frames");
+    bool in_order = true;
+    for (int i = 0; i < count && i < 5; i++)
+        in_order = in_order && FAKE_MCP2515_SPI::sameFrame(frames[i], sent.at(i));
+    check(in_order, "readMsgBatch() frames in bus order");
+    check(spi->transport_calls == 4 && spi->transfers == 9, "readMsgBatch() : 4 transport calls, 9 transfers");
+    check(spi->last_chain.size() == 2 && spi->last_chain.at(0).at(0) == MCP_READ_RX0 &&
+          spi->last_chain.at(1).at(0) == MCP_READ_STATUS, "readMsgBatch() last chain : READ RX0 then READ STATUS");
+
+    // max : RXB1 is not read if it would exceed max, it stays pending for the next call
+    // (RXB0 is read first, so the 2 last frames may come in either order)
+    sent.clear();
+    for (int i = 0; i < 5; i++) {
+        sent.push_back(FAKE_MCP2515_SPI::makeFrame(0x100 + i, 2, 0x80 + i));
+        spi->bus_rx.push_back(sent.back());
+    }
+    can.checkReceive();
+    count = can.readMsgBatch(frames, 3);
+    check(count == 3 && FAKE_MCP2515_SPI::sameFrame(frames[2], sent.at(2)), "readMsgBatch() stops at max");
+    check(spi->last_chain.size() == 2 && spi->last_chain.at(0).at(0) == MCP_READ_RX0,
+          "readMsgBatch() does not read RXB1 past max");
+    count = can.readMsgBatch(frames, 8);
+    bool rest_ok = count == 2 &&
+        ((FAKE_MCP2515_SPI::sameFrame(frames[0], sent.at(3)) && FAKE_MCP2515_SPI::sameFrame(frames[1], sent.at(4))) ||
+         (FAKE_MCP2515_SPI::sameFrame(frames[0], sent.at(4)) && FAKE_MCP2515_SPI::sameFrame(frames[1], sent.at(3))));
+    check(rest_ok, "readMsgBatch() reads the rest on next call");
+}
+
+static void checkFlushTxQueue(MCP_CAN &can, FAKE_MCP2515_SPI *spi)
+{
+    std::vector<CAN_FRAME> queued;
+    spi->bus_tx.clear();
+    spi->hold_tx = true;
+
+    for (int i = 0; i < 5; i++) {
+        queued.push_back(FAKE_MCP2515_SPI::makeFrame(0x300 + i, 3, 0x20 * i));
+        can.queueMsgBuf(queued.back().id, queued.back().len, queued.back().data);
+    }
+
+    // 3 free buffers : READ STATUS, then LOAD TX2 TX1 TX0 + RTS in one chain
+    spi->resetCounters();
+    check(can.flushTxQueue() == 3, "flushTxQueue() loads 3 frames in free TX buffers");
+    check(spi->transport_calls == 2, "flushTxQueue() : READ STATUS + one chain");
+    const INT8U expected_chain[4] = { MCP_LOAD_TX2, MCP_LOAD_TX1, MCP_LOAD_TX0, MCP_RTS_ALL };
+    bool chain_ok = spi->last_chain.size() == 4;
+    for (size_t i = 0; chain_ok && i < 4; i++)
+        chain_ok = spi->last_chain.at(i).at(0) == expected_chain[i];
+    check(chain_ok, "flushTxQueue() chain : LOAD TX2, LOAD TX1, LOAD TX0, RTS TX0|TX1|TX2");
+
+    // TXB0 still pending : nothing can be loaded above it
+    spi->transmit(2);
+    spi->resetCounters();
+    check(can.flushTxQueue() == 0 && spi->transport_calls == 1, "flushTxQueue() loads nothing above pending TXB0");
+
+    // all sent : the 2 last frames go in TXB2 and TXB1, one RTS with both bits
+    spi->transmit(1);
+    check(can.flushTxQueue() == 2, "flushTxQueue() loads the 2 last frames");
+    check(spi->last_chain.size() == 3 && spi->last_chain.at(0).at(0) == MCP_LOAD_TX2 &&
+          spi->last_chain.at(1).at(0) == MCP_LOAD_TX1 && spi->last_chain.at(2).at(0) == (MCP_RTS_TX2 | MCP_RTS_TX1),
+          "flushTxQueue() chain : LOAD TX2, LOAD TX1, RTS TX1|TX2");
+    spi->transmit(MCP_N_TXBUFFERS);
+    check(can.getTxQueueCount() == 0, "TX queue empty");
+
+    bool in_order = spi->bus_tx.size() == queued.size();
+    for (size_t i = 0; in_order && i < queued.size(); i++)
+        in_order = FAKE_MCP2515_SPI::sameFrame(spi->bus_tx.at(i), queued.at(i));
+    check(in_order, "queued frames sent on the bus in queue order");
+    spi->hold_tx = false;
+}
+
+int main()
+{
+    FAKE_MCP2515_SPI *spi = new FAKE_MCP2515_SPI();
+    MCP_CAN can(spi, 0, 1000000, 25);                                   /* spi is owned by can          */
+
+    check(can.setupSpi(), "setupSpi() with the fake transport");
+    checkBeginAndMask(can, spi);
+    checkSingleFrames(can, spi);
+    checkReadBatch(can, spi);
+    checkFlushTxQueue(can, spi);
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
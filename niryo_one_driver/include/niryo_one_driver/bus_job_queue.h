@@ -0,0 +1,70 @@
+/*
+    bus_job_queue.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_BUS_JOB_QUEUE_H
+#define NIRYO_BUS_JOB_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+/*
+ * Bus ownership between a hardware control loop thread (owner) and other threads
+ * - other threads submit jobs (scan, ping, ...), the owner runs them between two
+ *   control cycles : the loop never stops, callers wait on a future instead of spinning
+ * - without owner (loop thread not started yet or exited), or when called from
+ *   the owner thread itself, a job runs directly in the calling thread
+ * - owner cycles and jobs are serialized by the bus lock
+ */
+class BusJobQueue {
+
+    public:
+
+        BusJobQueue();
+
+        // any thread
+        std::future<int> submit(std::function<int()> job);
+        int execute(std::function<int()> job); // submit() and wait for the result
+
+        // owner thread
+        void attachOwner();
+        void detachOwner();                                  // runs remaining jobs
+        std::unique_lock<std::recursive_mutex> lockBus();    // held during a control cycle
+        int runPendingJobs();                                // returns the number of jobs run
+        void waitForJobs(double timeout);                    // seconds, returns early on submit() or wakeOwner()
+
+        void wakeOwner();
+
+    private:
+
+        std::mutex queue_mutex;
+        std::condition_variable queue_cv;
+        std::deque<std::packaged_task<int()>> jobs;
+
+        bool has_owner;
+        bool wake_requested;
+        std::thread::id owner_id;
+
+        std::recursive_mutex bus_mutex;
+};
+
+#endif
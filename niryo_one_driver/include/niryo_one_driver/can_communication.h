@@ -24,15 +24,35 @@
 #include <rclcpp/rclcpp.hpp>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <functional>
 #include <unordered_map>
 
 #include "niryo_one_driver/stepper_motor_state.h"
 #include "niryo_one_driver/niryo_one_can_driver.h"
 #include "niryo_one_driver/motor_offset_file_handler.h"
 #include "niryo_one_driver/hardware_parameters.h"
+#include "niryo_one_driver/joint_state_buffer.h"
+#include "niryo_one_driver/rt_control_loop.h"
+#include "niryo_one_driver/bus_job_queue.h"
+#include "niryo_one_driver/hw_statistics.h"
+#include "niryo_one_driver/command_latency.h"
 
-#define TIME_TO_WAIT_IF_BUSY 0.0005
+#define TIME_TO_WAIT_IF_PAUSED 0.1 // seconds, control loop paused (woken up by a job or a restart)
+
+#define CAN_RX_WAIT_TIMEOUT_MS       10 // max time without checking INT line level (in case an edge is missed)
+#define CAN_RX_MAX_FRAMES_PER_WAKEUP 32
+#define CAN_RX_BATCH_SIZE            8  // max frames read from MCP2515 in one pass
+#define CAN_RX_PAUSE_TIMEOUT         1.0 // seconds, max wait for the receive loop to confirm a pause
+
+// low-pass filter on stepper velocity computed from position frames (1.0 : no filter)
+#define STEPPER_VELOCITY_FILTER_ALPHA 0.3
+
+#define CAN_DISPATCH_MOTOR_IDS     16 // rxId & 0x0F
+#define CAN_DISPATCH_CONTROL_BYTES 32 // control bytes from motors are all < 0x20
 
 #define CAN_MOTOR_1_ID 1       //
 #define CAN_MOTOR_2_ID 2       // Those ids need to be used in niryo_one_motors.yaml to enable/disable some stepper motors
@@ -41,6 +61,17 @@
 
 #define CAN_BROADCAST_ID 5 // all motors have positive filter for their own id + this one
 
+/*
+ * Stepper firmware contract for CAN_CMD_GROUP_POSITION (only used with can_group_position_enabled)
+ * - frame sent on CAN_BROADCAST_ID : [0x1A, first_id, 24-bit position (MSB first) x n], n <= 2
+ * - position i is the command of motor first_id + i, other motors ignore the frame
+ * - the firmware must decode it from version CAN_GROUP_POSITION_FIRMWARE_MAJOR.MINOR (as reported
+ *   in the firmware version frame). No stepper firmware in this repository implements it yet :
+ *   enabling it with a firmware that does not decode 0x1A loses every position command
+ */
+#define CAN_GROUP_POSITION_FIRMWARE_MAJOR 2
+#define CAN_GROUP_POSITION_FIRMWARE_MINOR 1
+
 #define CAN_MOTOR_CONVEYOR_1_ID 6
 #define CAN_MOTOR_CONVEYOR_2_ID 7
 
@@ -63,6 +94,10 @@
 #define CAN_STEPPERS_WRITE_OFFSET_FAIL -3
 
 void sleep_for(double seconds);
+
+// called with every frame received with this id (other CAN devices, id >= 0x20)
+typedef std::function<void(long unsigned int rxId, unsigned char len, unsigned char *rxBuf)> CanDeviceHandler;
+
 class CanCommunication {
 
     public:
@@ -78,6 +113,7 @@ class CanCommunication {
         void setGoalPositionV2(double axis_1_pos_goal, double axis_2_pos_goal, double axis_3_pos_goal);
         void getCurrentPositionV1(double *axis_1_pos, double *axis_2_pos, double *axis_3_pos, double *axis_4_pos);
         void getCurrentPositionV2(double *axis_1_pos, double *axis_2_pos, double *axis_3_pos);
+        void getCurrentState(double pos[6], double vel[6], double eff[6]); // only fills steppers axes
 
         void getHardwareStatus(bool *is_connection_ok, std::string &error_message,
                 int *calibration_needed, bool *calibration_in_progress,
@@ -86,6 +122,7 @@ class CanCommunication {
                 std::vector<double> &voltages, std::vector<int32_t> &hw_errors);
         void getFirmwareVersions(std::vector<std::string> &motor_names,
                 std::vector<std::string> &firmware_versions);
+        void getStatistics(HwStatisticsReport &report); // one reader thread
         bool isConnectionOk();
         bool isOnLimitedMode();
 
@@ -121,10 +158,22 @@ class CanCommunication {
         void getConveyorFeedBack(uint8_t conveyor_id, bool* connection_state, bool* running, int16_t* speed, int8_t* direction);
         // conveyor reset flags 
         void resetConveyor(uint8_t conveyor_id);
+
+        void registerCanDeviceHandler(long unsigned int rxId, CanDeviceHandler handler);
     private:
 
+        typedef void (CanCommunication::*CanFrameDecoder)(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf);
+
+        struct CanDispatchSlot {
+            CanFrameDecoder decode;
+            StepperMotorState* motor; // NULL if frame data is not stored (conveyors)
+        };
+
         // Niryo One hardware version
         int hardware_version;
+        std::string can_transport;       // CAN_TRANSPORT_MCP2515 or CAN_TRANSPORT_SOCKETCAN
+        std::string can_socket_interface;
+        std::string can_rx_filter_profile; // MCP2515 masks and filters (CAN_RX_FILTER_*)
         int spi_channel;
         int spi_baudrate;
         int gpio_can_interrupt;
@@ -141,14 +190,25 @@ class CanCommunication {
         uint8_t torque_on; // torque is ON/OFF for all motors at the same time
 
         double time_hw_last_write; // 100 Hz
+        double time_hw_last_read; // time of the frame batch being decoded
         double time_hw_last_check_connection; // 2 Hz
         double hw_write_frequency; // 200 Hz
         double hw_check_connection_frequency;
 
         double hw_control_loop_frequency;
-        bool hw_control_loop_keep_alive;
-        bool hw_is_busy;
+        RtThreadConfig rt_config; // control loop thread
+        RtThreadConfig rx_rt_config; // receive loop thread (same as the control loop if not set)
+        std::atomic<bool> hw_control_loop_keep_alive;
+        BusJobQueue bus_jobs; // owned by the control loop thread
+        CanBusStatistics bus_stats;
+        LoopStatisticsWindow loop_stats_window;
+        CommandLatencyProbe command_latency;
         bool hw_limited_mode;
+        bool hw_rx_interrupt_enabled;
+        bool hw_tx_queue_enabled;
+        unsigned int hw_tx_error_count;
+        bool hw_group_position_enabled;
+        bool group_position_supported; // all enabled steppers have a compatible firmware
 
 
         // check if a stepper is connected  ( external stepper)
@@ -168,13 +228,51 @@ class CanCommunication {
         uint8_t new_id;
         uint8_t old_id;
 
+        // conveyor commands to send in next write phase
+        bool conveyor_id_1_command_pending;
+        bool conveyor_id_2_command_pending;
+        bool conveyor_update_id_pending;
+        uint8_t conveyor_update_id_old;
+        uint8_t conveyor_update_id_new;
+
+        // received frames dispatch
+        StepperMotorState* can_id_motors[CAN_DISPATCH_MOTOR_IDS];
+        CanDispatchSlot can_dispatch_table[CAN_DISPATCH_MOTOR_IDS][CAN_DISPATCH_CONTROL_BYTES];
+        std::unordered_map<long unsigned int, CanDeviceHandler> can_device_handlers;
+
+        // exchange with ros2_control read()/write() (one writer thread, one reader thread each)
+        TripleBuffer<JointStateSnapshot> joint_state_buffer;
+        TripleBuffer<JointCommandSnapshot> joint_command_buffer;
+
         void hardwareControlLoop();
         void hardwareControlRead();
+        void hardwareReceiveLoop();
+        void handleCanFrame(long unsigned int rxId, unsigned char len, unsigned char *rxBuf);
+        void buildCanDispatchTable();
+        void handleConveyorFrame(StepperMotorState* conveyor, unsigned char len, unsigned char *rxBuf);
+        void decodePositionFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf);
+        void decodeDiagnosticsFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf);
+        void decodeFirmwareVersionFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf);
+        void decodeConveyorStateFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf);
         void hardwareControlWrite();
+        void writeGroupPositionCommand();
+        void updateGroupPositionSupport();
         void hardwareControlCheckConnection();
+        void publishJointState();
+        void applyJointCommand();
         void resetHardwareControlLoopRates();
+        int scanMotors();
+        bool receiveLoopShouldRun();
+        void waitReceiveLoopPaused();
 
         std::shared_ptr<std::thread> hardware_control_loop_thread;
+        std::shared_ptr<std::thread> hardware_receive_loop_thread;
+
+        // receive loop pause handshake (scan and calibration read frames themselves)
+        std::atomic<bool> rx_pause_requested;
+        bool rx_paused; // receive loop is parked and will not read frames (rx_pause_mutex)
+        std::mutex rx_pause_mutex;
+        std::condition_variable rx_pause_cv;
 
         StepperMotorState m1;
         StepperMotorState m2;
@@ -209,6 +307,7 @@ class CanCommunication {
         // conversions steps <-> rad angle
         int32_t rad_pos_to_steps(double position_rad, double gear_ratio, double direction);
         double steps_to_rad_pos(int32_t steps, double gear_ratio, double direction);
+        double steps_to_rad_vel(double steps_per_sec, double gear_ratio, double direction);
 
 
 };
@@ -0,0 +1,65 @@
+/*
+    can_transport.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_CAN_TRANSPORT_H
+#define NIRYO_CAN_TRANSPORT_H
+
+#include "mcp_can_rpi/mcp_can_rpi.h"
+
+#define CAN_TRANSPORT_MCP2515   "mcp2515"   // MCP2515 driven from user space (spidev + gpio)
+#define CAN_TRANSPORT_SOCKETCAN "socketcan" // kernel network interface (mcp251x, USB adapter, vcan)
+
+/*
+ * Frame level access to the stepper bus, used by NiryoCanDriver
+ * - frames use CAN_FRAME (id with 0x80000000 ext flag and 0x40000000 rtr flag)
+ * - functions return CAN_OK / CAN_* codes from mcp_can_dfs_rpi.h
+ * - NiryoCanDriver serializes calls, except waitForInterrupt() and notifyInterrupt()
+ */
+class CanTransport
+{
+    public:
+
+        virtual ~CanTransport() { }
+
+        virtual INT8U setup() = 0;                  // open device
+        virtual bool setupInterruptEvent() = 0;     // allows waitForInterrupt()
+        virtual INT8U init(bool tx_queue_enabled, bool tx_interrupt_enabled) = 0;
+
+        virtual bool canReadData() = 0;
+
+        // returns the number of frames read, rx_times (if not NULL) gets reception time in seconds
+        virtual INT8U readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times) = 0;
+
+        virtual INT8U waitForInterrupt(int timeout_ms) = 0;
+        virtual void notifyInterrupt() = 0;
+
+        virtual INT8U sendMsg(INT32U id, INT8U len, INT8U *buf) = 0;   // waits until sent
+        virtual INT8U queueMsg(INT32U id, INT8U len, INT8U *buf) = 0;  // sent on next flushTxQueue()
+        virtual INT8U flushTxQueue() = 0;
+        virtual INT8U serviceTxQueue() = 0;
+        virtual INT32U getTxErrorCount() = 0;
+
+        // controller error counters (REC / TEC), last known values
+        virtual void getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count) = 0;
+
+        // frames from this id must be received (other CAN devices, id >= 0x20)
+        virtual void addRxFilter(INT32U id) = 0;
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    command_latency.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_COMMAND_LATENCY_H
+#define NIRYO_COMMAND_LATENCY_H
+
+#include <rclcpp/rclcpp.hpp>
+#include <atomic>
+#include <stdint.h>
+
+#include "niryo_one_driver/joint_state_buffer.h"
+#include "niryo_one_driver/hw_statistics.h"
+
+#define COMMAND_LATENCY_PROBE_TIMEOUT 1.0 // s, probes not reached by then are counted as timed out
+
+/*
+ * Command to feedback latency of the axes of one bus (measure_command_latency parameter)
+ * - write() thread : stampCommand() gives a sequence number and time to each published command
+ * - control loop thread : a changed axis command starts a probe (one at a time per axis),
+ *   the probe is armed when the position command is sent on the bus ("command to bus")
+ * - joint state publisher thread : probe is reached when position feedback gets to the command
+ *   (within tolerance, coming from previous command side) ("command to feedback")
+ * - read() thread : first read() returning that feedback ("command to read")
+ * Each stage has one writer thread, probes are handed over with acquire / release sequence numbers.
+ * Without feedback from a motor (disabled, not connected), its axis probes stay armed.
+ */
+class CommandLatencyProbe {
+
+    public:
+
+        CommandLatencyProbe();
+
+        void init(rclcpp::Node::SharedPtr node, int first_axis, int axis_count);
+        bool isEnabled() const { return enabled; }
+
+        void stampCommand(JointCommandSnapshot &cmd);
+        void onCommandApplied(const JointCommandSnapshot &cmd);
+        void onCommandSent();
+        void onFeedback(JointStateSnapshot &state);
+        void onRead(const JointStateSnapshot &state);
+
+        void report(HwStatisticsReport &report);
+
+    private:
+
+        struct AxisProbe {
+            // control loop thread
+            double last_command = 0.0;
+            bool has_last_command = false;
+            bool pending = false; // started, position command not sent yet
+            uint32_t pending_sequence = 0;
+
+            // written by control loop thread before arming, read by joint state publisher thread
+            double target = 0.0;
+            double direction = 1.0; // +1 / -1 : side the feedback comes from
+            uint64_t stamp_ns = 0;
+
+            std::atomic<uint32_t> armed_sequence;     // control loop thread
+            std::atomic<uint32_t> completed_sequence; // joint state publisher thread (reached or timed out)
+
+            // joint state publisher thread
+            uint32_t reached_sequence = 0;
+            uint64_t reached_stamp_ns = 0;
+
+            // read() thread
+            uint32_t read_sequence = 0;
+
+            LatencyHistogram command_to_bus;
+            LatencyHistogram command_to_feedback;
+            LatencyHistogram command_to_read;
+            StatCounter started;
+            StatCounter timed_out;
+
+            // report() reader side
+            HistogramWindow command_to_bus_window;
+            HistogramWindow command_to_feedback_window;
+            HistogramWindow command_to_read_window;
+
+            AxisProbe() : armed_sequence(0), completed_sequence(0) { }
+        };
+
+        bool enabled;
+        int first_axis;
+        int last_axis; // excluded
+        double tolerance; // rad
+        uint32_t sequence; // write() thread
+
+        AxisProbe axes[NIRYO_ONE_AXIS_COUNT];
+};
+
+#endif
@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 
+#include "niryo_one_driver/hw_statistics.h"
+
 
 class CommunicationBase {
 
@@ -39,6 +41,7 @@ class CommunicationBase {
         virtual void resumeHardwareControlLoop() = 0;
 
         virtual void getCurrentPosition(double pos[6]) = 0;
+        virtual void getCurrentState(double pos[6], double vel[6], double eff[6]) = 0;
 
         virtual void getCurrentGripperPosition(double& pos) = 0;
         virtual void getCurrentGripperEffort(double& eff) = 0;
@@ -51,6 +54,9 @@ class CommunicationBase {
         
         virtual void getFirmwareVersions(std::vector<std::string> &motor_names,
                 std::vector<std::string> &firmware_versions) = 0;
+
+        // hardware control loops timings and bus counters, one report per bus
+        virtual void getHardwareStatistics(std::vector<HwStatisticsReport> &reports) = 0;
         
         virtual void sendPositionToRobot(const double cmd[6]) = 0;
         virtual void activateLearningMode(bool activate) = 0;
@@ -23,6 +23,7 @@
 #include <rclcpp/rclcpp.hpp>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <queue>
 #include <unordered_map>
 
@@ -31,6 +32,11 @@
 #include "niryo_one_driver/xl320_driver.h"
 #include "niryo_one_driver/xl430_driver.h"
 #include "niryo_one_driver/hardware_parameters.h"
+#include "niryo_one_driver/joint_state_buffer.h"
+#include "niryo_one_driver/rt_control_loop.h"
+#include "niryo_one_driver/bus_job_queue.h"
+#include "niryo_one_driver/hw_statistics.h"
+#include "niryo_one_driver/command_latency.h"
 
 #define DXL_MOTOR_4_ID   2 // V2 - axis 4
 #define DXL_MOTOR_5_ID   3 // V2 - axis 5
@@ -62,7 +68,7 @@
 
 #define RADIAN_TO_DEGREE 57.295779513082320876798154814105
 
-#define TIME_TO_WAIT_IF_BUSY 0.0005
+#define TIME_TO_WAIT_IF_PAUSED 0.1 // seconds, control loop paused (woken up by a job or a restart)
 
 #define DXL_SCAN_OK                0
 #define DXL_SCAN_MISSING_MOTOR    -50 
@@ -77,6 +83,12 @@
 // according to xl-320 datasheet : 1 speed ~ 0.111 rpm ~ 1.8944 dxl position per second
 #define XL320_STEPS_FOR_1_SPEED 1.8944 // 0.111 * 1024 / 60
 
+// present speed / velocity units (rpm), present load is in 0.1 % of stall torque
+#define XL320_RPM_FOR_1_SPEED    0.111
+#define XL430_RPM_FOR_1_VELOCITY 0.229
+#define XL320_STALL_TORQUE       0.39 // N.m
+#define XL430_STALL_TORQUE       1.4  // N.m
+
 void sleep_for(double seconds);
 
 class DxlCommunication {
@@ -92,6 +104,10 @@ class DxlCommunication {
 
         void getCurrentPositionV1(double *axis_5_pos, double *axis_6_pos); 
         void getCurrentPositionV2(double *axis_4_pos, double *axis_5_pos, double *axis_6_pos); 
+        void getCurrentState(double pos[6], double vel[6], double eff[6]); // only fills dxl axes
+        void getBusTurnaroundTime(double *turnaround_time, double *max_turnaround_time);
+        void getMotorsResponseLatency(std::vector<std::string> &motor_names, std::vector<double> &latencies);
+        void getStatistics(HwStatisticsReport &report); // one reader thread
         
         void getHardwareStatus(bool *is_connection_ok, std::string &error_message,
                 int *calibration_needed, bool *calibration_in_progress,
@@ -152,9 +168,18 @@ class DxlCommunication {
         uint32_t rad_pos_to_xl430_pos(double position_rad);
         double   xl430_pos_to_rad_pos(uint32_t position_dxl);
 
+        double xl320_speed_to_rad_vel(uint32_t speed_dxl);
+        double xl430_velocity_to_rad_vel(uint32_t velocity_dxl);
+        double xl320_load_to_effort(uint32_t load_dxl);
+        double xl430_load_to_effort(uint32_t load_dxl);
+
         void hardwareControlLoop();
         void hardwareControlRead();
         void hardwareControlWrite();
+        int writeMotorsRegister(int reg, std::vector<uint8_t> &xl320_ids, std::vector<uint32_t> &xl320_data,
+                std::vector<uint8_t> &xl430_ids, std::vector<uint32_t> &xl430_data);
+        void publishJointState();
+        void applyJointCommand();
 
         void resetHardwareControlLoopRates();
 
@@ -169,6 +194,10 @@ class DxlCommunication {
         DxlMotorState tool; // V1 + V2
         std::vector<DxlMotorState*> motors;
 
+        // exchange with ros2_control read()/write() (one writer thread, one reader thread each)
+        TripleBuffer<JointStateSnapshot> joint_state_buffer;
+        TripleBuffer<JointCommandSnapshot> joint_command_buffer;
+
         // for hardware control
         
         bool is_dxl_connection_ok;
@@ -178,11 +207,15 @@ class DxlCommunication {
         
         bool is_tool_connected;
 
-        bool hw_control_loop_keep_alive;
-        bool hw_is_busy;
+        std::atomic<bool> hw_control_loop_keep_alive;
+        BusJobQueue bus_jobs; // owned by the control loop thread
+        DxlBusStatistics bus_stats;
+        LoopStatisticsWindow loop_stats_window;
+        CommandLatencyProbe command_latency;
         bool hw_limited_mode;
 
         double hw_control_loop_frequency;
+        RtThreadConfig rt_config;
 
         int xl320_hw_fail_counter_read;
         int xl430_hw_fail_counter_read;
@@ -203,6 +236,32 @@ class DxlCommunication {
         bool read_velocity_enable;
         bool read_torque_enable;
         bool read_hw_status_enable; // for temperature + voltage + hw_error
+        bool bulk_read_enabled;     // XL320 and XL430 read in the same bulk read instruction
+        bool bulk_write_enabled;    // XL320 and XL430 goals sent in the same bulk write instruction
+        int direction_control;      // DIRECTION_CONTROL_GPIO_SLEEP, DIRECTION_CONTROL_GPIO_DRAIN or DIRECTION_CONTROL_RS485
+        bool adaptive_timeout_enabled; // status packet timeout learned per motor
+        double timeout_percentile;
+        double timeout_margin;      // ms
+
+        // lists filled at each control loop cycle (members : capacity is kept, no allocation)
+        std::vector<uint8_t> xl320_id_list;
+        std::vector<uint8_t> xl430_id_list;
+        std::vector<DxlMotorState *> xl320_motor_list;
+        std::vector<DxlMotorState *> xl430_motor_list;
+
+        std::vector<uint8_t> bulk_id_list;
+        std::vector<DxlMotorState *> bulk_motor_list;
+        std::vector<DxlDriver *> bulk_driver_list;
+
+        std::vector<uint8_t> bulk_write_id_list;
+        std::vector<DxlDriver *> bulk_write_driver_list;
+        std::vector<uint32_t> bulk_write_data_list;
+
+        std::vector<uint32_t> read_position_list;
+        std::vector<uint32_t> read_velocity_list;
+        std::vector<uint32_t> read_torque_list;
+        std::vector<uint32_t> xl320_position_list;
+        std::vector<uint32_t> xl430_position_list;
 
         bool write_position_enable;
         bool write_velocity_enable;
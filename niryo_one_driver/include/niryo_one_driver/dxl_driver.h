@@ -26,8 +26,10 @@
 */
 
 #include "dynamixel_sdk/dynamixel_sdk.h"
+#include "niryo_one_driver/hw_statistics.h"
 #include <vector>
 #include <thread>
+#include <memory>
 
 #define DXL_LEN_ONE_BYTE   1
 #define DXL_LEN_TWO_BYTES  2
@@ -39,6 +41,9 @@
 
 #define PING_WRONG_MODEL_NUMBER     30
 
+// consecutive failed fast reads before falling back on sync/bulk read for those motors
+#define DXL_FAST_READ_MAX_FAIL      3
+
 // Communication Result (dynamixel_sdk)
 //#define COMM_SUCCESS        0       // tx or rx packet communication success
 //#define COMM_PORT_BUSY      -1000   // Port is busy (in use)                    
@@ -61,12 +66,73 @@
 
 //#define ERRBIT_ALERT 128 //When the device has a problem, this bit is set to 1. Check "Device Status Check" value.
 
+/*
+ * One register inside a contiguous window read by syncReadBlock
+ */
+struct DxlBlockField {
+    uint8_t address;
+    uint8_t len; // DXL_LEN_ONE_BYTE, DXL_LEN_TWO_BYTES or DXL_LEN_FOUR_BYTES
+};
+
+/*
+ * Register window holding present position, velocity and load (depends on motor model)
+ */
+struct DxlStateBlock {
+    uint8_t address;
+    uint8_t len;
+    DxlBlockField position;
+    DxlBlockField velocity;
+    DxlBlockField load;
+};
+
+// registers written with bulk write (index in DxlWriteRegisters::field)
+#define DXL_WRITE_TORQUE_ENABLE     0
+#define DXL_WRITE_GOAL_POSITION     1
+#define DXL_WRITE_GOAL_VELOCITY     2
+#define DXL_WRITE_REGISTER_COUNT    3
+
+/*
+ * Address and length of the registers written with bulk write (depends on motor model)
+ */
+struct DxlWriteRegisters {
+    DxlBlockField field[DXL_WRITE_REGISTER_COUNT];
+};
+
 class DxlDriver {
 
     protected:
         dynamixel::PortHandler *portHandler;
         dynamixel::PacketHandler *packetHandler;
 
+        // group objects reused across calls (no allocation in control loop)
+        std::vector<std::unique_ptr<dynamixel::GroupSyncRead> > group_sync_read_list;
+        std::vector<std::unique_ptr<dynamixel::GroupSyncWrite> > group_sync_write_list;
+        std::unique_ptr<dynamixel::GroupBulkRead> group_bulk_read;
+        std::vector<DxlDriver *> group_bulk_read_driver_list;
+        std::unique_ptr<dynamixel::GroupBulkWrite> group_bulk_write_list[DXL_WRITE_REGISTER_COUNT];
+        std::vector<DxlDriver *> group_bulk_write_driver_list[DXL_WRITE_REGISTER_COUNT];
+
+        // Fast Sync Read / Fast Bulk Read support of each id (-1 : not detected yet)
+        bool fast_read_enabled;
+        int8_t fast_read_support[256];
+        // fast read failures in a row, per group : a failing group does not disable fast read for the others
+        std::vector<int> group_sync_read_fast_read_fails; // same index as group_sync_read_list
+        int group_bulk_read_fast_read_fails;
+
+        DxlBusStatistics *statistics; // not owned, NULL : not recorded
+
+        int &getFastReadFailCounter (dynamixel::GroupSyncRead *group);
+        int &getFastReadFailCounter (dynamixel::GroupBulkRead *group);
+        template <typename Group>
+        int groupReadTxRx (Group *group);
+        template <typename Group>
+        void recordGroupRead (Group *group, int result);
+        void recordResult (uint8_t id, int result) { if (statistics != NULL) { statistics->recordResult(id, result); } }
+
+        dynamixel::GroupSyncRead  *getGroupSyncRead  (uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list);
+        dynamixel::GroupSyncWrite *getGroupSyncWrite (uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list);
+
+        int syncWrite       (uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list);
         int syncWrite1Byte  (uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list);
         int syncWrite2Bytes (uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list);
         int syncWrite4Bytes (uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list);
@@ -75,6 +141,8 @@ class DxlDriver {
         int read2Bytes      (uint8_t address, uint8_t id, uint32_t *data);
         int read4Bytes      (uint8_t address, uint8_t id, uint32_t *data);
         int syncRead        (uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list);
+        int syncReadBlock   (uint8_t address, uint8_t block_len, std::vector<uint8_t> &id_list,
+                             const DxlBlockField *fields, std::vector<uint32_t> **data_lists, int field_count);
 
     public:
         DxlDriver(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler);
@@ -84,6 +152,13 @@ class DxlDriver {
         int getModelNumber(uint8_t id, uint16_t *dxl_model_number);
         int reboot(uint8_t id);
 
+        // use Fast Sync Read / Fast Bulk Read when all motors of a read support it (detected from model and firmware)
+        void setFastReadEnabled(bool enabled) { fast_read_enabled = enabled; }
+        bool isFastReadSupported(uint8_t id);
+
+        // status packet results of each id (ping, read, sync/bulk read)
+        void setStatistics(DxlBusStatistics *statistics) { this->statistics = statistics; }
+
         /*
          * Virtual functions below - to override
          *
@@ -91,6 +166,7 @@ class DxlDriver {
          */
 
         virtual int checkModelNumber(uint8_t id) = 0;
+        virtual bool supportsFastRead(uint16_t model_number, uint32_t firmware_version) = 0;
 
         // eeprom write
         virtual int changeId            (uint8_t id, uint8_t new_id) = 0;
@@ -102,6 +178,7 @@ class DxlDriver {
         virtual int setAlarmShutdown    (uint8_t id, uint32_t alarm_shutdown) = 0;
 
         // eeprom read
+        virtual int readFirmwareVersion  (uint8_t id, uint32_t *firmware_version) = 0;
         virtual int readReturnDelayTime  (uint8_t id, uint32_t *return_delay_time) = 0;
         virtual int readLimitTemperature (uint8_t id, uint32_t *limit_temperature) = 0;
         virtual int readMaxTorque        (uint8_t id, uint32_t *max_torque) = 0;
@@ -135,6 +212,23 @@ class DxlDriver {
         virtual int syncReadTemperature    (std::vector<uint8_t> &id_list, std::vector<uint32_t> &temperature_list) = 0;
         virtual int syncReadVoltage        (std::vector<uint8_t> &id_list, std::vector<uint32_t> &voltage_list) = 0;
         virtual int syncReadHwErrorStatus  (std::vector<uint8_t> &id_list, std::vector<uint32_t> &hw_error_list) = 0;
+
+        // position, velocity and load in one transaction (contiguous registers)
+        virtual const DxlStateBlock& getStateBlock() = 0;
+
+        int syncReadState (std::vector<uint8_t> &id_list, std::vector<uint32_t> &position_list,
+                           std::vector<uint32_t> &velocity_list, std::vector<uint32_t> &load_list);
+
+        // same for motors of different models, in one bulk read (driver_list : driver of each id)
+        int bulkReadState (std::vector<uint8_t> &id_list, std::vector<DxlDriver *> &driver_list,
+                           std::vector<uint32_t> &position_list, std::vector<uint32_t> &velocity_list,
+                           std::vector<uint32_t> &load_list);
+
+        virtual const DxlWriteRegisters& getWriteRegisters() = 0;
+
+        // write register reg (DXL_WRITE_...) on motors of different models, in one bulk write
+        int bulkWrite (int reg, std::vector<uint8_t> &id_list, std::vector<DxlDriver *> &driver_list,
+                       std::vector<uint32_t> &data_list);
 };
 
 #endif
@@ -21,6 +21,7 @@
 #define NIRYO_DXL_MOTOR_STATE_H
 
 #include <string>
+#include "niryo_one_driver/tracing.h"
 
 #define TOOL_STATE_PING_OK       0x01
 #define TOOL_STATE_PING_ERROR    0x02
@@ -97,7 +98,10 @@ class DxlMotorState {
         uint32_t getHardwareErrorState() { return state_hw_error; }
 
         // setters - state
-        void setPositionState(uint32_t pos)      { state_pos = pos; }
+        void setPositionState(uint32_t pos) {
+            state_pos = pos;
+            NIRYO_TRACEPOINT(set_position_state, 1, id, pos);
+        }
         void setVelocityState(uint32_t vel)      { state_vel = vel; }
         void setTorqueState(uint32_t torque)     { state_torque = torque; }
         void setTemperatureState(uint32_t temp)  { state_temperature = temp; }
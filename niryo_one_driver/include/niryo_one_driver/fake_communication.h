@@ -44,6 +44,7 @@ class FakeCommunication : public CommunicationBase {
         void resumeHardwareControlLoop();
 
         void getCurrentPosition(double pos[6]);
+        void getCurrentState(double pos[6], double vel[6], double eff[6]);
         void getCurrentGripperPosition(double& pos);
         void getCurrentGripperEffort(double& eff);
         
@@ -55,6 +56,7 @@ class FakeCommunication : public CommunicationBase {
         
         void getFirmwareVersions(std::vector<std::string> &motor_names,
                 std::vector<std::string> &firmware_versions);
+        void getHardwareStatistics(std::vector<HwStatisticsReport> &reports);
         
         void sendPositionToRobot(const double cmd[6]); 
 
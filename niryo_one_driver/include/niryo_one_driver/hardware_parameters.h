@@ -125,11 +125,37 @@ public:
     float dxl_hw_write_frequency=                  50.0;
     float dxl_hw_data_read_frequency=              15.0;
     float dxl_hw_status_read_frequency=            0.5;
+    bool dxl_bulk_read_enabled=                    true;
+    bool dxl_bulk_write_enabled=                   true;
+    bool dxl_fast_read_enabled=                    false;
+    std::string dxl_direction_control=             "gpio_sleep";
+    bool dxl_adaptive_timeout_enabled=             true;
+    float dxl_timeout_percentile=                  0.99;
+    float dxl_timeout_margin=                      1.0;
 
     float can_hardware_control_loop_frequency=     1500.0;
     float can_hw_write_frequency=                  50.0;
     float can_hw_check_connection_frequency=       3.0;
-
+    bool can_interrupt_rx_enabled=                 false;
+    float can_interrupt_rx_control_loop_frequency= 100.0;
+    bool can_tx_queue_enabled=                     true;
+    bool can_group_position_enabled=               false;
+
+    bool rt_enabled=                               false;
+    bool rt_lock_memory=                           true;
+    int can_rt_priority=                           80;
+    int can_rt_cpu=                                3;
+    int can_rx_rt_priority=                        81;
+    int can_rx_rt_cpu=                             3;
+    int dxl_rt_priority=                           79;
+    int dxl_rt_cpu=                                2;
+
+    bool measure_command_latency=                  false;
+    float command_latency_tolerance=               0.005;
+
+    std::string can_transport=        "mcp2515";
+    std::string can_socket_interface= "can0";
+    std::string can_rx_filter_profile="extended";
     int spi_channel=          0;
     long spi_baudrate=        1000000;
     int gpio_can_interrupt=   25;
@@ -0,0 +1,189 @@
+/*
+    hw_statistics.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_HW_STATISTICS_H
+#define NIRYO_HW_STATISTICS_H
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Log-linear buckets (HDR style) : values below 2^SUB_BUCKET_BITS are exact, then each
+ * power of 2 is split in 2^SUB_BUCKET_BITS buckets (relative error < 12.5 %)
+ */
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_MAX_EXPONENT    24 // values are clamped to 2^24 us (16.7 s)
+#define HISTOGRAM_BUCKET_COUNT    ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS)
+
+#define CAN_STAT_MOTOR_ID_COUNT     16 // id & 0x0F
+#define CAN_STAT_CONTROL_BYTE_COUNT 32 // first data byte (CAN_CMD_* / CAN_DATA_*)
+#define DXL_STAT_ID_COUNT           256
+
+/*
+ * Hot loop instrumentation : fixed memory, no lock, no allocation
+ * - each object has one writer at a time (control loop thread, or callers serialized
+ *   by a bus lock), writes are relaxed load + store (no read-modify-write)
+ * - any thread can read, values are eventually consistent
+ */
+
+inline uint64_t statClockNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+class StatCounter {
+
+    public:
+
+        StatCounter() : value(0) { }
+
+        void increment(uint32_t n = 1) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        void set(uint32_t v) { value.store(v, std::memory_order_relaxed); }
+        uint32_t get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+
+        std::atomic<uint32_t> value; // wraps around, readers use differences
+};
+
+/*
+ * Bucket counts copied from a LatencyHistogram, all values in microseconds
+ */
+struct HistogramSnapshot {
+    uint32_t counts[HISTOGRAM_BUCKET_COUNT] = {0};
+    uint32_t count = 0;
+
+    void subtract(const HistogramSnapshot &previous); // keeps values recorded since previous
+    uint32_t percentile(double quantile) const;       // upper bound of the bucket, 0 if empty
+};
+
+class LatencyHistogram {
+
+    public:
+
+        LatencyHistogram();
+
+        void record(uint32_t value_us);
+
+        // records (now - start_ns) and returns now, to chain stages with one clock read each
+        uint64_t recordSince(uint64_t start_ns) {
+            uint64_t now = statClockNs();
+            record((uint32_t) ((now - start_ns) / 1000));
+            return now;
+        }
+
+        void snapshot(HistogramSnapshot &snapshot) const;
+        uint32_t getMax() const { return max_value.load(std::memory_order_relaxed); } // since start
+
+        static int bucketIndex(uint32_t value_us);
+        static uint32_t bucketUpperBound(int index);
+
+    private:
+
+        std::atomic<uint32_t> counts[HISTOGRAM_BUCKET_COUNT];
+        std::atomic<uint32_t> max_value;
+};
+
+/*
+ * Durations of one hardware control loop
+ */
+struct LoopStatistics {
+    LatencyHistogram cycle;            // whole cycle (without sleep)
+    LatencyHistogram read;             // hardwareControlRead
+    LatencyHistogram write;            // hardwareControlWrite
+    LatencyHistogram check_connection; // hardwareControlCheckConnection (CAN only)
+    StatCounter cycle_count;
+    StatCounter overrun_count;         // cycles longer than the loop period
+
+    void recordCycle(uint64_t start_ns, uint64_t end_ns, double loop_frequency);
+};
+
+struct CanBusStatistics {
+    LoopStatistics loop;
+    StatCounter frames_in[CAN_STAT_MOTOR_ID_COUNT][CAN_STAT_CONTROL_BYTE_COUNT];
+    StatCounter frames_out[CAN_STAT_MOTOR_ID_COUNT][CAN_STAT_CONTROL_BYTE_COUNT];
+    StatCounter other_frames_in;  // other CAN devices, empty or unknown control byte
+    StatCounter other_frames_out;
+    StatCounter send_failures;    // sendCanFrame() result != CAN_OK
+
+    void recordFrame(StatCounter (&frames)[CAN_STAT_MOTOR_ID_COUNT][CAN_STAT_CONTROL_BYTE_COUNT],
+            StatCounter &other_frames, unsigned long id, unsigned char len, const unsigned char *data);
+};
+
+/*
+ * Status packets expected from one Dynamixel id (ping, read, sync/bulk read)
+ */
+struct DxlMotorStatistics {
+    StatCounter transactions;
+    StatCounter rx_timeout; // COMM_RX_TIMEOUT
+    StatCounter rx_corrupt; // COMM_RX_CORRUPT
+    StatCounter other_errors;
+};
+
+struct DxlBusStatistics {
+    LoopStatistics loop;
+    DxlMotorStatistics motors[DXL_STAT_ID_COUNT]; // failed group reads not attributed to an id : broadcast id
+
+    void recordResult(uint8_t id, int result);
+};
+
+/*
+ * Name / value pairs of one bus, published as one diagnostic status
+ */
+struct HwStatisticsReport {
+    std::string name;
+    std::vector<std::pair<std::string, std::string> > values;
+};
+
+/*
+ * Reader side of a histogram : percentiles over the window since last call
+ */
+class HistogramWindow {
+
+    public:
+
+        void report(const std::string &name, const LatencyHistogram &histogram, HwStatisticsReport &report);
+
+    private:
+
+        HistogramSnapshot last;
+        HistogramSnapshot current;
+};
+
+class LoopStatisticsWindow {
+
+    public:
+
+        void report(const LoopStatistics &loop, HwStatisticsReport &report);
+
+    private:
+
+        HistogramWindow cycle;
+        HistogramWindow read;
+        HistogramWindow write;
+        HistogramWindow check_connection;
+};
+
+#endif
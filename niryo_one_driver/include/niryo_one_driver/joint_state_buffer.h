@@ -0,0 +1,103 @@
+/*
+    joint_state_buffer.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_JOINT_STATE_BUFFER_H
+#define NIRYO_JOINT_STATE_BUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+#define NIRYO_ONE_AXIS_COUNT 6
+
+/*
+ * Joint values exchanged between a bus control loop (CAN or DXL) and
+ * the ros2_control read()/write(). Each bus only fills its own axes.
+ */
+struct JointStateSnapshot {
+    double position[NIRYO_ONE_AXIS_COUNT] = {0}; // rad
+    double velocity[NIRYO_ONE_AXIS_COUNT] = {0}; // rad/s
+    double effort[NIRYO_ONE_AXIS_COUNT] = {0};   // N.m (0 if not available)
+
+    // last command reached by position feedback (command latency measurement only)
+    uint32_t command_sequence[NIRYO_ONE_AXIS_COUNT] = {0};
+    uint64_t command_stamp_ns[NIRYO_ONE_AXIS_COUNT] = {0};
+};
+
+struct JointCommandSnapshot {
+    double position[NIRYO_ONE_AXIS_COUNT] = {0};
+
+    // given by write() (command latency measurement only, 0 otherwise)
+    uint32_t sequence = 0;
+    uint64_t stamp_ns = 0;
+};
+
+/*
+ * Triple buffer : one writer thread, one reader thread, none of them waits.
+ * - writer fills writeBuffer(), then publish() swaps it with the middle buffer
+ * - reader calls update() to swap the middle buffer in, if a new one was published
+ * The reader always gets a whole published value (no torn read across axes).
+ */
+template <typename T>
+class TripleBuffer {
+
+    public:
+
+        TripleBuffer() : write_index(0), middle(1), read_index(2) { }
+
+        // writer side
+        T& writeBuffer() { return buffers[write_index]; }
+
+        void publish() {
+            write_index = middle.exchange(write_index | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        void write(const T& value) {
+            buffers[write_index] = value;
+            publish();
+        }
+
+        // reader side, returns true if a new value has been published since last update
+        bool update() {
+            if ((middle.load(std::memory_order_relaxed) & FRESH_FLAG) == 0) {
+                return false;
+            }
+            read_index = middle.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        const T& readBuffer() const { return buffers[read_index]; }
+
+        bool read(T& value) {
+            bool fresh = update();
+            value = buffers[read_index];
+            return fresh;
+        }
+
+    private:
+
+        static const int INDEX_MASK = 0x03;
+        static const int FRESH_FLAG = 0x04;
+
+        T buffers[3];
+        int write_index;          // only used by writer
+        std::atomic<int> middle;  // index of last published buffer + FRESH_FLAG
+        int read_index;           // only used by reader
+};
+
+#endif
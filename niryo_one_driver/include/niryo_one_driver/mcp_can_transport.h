@@ -0,0 +1,78 @@
+/*
+    mcp_can_transport.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_MCP_CAN_TRANSPORT_H
+#define NIRYO_MCP_CAN_TRANSPORT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "niryo_one_driver/can_transport.h"
+
+#define CAN_RX_FILTER_ALL      "all"      // masks and filters disabled, every frame on the bus raises INT
+#define CAN_RX_FILTER_ARM      "arm"      // only Niryo ids, in both RX buffers
+#define CAN_RX_FILTER_EXTENDED "extended" // Niryo ids in RXB0, ids given to addRxFilter() in RXB1
+
+#define MCP_NIRYO_ID_MASK     0x7E0 // ids 0x00 - 0x1F are reserved for Niryo One core communication
+#define MCP_NIRYO_ID_FILTER   0x000
+#define MCP_RXB1_FILTER_COUNT 4     // RXF2 - RXF5
+
+/*
+ * MCP2515 on the Raspberry Pi SPI bus, INT line on a gpio
+ * - acceptance masks and filters depend on rx filter profile (CAN_RX_FILTER_*)
+ * - with rollover, Niryo frames still go to RXB1 when RXB0 is full
+ */
+class McpCanTransport : public CanTransport
+{
+    public:
+
+        McpCanTransport(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt,
+                std::string rx_filter_profile);
+
+        INT8U setup();
+        bool setupInterruptEvent();
+        INT8U init(bool tx_queue_enabled, bool tx_interrupt_enabled);
+
+        bool canReadData();
+        INT8U readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times);
+
+        INT8U waitForInterrupt(int timeout_ms);
+        void notifyInterrupt();
+
+        INT8U sendMsg(INT32U id, INT8U len, INT8U *buf);
+        INT8U queueMsg(INT32U id, INT8U len, INT8U *buf);
+        INT8U flushTxQueue();
+        INT8U serviceTxQueue();
+        INT32U getTxErrorCount();
+        void getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count);
+
+        void addRxFilter(INT32U id);
+
+    private:
+
+        INT8U applyRxFilters();
+
+        std::unique_ptr<MCP_CAN> mcp_can;
+
+        std::string rx_filter_profile;
+        std::vector<INT32U> device_ids; // standard ids for RXB1 (extended profile)
+        bool is_initialized;
+};
+
+#endif
@@ -21,8 +21,11 @@
 #define NIRYO_CAN_DRIVER_H
 
 #include <rclcpp/rclcpp.hpp>
-#include "mcp_can_rpi/mcp_can_rpi.h"
+#include "niryo_one_driver/can_transport.h"
+#include "niryo_one_driver/hw_statistics.h"
+#include <memory>
 #include <unistd.h>
+#include <mutex>
 
 #define CAN_CMD_POSITION     0x03
 #define CAN_CMD_TORQUE       0x04
@@ -34,6 +37,9 @@
 #define CAN_CMD_MAX_EFFORT   0x17
 #define CAN_CMD_MOVE_REL     0x18
 #define CAN_CMD_RESET        0x19 // not yet implemented
+#define CAN_CMD_GROUP_POSITION 0x1A // positions of consecutive motor ids, sent on broadcast id
+
+#define CAN_GROUP_POSITION_MAX_MOTORS 2 // 24-bit positions per 8-byte frame
 
 #define CAN_DATA_CONVEYOR_STATE 0x07
 #define CAN_DATA_POSITION    0x03
@@ -57,23 +63,54 @@ class NiryoCanDriver
 {
     private:
 
-        std::shared_ptr<MCP_CAN> mcp_can;
+        std::unique_ptr<CanTransport> transport;
 
         rclcpp::Node::SharedPtr node;
 
+        // transport may be accessed from the rx thread and the control loop at the same time
+        std::mutex bus_mutex;
+
+        // frames are queued and loaded in free MCP2515 TX buffers (or socket queue), without waiting for transmission
+        bool tx_queue_enabled;
+        bool tx_interrupt_enabled;
+        bool tx_batch_open; // queued frames are only flushed by endTxBatch()
+
+        CanBusStatistics *statistics; // not owned, NULL : sent frames not counted
+
+        INT8U sendCanFrame(int id, INT8U len, uint8_t *data);
+
 
     public:
 
-        NiryoCanDriver(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt);
+        NiryoCanDriver(CanTransport *transport); // owns transport
 
-        bool setupInterruptGpio();
-        bool setupSpi();
+        INT8U setup();
         INT8U init();
         bool canReadData();
         INT8U readMsgBuf(INT32U *id, INT8U *len, INT8U *buf);
+        INT8U readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times = NULL);
+        void addRxFilter(INT32U id);
+
+        // interrupt driven reception
+        bool setupInterruptEvent();
+        INT8U waitForInterrupt(int timeout_ms);
+        void notifyInterrupt();
+
+        // asynchronous transmission (applied on next init())
+        void setTxQueue(bool enabled, bool use_interrupt);
+        INT8U serviceTxQueue();
+        INT32U getTxErrorCount();
+        void getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count);
+
+        void setStatistics(CanBusStatistics *statistics);
+
+        // frames sent between begin and end are flushed together (one sendmmsg / SPI chain)
+        void beginTxBatch();
+        INT8U endTxBatch();
 
 
         INT8U sendPositionCommand(int id, int cmd);
+        INT8U sendGroupPositionCommand(int id, int first_motor_id, int motor_count, int *cmds);
         INT8U sendRelativeMoveCommand(int id, int steps, int delay);
         INT8U sendTorqueOnCommand(int id, int torque_on);
         INT8U sendPositionOffsetCommand(int id, int cmd, int absolute_steps_at_offset_position);
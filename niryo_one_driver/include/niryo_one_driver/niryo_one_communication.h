@@ -49,6 +49,7 @@ class NiryoOneCommunication : public CommunicationBase {
         void resumeHardwareControlLoop();
 
         void getCurrentPosition(double pos[6]);
+        void getCurrentState(double pos[6], double vel[6], double eff[6]);
 
         void getCurrentGripperPosition(double& pos);
         void getCurrentGripperEffort(double& eff);
@@ -61,6 +62,7 @@ class NiryoOneCommunication : public CommunicationBase {
 
         void getFirmwareVersions(std::vector<std::string> &motor_names,
                 std::vector<std::string> &firmware_versions);
+        void getHardwareStatistics(std::vector<HwStatisticsReport> &reports);
         
         void sendPositionToRobot(const double cmd[6]); 
         void activateLearningMode(bool activate);
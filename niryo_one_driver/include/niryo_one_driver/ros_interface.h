@@ -48,6 +48,7 @@
 #include "std_msgs/msg/bool.hpp"
 #include "std_msgs/msg/int8_multi_array.hpp"
 #include "niryo_one_msgs/msg/conveyor_feedback.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 
 void sleep_for(double seconds);
 
@@ -87,6 +88,9 @@ class RosInterface {
         rclcpp::Publisher<niryo_one_msgs::msg::HardwareStatus>::SharedPtr hardware_status_publisher;
         std::shared_ptr<std::thread> publish_hardware_status_thread;
 
+        rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr hardware_statistics_publisher;
+        std::shared_ptr<std::thread> publish_hardware_statistics_thread;
+
         rclcpp::Publisher<niryo_one_msgs::msg::SoftwareVersion>::SharedPtr software_version_publisher;
         std::shared_ptr<std::thread> publish_software_version_thread;
 
@@ -105,6 +109,7 @@ class RosInterface {
         // publish methods
 
         void publishHardwareStatus();
+        void publishHardwareStatistics();
         void publishSoftwareVersion();
         void publishLearningMode(); 
         void publishConveyor1Feedback();
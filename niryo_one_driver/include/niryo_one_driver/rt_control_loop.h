@@ -0,0 +1,84 @@
+/*
+    rt_control_loop.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_RT_CONTROL_LOOP_H
+#define NIRYO_RT_CONTROL_LOOP_H
+
+#include <rclcpp/rclcpp.hpp>
+#include <string>
+#include <stdint.h>
+#include <time.h>
+
+#define RT_STACK_PREFAULT_SIZE (256 * 1024) // bytes of stack touched once the thread is locked in memory
+#define RT_OVERRUN_LOG_PERIOD  5.0          // seconds between two overrun warnings
+
+/*
+ * Real-time profile of a hardware control thread (all disabled by default)
+ */
+struct RtThreadConfig {
+    bool enabled = false;     // absolute deadline pacing + settings below
+    int priority = 0;         // SCHED_FIFO priority (1-99), 0 keeps SCHED_OTHER
+    int cpu = -1;             // cpu affinity, -1 for any cpu
+    bool lock_memory = false; // mlockall + pre-faulted stack
+};
+
+/*
+ * Reads <prefix>_rt_priority and <prefix>_rt_cpu (plus shared rt_enabled and rt_lock_memory)
+ */
+void getRtThreadConfig(rclcpp::Node::SharedPtr node, const std::string &prefix, RtThreadConfig &config);
+
+/*
+ * Applies config to the calling thread
+ * - each setting that can't be applied (no RT privileges, bad cpu) is skipped with a warning
+ * - returns false if at least one setting was skipped
+ */
+bool setupRtThread(const std::string &thread_name, const RtThreadConfig &config);
+
+/*
+ * Loop pacing on absolute CLOCK_MONOTONIC deadlines (clock_nanosleep TIMER_ABSTIME)
+ * - a loop iteration is an overrun if its deadline already passed when sleep() is called,
+ *   next deadline is then taken from now (missed periods are skipped, not caught up)
+ */
+class RtLoopTimer {
+
+    public:
+
+        RtLoopTimer(const std::string &name, double frequency);
+
+        void reset();   // next deadline = now + period
+        bool sleep();   // returns false on overrun
+
+        uint64_t getLoopCount() const { return loop_count; }
+        uint64_t getOverrunCount() const { return overrun_count; }
+        double getMaxLateness() const { return max_lateness; } // seconds
+
+    private:
+
+        std::string name;
+        int64_t period_ns;
+        struct timespec next_deadline;
+
+        uint64_t loop_count;
+        uint64_t overrun_count;
+        uint64_t logged_overrun_count;
+        double max_lateness;
+        double time_last_overrun_log;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*
+    socket_can_transport.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_SOCKET_CAN_TRANSPORT_H
+#define NIRYO_SOCKET_CAN_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+
+#include "niryo_one_driver/can_transport.h"
+
+#define CAN_SOCKET_BATCH_SIZE 32      // frames moved by one recvmmsg / sendmmsg
+#define CAN_SOCKET_NIRYO_ID_MASK 0x7E0 // ids 0x00 - 0x1F are reserved for Niryo One core communication
+
+/*
+ * Stepper bus through a SocketCAN raw socket (can0 with kernel mcp251x driver, USB adapter, vcan0)
+ * - bitrate is set on the interface (ip link set can0 type can bitrate 1000000)
+ * - kernel filters only let Niryo ids (and ids given to addRxFilter()) through
+ * - frames are received and sent in batches, with kernel software rx timestamps
+ */
+class SocketCanTransport : public CanTransport
+{
+    public:
+
+        SocketCanTransport(std::string interface_name);
+        ~SocketCanTransport();
+
+        INT8U setup();
+        bool setupInterruptEvent();
+        INT8U init(bool tx_queue_enabled, bool tx_interrupt_enabled);
+
+        bool canReadData();
+        INT8U readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times);
+
+        INT8U waitForInterrupt(int timeout_ms);
+        void notifyInterrupt();
+
+        INT8U sendMsg(INT32U id, INT8U len, INT8U *buf);
+        INT8U queueMsg(INT32U id, INT8U len, INT8U *buf);
+        INT8U flushTxQueue();
+        INT8U serviceTxQueue();
+        INT32U getTxErrorCount();
+        void getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count);
+
+        void addRxFilter(INT32U id);
+
+    private:
+
+        bool applyRxFilters();
+        void encodeFrame(INT32U id, INT8U len, INT8U *buf, struct can_frame *frame);
+
+        std::string interface_name;
+        int socket_fd;
+        int wakeup_event_fd;
+        bool timestamping_enabled;
+
+        std::vector<struct can_filter> rx_filters;
+
+        // one message header (and control buffer for timestamp) per frame
+        struct can_frame rx_frames[CAN_SOCKET_BATCH_SIZE];
+        struct iovec rx_iov[CAN_SOCKET_BATCH_SIZE];
+        struct mmsghdr rx_msgs[CAN_SOCKET_BATCH_SIZE];
+        char rx_control[CAN_SOCKET_BATCH_SIZE][CMSG_SPACE(sizeof(struct scm_timestamping))];
+
+        struct can_frame tx_frames[CAN_SOCKET_BATCH_SIZE];
+        struct iovec tx_iov[CAN_SOCKET_BATCH_SIZE];
+        struct mmsghdr tx_msgs[CAN_SOCKET_BATCH_SIZE];
+        int tx_queue_count;
+        INT32U tx_error_count;
+        INT8U controller_rx_error_count; // from error frames (CAN_ERR_CRTL)
+        INT8U controller_tx_error_count;
+};
+
+#endif
@@ -20,6 +20,8 @@
 #ifndef NIRYO_STEPPER_MOTOR_STATE_H
 #define NIRYO_STEPPER_MOTOR_STATE_H
 
+#include "niryo_one_driver/tracing.h"
+
 
 #define CONVEYOR_STATE_SET_OK       200
 #define CONVEYOR_STATE_SET_ERROR       400
@@ -62,6 +64,9 @@ class StepperMotorState {
             state_temperature = 0;
             state_hw_error = 0;
             hw_fail_counter = 0;
+            vel_estimate = 0.0;
+            vel_estimate_last_pos = 0;
+            vel_estimate_last_time = 0.0;
         }
 
         void resetCommand() {
@@ -98,12 +103,30 @@ class StepperMotorState {
         int getHardwareErrorState() { return state_hw_error; }
 
         // setters - state
-        void setPositionState(int pos)     { state_pos = pos; }
+        void setPositionState(int pos) {
+            state_pos = pos;
+            NIRYO_TRACEPOINT(set_position_state, 0, id, pos);
+        }
         void setVelocityState(int vel)     { state_vel = vel; }
         void setTorqueState(int torque)    { state_torque = torque; }
         void setTemperatureState(int temp) { state_temperature = temp; }
         void setHardwareError(int error)   { state_hw_error = error; }
 
+        // velocity estimated from received positions (steps/s)
+        // finite difference between 2 position frames, then first order low-pass filter
+        double getVelocityEstimate()       { return vel_estimate; }
+        void updateVelocityEstimate(int pos, double time, double filter_alpha) {
+            if (time <= vel_estimate_last_time) {
+                return; // same frame batch
+            }
+            if (vel_estimate_last_time > 0.0) {
+                double vel = (double)(pos - vel_estimate_last_pos) / (time - vel_estimate_last_time);
+                vel_estimate += filter_alpha * (vel - vel_estimate);
+            }
+            vel_estimate_last_pos = pos;
+            vel_estimate_last_time = time;
+        }
+
         // getters - command
         int getPositionCommand()      {  return cmd_pos;}
         int getVelocityCommand()      { return cmd_vel; }
@@ -148,6 +171,9 @@ class StepperMotorState {
 
         int state_pos;
         int state_vel;
+        double vel_estimate;
+        int vel_estimate_last_pos;
+        double vel_estimate_last_time;
         int state_torque;
         int state_temperature;
         int state_hw_error;
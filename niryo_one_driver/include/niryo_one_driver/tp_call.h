@@ -0,0 +1,129 @@
+/*
+    tp_call.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * LTTng-UST event definitions for provider "niryo_one"
+ * - do not include directly, use NIRYO_TRACEPOINT() from tracing.h
+ * - probes are created in src/utils/tp_call.c
+ * - positions are in rad (joints) or in motor steps / dxl position units (motor state)
+ */
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER niryo_one
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "niryo_one_driver/tp_call.h"
+
+#if !defined(NIRYO_TP_CALL_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define NIRYO_TP_CALL_H
+
+#include <lttng/tracepoint.h>
+#include <stdint.h>
+
+// ros2_control read() : joint positions given to the controllers
+TRACEPOINT_EVENT(
+    niryo_one,
+    hw_interface_read,
+    TP_ARGS(
+        const double *, position_arg
+    ),
+    TP_FIELDS(
+        ctf_array(double, position, position_arg, 6)
+    )
+)
+
+// ros2_control write() : joint commands received from the controllers
+TRACEPOINT_EVENT(
+    niryo_one,
+    hw_interface_write,
+    TP_ARGS(
+        const double *, command_arg
+    ),
+    TP_FIELDS(
+        ctf_array(double, command, command_arg, 6)
+    )
+)
+
+// command handed to the bus control loops (skipped = 1 while calibrating)
+TRACEPOINT_EVENT(
+    niryo_one,
+    send_position_to_robot,
+    TP_ARGS(
+        const double *, command_arg,
+        int, skipped_arg
+    ),
+    TP_FIELDS(
+        ctf_array(double, command, command_arg, 6)
+        ctf_integer(int, skipped, skipped_arg)
+    )
+)
+
+// CAN frame written to the transport (result is CAN_OK or a CAN_* error)
+TRACEPOINT_EVENT(
+    niryo_one,
+    can_frame_tx,
+    TP_ARGS(
+        uint32_t, can_id_arg,
+        uint8_t, len_arg,
+        const uint8_t *, data_arg,
+        uint8_t, result_arg
+    ),
+    TP_FIELDS(
+        ctf_integer_hex(uint32_t, can_id, can_id_arg)
+        ctf_sequence_hex(uint8_t, data, data_arg, uint8_t, len_arg)
+        ctf_integer(uint8_t, result, result_arg)
+    )
+)
+
+// CAN frame read from the transport, rx_time is the reception time given by the transport (s)
+TRACEPOINT_EVENT(
+    niryo_one,
+    can_frame_rx,
+    TP_ARGS(
+        uint32_t, can_id_arg,
+        uint8_t, len_arg,
+        const uint8_t *, data_arg,
+        double, rx_time_arg
+    ),
+    TP_FIELDS(
+        ctf_integer_hex(uint32_t, can_id, can_id_arg)
+        ctf_sequence_hex(uint8_t, data, data_arg, uint8_t, len_arg)
+        ctf_float(double, rx_time, rx_time_arg)
+    )
+)
+
+// motor position stored in the motor state (bus : 0 = CAN stepper, 1 = Dynamixel)
+TRACEPOINT_EVENT(
+    niryo_one,
+    set_position_state,
+    TP_ARGS(
+        uint8_t, bus_arg,
+        uint8_t, motor_id_arg,
+        int32_t, position_arg
+    ),
+    TP_FIELDS(
+        ctf_integer(uint8_t, bus, bus_arg)
+        ctf_integer(uint8_t, motor_id, motor_id_arg)
+        ctf_integer(int32_t, position, position_arg)
+    )
+)
+
+#endif
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,37 @@
+/*
+    tracing.h
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NIRYO_TRACING_H
+#define NIRYO_TRACING_H
+
+/*
+ * LTTng tracepoints of the control cycle (provider "niryo_one"), same scheme as ros2 tracetools.
+ * Built with -DNIRYO_ONE_TRACING=ON only, otherwise NIRYO_TRACEPOINT() expands to nothing
+ * and its arguments are not evaluated. Events are declared in tp_call.h.
+ */
+#ifdef NIRYO_ONE_TRACING_ENABLED
+#include "niryo_one_driver/tp_call.h"
+#define NIRYO_TRACEPOINT(event_name, ...) \
+    tracepoint(niryo_one, event_name, __VA_ARGS__)
+#else
+#define NIRYO_TRACEPOINT(event_name, ...) \
+    ((void)0)
+#endif
+
+#endif
@@ -61,12 +61,17 @@
 #define XL320_ADDR_HW_ERROR_STATUS       50                  
 #define XL320_ADDR_PUNCH                 51
 
+// present position, speed and load : registers 37 to 42
+#define XL320_STATE_BLOCK_ADDR           XL320_ADDR_PRESENT_POSITION
+#define XL320_STATE_BLOCK_LEN            6
+
 class XL320Driver : public DxlDriver {
 
     public:
         XL320Driver(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler);
 
         int checkModelNumber(uint8_t id);
+        bool supportsFastRead(uint16_t model_number, uint32_t firmware_version);
 
         // eeprom write
         int changeId            (uint8_t id, uint8_t new_id);
@@ -78,6 +83,7 @@ class XL320Driver : public DxlDriver {
         int setAlarmShutdown    (uint8_t id, uint32_t alarm_shutdown);
 
         // eeprom read
+        int readFirmwareVersion  (uint8_t id, uint32_t *firmware_version);
         int readReturnDelayTime  (uint8_t id, uint32_t *return_delay_time);
         int readLimitTemperature (uint8_t id, uint32_t *limit_temperature);
         int readMaxTorque        (uint8_t id, uint32_t *max_torque);
@@ -112,6 +118,9 @@ class XL320Driver : public DxlDriver {
         int syncReadVoltage        (std::vector<uint8_t> &id_list, std::vector<uint32_t> &voltage_list);
         int syncReadHwErrorStatus  (std::vector<uint8_t> &id_list, std::vector<uint32_t> &hw_error_list);
 
+        const DxlStateBlock& getStateBlock();
+        const DxlWriteRegisters& getWriteRegisters();
+
         // custom write
         int customWrite(uint8_t id, uint32_t value, uint8_t reg_address, uint8_t byte_number);
 };
@@ -27,6 +27,9 @@
 #define XL430_PROTOCOL_VERSION 2.0
 #define XL430_MODEL_NUMBER 1060
 
+// Fast Sync Read / Fast Bulk Read instructions are available from this firmware version
+#define XL430_FAST_READ_MIN_FIRMWARE_VERSION 45
+
 // Table here : http://support.robotis.com/en/product/actuator/dynamixel_x/xl_series/xl430-w250.htm
 #define XL430_ADDR_MODEL_NUMBER        0
 #define XL430_ADDR_FIRMWARE_VERSION    6
@@ -58,12 +61,17 @@
 #define XL430_ADDR_PRESENT_VOLTAGE     144
 #define XL430_ADDR_PRESENT_TEMPERATURE 146
 
+// present load, velocity and position : registers 126 to 135
+#define XL430_STATE_BLOCK_ADDR         XL430_ADDR_PRESENT_LOAD
+#define XL430_STATE_BLOCK_LEN          10
+
 class XL430Driver : public DxlDriver {
 
     public:
         XL430Driver(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler);
 
         int checkModelNumber(uint8_t id);
+        bool supportsFastRead(uint16_t model_number, uint32_t firmware_version);
 
         // eeprom write
         int changeId            (uint8_t id, uint8_t new_id);
@@ -75,6 +83,7 @@ class XL430Driver : public DxlDriver {
         int setAlarmShutdown    (uint8_t id, uint32_t alarm_shutdown);
 
         // eeprom read
+        int readFirmwareVersion  (uint8_t id, uint32_t *firmware_version);
         int readReturnDelayTime  (uint8_t id, uint32_t *return_delay_time);
         int readLimitTemperature (uint8_t id, uint32_t *limit_temperature);
         int readMaxTorque        (uint8_t id, uint32_t *max_torque);
@@ -108,6 +117,9 @@ class XL430Driver : public DxlDriver {
         int syncReadTemperature    (std::vector<uint8_t> &id_list, std::vector<uint32_t> &temperature_list);
         int syncReadVoltage        (std::vector<uint8_t> &id_list, std::vector<uint32_t> &voltage_list);
         int syncReadHwErrorStatus  (std::vector<uint8_t> &id_list, std::vector<uint32_t> &hw_error_list);
+
+        const DxlStateBlock& getStateBlock();
+        const DxlWriteRegisters& getWriteRegisters();
         
         // custom write
         int customWrite(uint8_t id, uint32_t value, uint8_t reg_address, uint8_t byte_number);
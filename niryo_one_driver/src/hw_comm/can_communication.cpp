@@ -18,6 +18,8 @@
 */
 
 #include "niryo_one_driver/can_communication.h"
+#include "niryo_one_driver/mcp_can_transport.h"
+#include "niryo_one_driver/socket_can_transport.h"
 
 using namespace std::chrono_literals;
 
@@ -31,6 +33,11 @@ double CanCommunication::steps_to_rad_pos(int32_t steps, double gear_ratio, doub
     return (double) ((double)steps * 360.0 / (200.0 * 8.0 * gear_ratio * RADIAN_TO_DEGREE)) * direction ;
 }
 
+double CanCommunication::steps_to_rad_vel(double steps_per_sec, double gear_ratio, double direction)
+{
+    return (steps_per_sec * 360.0 / (200.0 * 8.0 * gear_ratio * RADIAN_TO_DEGREE)) * direction;
+}
+
 CanCommunication::CanCommunication()
 {   
 }
@@ -56,7 +63,17 @@ int CanCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     conveyor_id_1_direction = 1;
     conveyor_id_2_direction = 1;
     update_id = false;
-
+    conveyor_id_1_command_pending = false;
+    conveyor_id_2_command_pending = false;
+    conveyor_update_id_pending = false;
+    time_hw_last_read = 0.0;
+
+    can_transport = CAN_TRANSPORT_MCP2515;
+    can_socket_interface = "can0";
+    node->get_parameter("can_transport",can_transport);
+    node->get_parameter("can_socket_interface",can_socket_interface);
+    can_rx_filter_profile = CAN_RX_FILTER_EXTENDED;
+    node->get_parameter("can_rx_filter_profile",can_rx_filter_profile);
     node->get_parameter("spi_channel",spi_channel);
     node->get_parameter("spi_baudrate",spi_baudrate);
     node->get_parameter("gpio_can_interrupt",gpio_can_interrupt);
@@ -66,9 +83,35 @@ int CanCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     node->get_parameter("can_hw_write_frequency",hw_write_frequency);
     node->get_parameter("can_hw_check_connection_frequency",hw_check_connection_frequency);
 
+    // interrupt driven reception : frames are read by a dedicated thread, control loop only writes
+    hw_rx_interrupt_enabled = false;
+    rx_pause_requested = false;
+    rx_paused = false;
+    node->get_parameter("can_interrupt_rx_enabled",hw_rx_interrupt_enabled);
+    if (hw_rx_interrupt_enabled) {
+        node->get_parameter("can_interrupt_rx_control_loop_frequency",hw_control_loop_frequency);
+    }
+
+    getRtThreadConfig(node, "can", rt_config);
+    rx_rt_config = rt_config;
+    getRtThreadConfig(node, "can_rx", rx_rt_config);
+    command_latency.init(node, 0, (hardware_version == 1) ? 4 : 3);
+
     RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Start CAN communication (%lf Hz)", hw_control_loop_frequency);
     RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Writing data on CAN at %lf Hz", hw_write_frequency);
     RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Checking CAN connection at %lf Hz", hw_check_connection_frequency);
+    // asynchronous transmission : frames are queued, control loop doesn't wait for bus
+    hw_tx_queue_enabled = false;
+    hw_tx_error_count = 0;
+    node->get_parameter("can_tx_queue_enabled",hw_tx_queue_enabled);
+
+    // one broadcast frame for several steppers, once their firmware version is known to support it
+    hw_group_position_enabled = false;
+    group_position_supported = false;
+    node->get_parameter("can_group_position_enabled",hw_group_position_enabled);
+
+    RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Reading CAN frames on %s", hw_rx_interrupt_enabled ? "interrupt" : "polling");
+    RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Writing CAN frames %s", hw_tx_queue_enabled ? "through tx queue" : "synchronously");
 
     resetHardwareControlLoopRates();
 
@@ -77,7 +120,19 @@ int CanCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"NiryoStepper calibration timeout: %d seconds", calibration_timeout);
 
     // start can driver
-    can.reset(new NiryoCanDriver(spi_channel, spi_baudrate, gpio_can_interrupt));
+    if (can_transport == CAN_TRANSPORT_SOCKETCAN) {
+        RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"CAN bus on SocketCAN interface %s", can_socket_interface.c_str());
+        can.reset(new NiryoCanDriver(new SocketCanTransport(can_socket_interface)));
+    }
+    else {
+        if (can_transport != CAN_TRANSPORT_MCP2515) {
+            RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"Unknown CAN transport %s, using %s",
+                    can_transport.c_str(), CAN_TRANSPORT_MCP2515);
+        }
+        can.reset(new NiryoCanDriver(new McpCanTransport(spi_channel, spi_baudrate, gpio_can_interrupt,
+                        can_rx_filter_profile)));
+    }
+    can->setStatistics(&bus_stats);
 
     is_can_connection_ok = false;
     debug_error_message = "No connection with CAN motors has been made yet";
@@ -207,10 +262,14 @@ int CanCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     }
     allowed_motors.push_back(&m6);
     allowed_motors.push_back(&m7);
+    buildCanDispatchTable();
+
+    // initial state for ros2_control read(), before the hardware control loop starts
+    publishJointState();
     // set hw control init state
     torque_on = 0;
 
-    hw_is_busy = false;
+    hw_control_loop_keep_alive = false;
     hw_limited_mode = true;
 
     write_position_enable = true;
@@ -233,17 +292,20 @@ int CanCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
 
 int CanCommunication::setupCommunication()
 {
-    int gpio_result = can->setupInterruptGpio();
-    if (gpio_result != CAN_OK) {
-        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to start gpio for CAN bus");
-        return gpio_result;
+    int setup_result = can->setup();
+    if (setup_result != CAN_OK) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to open CAN bus (%s)", can_transport.c_str());
+        return setup_result;
     }
 
-    int spi_result = can->setupSpi();
-    if (spi_result != CAN_OK) {
-        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to start spi communication for CAN bus");
-        return spi_result;
+    if (hw_rx_interrupt_enabled && !can->setupInterruptEvent()) {
+        RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"Failed to get CAN interrupt events, falling back to polling at %lf Hz",
+                hw_control_loop_frequency);
+        hw_rx_interrupt_enabled = false;
     }
+    // tx interrupt is only useful if a thread waits on INT line
+    can->setTxQueue(hw_tx_queue_enabled, hw_rx_interrupt_enabled);
+
     // will return 0 on success
     return can->init();
 }
@@ -276,11 +338,18 @@ void CanCommunication::startHardwareControlLoop(bool limited_mode)
 
     hw_limited_mode = limited_mode;
     hw_control_loop_keep_alive = true;
+    bus_jobs.wakeOwner();
+    rx_pause_cv.notify_all();
 
     if (!hardware_control_loop_thread) {
         RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"START ctrl loop thread can");
         hardware_control_loop_thread.reset(new std::thread(boost::bind(&CanCommunication::hardwareControlLoop, this)));
     }
+
+    if (hw_rx_interrupt_enabled && !hardware_receive_loop_thread) {
+        RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"START rx thread can");
+        hardware_receive_loop_thread.reset(new std::thread(boost::bind(&CanCommunication::hardwareReceiveLoop, this)));
+    }
 }
 
 void CanCommunication::stopHardwareControlLoop()
@@ -292,201 +361,337 @@ void CanCommunication::stopHardwareControlLoop()
     m6.resetState();
     m7.resetState();
     hw_control_loop_keep_alive = false;
+
+    // calibration and scan read frames directly once the loop is stopped
+    waitReceiveLoopPaused();
 }
 
 void CanCommunication::hardwareControlRead()
 {
+    // no tx interrupt in polling mode : refill TX buffers here
+    can->serviceTxQueue();
+
     if (can->canReadData()) {
-        long unsigned int rxId;
-        unsigned char len;
-        unsigned char rxBuf[8];
-
-        can->readMsgBuf(&rxId, &len, rxBuf);
-
-        // 0. This functionality will come later, to allow user to plug other CAN devices to RPI
-        // Developement to do here : check if id >= 0x20
-        // Ids between 0x00 and 0x1F are reserved for Niryo One core communication
-        // Those are lower ids with higher priority, to ensure connection with motors is always up.
-	if (rxId >= 0x20) {
-            // send frame to another place and return
-            //RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"frame  will be send somewhere else ");
-            //return ;
+        CAN_FRAME frames[CAN_RX_BATCH_SIZE];
+        double rx_times[CAN_RX_BATCH_SIZE];
+        int frame_count = can->readMsgBatch(frames, CAN_RX_BATCH_SIZE, rx_times);
+
+        // velocity estimate uses reception time of each frame (kernel timestamp with SocketCAN)
+        for (int i = 0; i < frame_count; i++) {
+            time_hw_last_read = rx_times[i];
+            handleCanFrame(frames[i].id, frames[i].len, frames[i].data);
         }
+    }
+}
 
-        // 1. Validate motor id
-        int motor_id = rxId & 0x0F; // 0x11 for id 1, 0x12 for id 2, ...
-        
-        // conveyor belt detecetd
-		if((motor_id == CAN_MOTOR_CONVEYOR_1_ID) && (is_conveyor_id_1_connected))
-        {   //is_conveyor_id_1_connected = true; // if you want to ping // to test  
-            if((update_id) & (old_id == motor_id)){
-                if(can->sendUpdateConveyorId(CAN_MOTOR_CONVEYOR_1_ID, new_id) != CAN_OK){
-                    RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send update conveyor with id : %d", motor_id);
-                }
-		        update_id = false;
-                is_conveyor_id_1_connected = false;
-                conveyor_id_1_state = false; 
-                resetConveyor(CAN_MOTOR_CONVEYOR_1_ID); 
-                is_conveyor_id_2_connected = true;
-                conveyor_id_2_state = true; 
-                return;
-            } 
-            if(!conveyor_id_1_state)
-            { 
-                resetConveyor(CAN_MOTOR_CONVEYOR_1_ID);
-                is_conveyor_id_1_connected = false;
-            }
-            if (can->sendConveyoOnCommand(CAN_MOTOR_CONVEYOR_1_ID, is_conveyor_id_1_on, conveyor_id_1_speed, conveyor_id_1_direction) != CAN_OK)
-            {
-                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send command to the conveyor with id : %d", motor_id);
+/*
+ * Interrupt driven reception (replaces hardwareControlRead() in the control loop)
+ * - sleeps until MCP2515 INT line goes low
+ * - drains every pending frame (both RX buffers) before waiting again
+ * - frames are decoded under the bus lock : control loop cycles and bus jobs see
+ *   a consistent motor state, and never lose the frames they wait for
+ * - parked while the control loop is stopped or a scan is running, the pause is
+ *   acknowledged to waitReceiveLoopPaused() before scan or calibration read frames
+ */
+void CanCommunication::hardwareReceiveLoop()
+{
+    setupRtThread("can_receive_loop", rx_rt_config);
+
+    while (rclcpp::ok()) {
+        if (!receiveLoopShouldRun()) {
+            std::unique_lock<std::mutex> pause_lock(rx_pause_mutex);
+            rx_paused = true;
+            rx_pause_cv.notify_all();
+            rx_pause_cv.wait_for(pause_lock, std::chrono::milliseconds(CAN_RX_WAIT_TIMEOUT_MS),
+                    [this] { return receiveLoopShouldRun(); });
+            if (receiveLoopShouldRun()) {
+                rx_paused = false;
             }
+            continue;
+        }
 
-            int control_byte = rxBuf[0];
+        if (can->waitForInterrupt(CAN_RX_WAIT_TIMEOUT_MS) != CAN_MSGAVAIL) {
+            continue;
+        }
 
-             if (control_byte == CAN_DATA_CONVEYOR_STATE)
-            {
-                m6.setConveyorFeedback(rxBuf[1], rxBuf[2], rxBuf[3]); 
-                return;
+        int frame_counter = 0;
+        {
+            std::unique_lock<std::recursive_mutex> bus_lock = bus_jobs.lockBus();
+
+            // paused while waiting for the interrupt or the bus : frames are left to scan / calibration
+            if (!receiveLoopShouldRun()) {
+                continue;
             }
-            
-         return;
-        }
-        if((motor_id == CAN_MOTOR_CONVEYOR_2_ID) && (is_conveyor_id_2_connected))
-        {   // is_conveyor_id_2_connected = true;  // if you want to ping conveyor
-            if((update_id) & (old_id == motor_id)){
-                 if(can->sendUpdateConveyorId(CAN_MOTOR_CONVEYOR_2_ID, new_id) != CAN_OK){
-                    RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send update conveyor with id :%d", motor_id);
+
+            while (can->canReadData() && frame_counter < CAN_RX_MAX_FRAMES_PER_WAKEUP) {
+                CAN_FRAME frames[CAN_RX_BATCH_SIZE];
+                double rx_times[CAN_RX_BATCH_SIZE];
+                int frame_count = can->readMsgBatch(frames, CAN_RX_BATCH_SIZE, rx_times);
+                if (frame_count == 0) {
+                    break;
                 }
-		        update_id = false;
-                is_conveyor_id_2_connected = false;
-                conveyor_id_2_state = false;
-                resetConveyor(CAN_MOTOR_CONVEYOR_2_ID);
-                is_conveyor_id_1_connected = true;
-                conveyor_id_1_state = true;
-                return;
-            }
-            if(!conveyor_id_2_state)
-            {
-                resetConveyor(CAN_MOTOR_CONVEYOR_2_ID);
-                is_conveyor_id_2_connected = false; 
-            }
-            if(can->sendConveyoOnCommand(CAN_MOTOR_CONVEYOR_2_ID, is_conveyor_id_2_on, conveyor_id_2_speed, conveyor_id_2_direction)!=CAN_OK)
-            {
-               RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send command to the conveyor with id : %d", motor_id); 
-            }
-             int control_byte_2 = rxBuf[0];
-            if (control_byte_2 == CAN_DATA_CONVEYOR_STATE)
-            { 
-                m7.setConveyorFeedback(rxBuf[1], rxBuf[2], rxBuf[3]);
-                return ; 
+
+                for (int i = 0; i < frame_count; i++) {
+                    time_hw_last_read = rx_times[i];
+                    handleCanFrame(frames[i].id, frames[i].len, frames[i].data);
+                }
+                frame_counter += frame_count;
             }
-            return;
-        }
-          // treat niryo one steppers
-	    
-        bool motor_found = false;
-        for (int i = 0; i < allowed_motors.size(); i++) {
-            if (motor_id == allowed_motors.at(i)->getId()){
-                allowed_motors.at(i)->setLastTimeRead(rclcpp::Clock().now().seconds());
-                motor_found = true;
-                break;
+
+            if (frame_counter > 0) {
+                publishJointState();
             }
         }
 
-        if (!motor_found) {
-            RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with wrong id : %d", motor_id);
-            debug_error_message = "Unallowed connected motor : ";
-            debug_error_message += std::to_string(motor_id);
-            is_can_connection_ok = false;
-            return;
+        // INT line still low without any frame to read : don't spin on it
+        if (frame_counter == 0 && can->canReadData()) {
+            sleep_for(CAN_RX_WAIT_TIMEOUT_MS / 1000.0);
         }
+    }
 
-        // 1.1 Check buffer is not empty
-        if (len < 1) {
-            RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with empty data");
-            return;
-        }
+    std::lock_guard<std::mutex> pause_lock(rx_pause_mutex);
+    rx_paused = true;
+    rx_pause_cv.notify_all();
+}
 
-        // 2. If id ok, check control byte and fill data
-        int control_byte = rxBuf[0];
+bool CanCommunication::receiveLoopShouldRun()
+{
+    return hw_control_loop_keep_alive && !rx_pause_requested;
+}
 
-        if (control_byte == CAN_DATA_POSITION) {
-            // check length
-            if (len != 4) {
-                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Position can frame should contain 4 data bytes");
-                return;
-            }
+/*
+ * Wakes up the receive loop and waits until it is parked (returns at once in polling mode)
+ * Must not be called with the bus lock held : the receive loop may be waiting for it
+ */
+void CanCommunication::waitReceiveLoopPaused()
+{
+    if (!hardware_receive_loop_thread) {
+        return;
+    }
 
-            int32_t pos = (rxBuf[1] << 16) + (rxBuf[2] << 8) + rxBuf[3];
-            if (pos & (1 << 15)) {
-            	pos = -1 * ((~pos + 1) & 0xFFFF);
-          	}
+    can->notifyInterrupt();
+    std::unique_lock<std::mutex> pause_lock(rx_pause_mutex);
+    if (!rx_pause_cv.wait_for(pause_lock, std::chrono::duration<double>(CAN_RX_PAUSE_TIMEOUT),
+                [this] { return rx_paused; })) {
+        RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"CAN receive loop did not pause within %lf s", CAN_RX_PAUSE_TIMEOUT);
+    }
+}
 
-            // fill data
-            for (int i = 0; i < motors.size() ; i++) {
-                if (motor_id == motors.at(i)->getId() && motors.at(i)->isEnabled()) {
-                    motors.at(i)->setPositionState(pos);
-                    break;
-                }
-            }
-        }
-        else if (control_byte == CAN_DATA_DIAGNOSTICS) {
-            // check data length
-            if (len != 4) {
-                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Diagnostic can frame should contain 4 data bytes");
-                return;
-            }
-            int mode = rxBuf[1];
-            int driver_temp_raw = (rxBuf[2] << 8) + rxBuf[3];
-            double a = -0.00316;
-            double b = -12.924;
-            double c = 2367.7;
-            double v_temp = driver_temp_raw * 3.3 / 1024.0 * 1000.0;
-            int driver_temp = int((-b - std::sqrt(b*b - 4*a*(c - v_temp)))/(2*a)+30);
-
-            // fill data
-            for (int i = 0; i < motors.size() ; i++) {
-                if (motor_id == motors.at(i)->getId() && motors.at(i)->isEnabled()) {
-                    motors.at(i)->setTemperatureState(driver_temp);
-                    break;
-                }
-            }
-            //RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Mode : %d, Temp : %d", mode, m1.getTemperatureState());
+/*
+ * Builds (rxId & 0x0F, control byte) -> decoder table, so that a received frame is decoded without
+ * walking motors lists. Conveyor frames are handled apart (handleConveyorFrame) while conveyor is connected.
+ */
+void CanCommunication::buildCanDispatchTable()
+{
+    for (int id = 0; id < CAN_DISPATCH_MOTOR_IDS; id++) {
+        can_id_motors[id] = NULL;
+        for (int control_byte = 0; control_byte < CAN_DISPATCH_CONTROL_BYTES; control_byte++) {
+            can_dispatch_table[id][control_byte].decode = NULL;
+            can_dispatch_table[id][control_byte].motor = NULL;
         }
-        else if (control_byte == CAN_DATA_FIRMWARE_VERSION) {
-            if (len != 4) {
-                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Firmware version frame should contain 4 bytes");
-                return;
-            }
-            int v_major = rxBuf[1];
-            int v_minor = rxBuf[2];
-            int v_patch = rxBuf[3];
-            std::string version = "";
-            version += std::to_string(v_major); version += ".";
-            version += std::to_string(v_minor); version += ".";
-            version += std::to_string(v_patch);
-
-            // fill data
-            for (int i = 0; i < motors.size(); i++) {
-                if (motor_id == motors.at(i)->getId() && allowed_motors.at(i)->isEnabled()) {
-                    motors.at(i)->setFirmwareVersion(version);
-                    return;
-                }
+    }
+
+    for (int i = 0; i < allowed_motors.size(); i++) {
+        int id = allowed_motors.at(i)->getId() & 0x0F;
+        can_id_motors[id] = allowed_motors.at(i);
+
+        // data is only filled for niryo one steppers (motor stays NULL for conveyors)
+        StepperMotorState* motor = NULL;
+        for (int j = 0; j < motors.size(); j++) {
+            if (motors.at(j) == allowed_motors.at(i)) {
+                motor = motors.at(j);
             }
         }
-	else if (control_byte == CAN_DATA_CONVEYOR_STATE) {
-            // convyeor not enabled : do nothing 
-		    is_conveyor_id_1_connected = conveyor_id_1_state; 
-            is_conveyor_id_2_connected = conveyor_id_2_state;
+
+        can_dispatch_table[id][CAN_DATA_POSITION].decode = &CanCommunication::decodePositionFrame;
+        can_dispatch_table[id][CAN_DATA_POSITION].motor = motor;
+        can_dispatch_table[id][CAN_DATA_DIAGNOSTICS].decode = &CanCommunication::decodeDiagnosticsFrame;
+        can_dispatch_table[id][CAN_DATA_DIAGNOSTICS].motor = motor;
+        can_dispatch_table[id][CAN_DATA_FIRMWARE_VERSION].decode = &CanCommunication::decodeFirmwareVersionFrame;
+        can_dispatch_table[id][CAN_DATA_FIRMWARE_VERSION].motor = motor;
+        can_dispatch_table[id][CAN_DATA_CONVEYOR_STATE].decode = &CanCommunication::decodeConveyorStateFrame;
+        can_dispatch_table[id][CAN_DATA_CONVEYOR_STATE].motor = motor;
+    }
+}
+
+/*
+ * Frames with id >= 0x20 come from other CAN devices plugged on the bus
+ * (ids between 0x00 and 0x1F are reserved for Niryo One core communication)
+ * - can be called from any thread, at any time : the handlers map is only used under
+ *   the bus lock (frames are decoded under it, in polling and interrupt mode)
+ * - handlers are called from the thread decoding frames, with the bus lock held
+ */
+void CanCommunication::registerCanDeviceHandler(long unsigned int rxId, CanDeviceHandler handler)
+{
+    std::unique_lock<std::recursive_mutex> bus_lock = bus_jobs.lockBus();
+    can_device_handlers[rxId] = handler;
+    if (can) {
+        // MCP2515 filters (extended profile) and SocketCAN filters drop unknown ids
+        can->addRxFilter(rxId);
+    }
+}
+
+void CanCommunication::handleCanFrame(long unsigned int rxId, unsigned char len, unsigned char *rxBuf)
+{
+    bus_stats.recordFrame(bus_stats.frames_in, bus_stats.other_frames_in, rxId, len, rxBuf);
+
+    // 0. Frames from other CAN devices (lower ids have higher priority, to ensure connection with motors is always up)
+    if (rxId >= 0x20 && !can_device_handlers.empty()) {
+        std::unordered_map<long unsigned int, CanDeviceHandler>::iterator it = can_device_handlers.find(rxId);
+        if (it != can_device_handlers.end()) {
+            it->second(rxId, len, rxBuf);
             return;
         }
-        else {
-            RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with unknown control byte");
-            return;
+    }
+
+    // 1. Validate motor id
+    int motor_id = rxId & 0x0F; // 0x11 for id 1, 0x12 for id 2, ...
+
+    if ((motor_id == CAN_MOTOR_CONVEYOR_1_ID && is_conveyor_id_1_connected) ||
+            (motor_id == CAN_MOTOR_CONVEYOR_2_ID && is_conveyor_id_2_connected)) {
+        handleConveyorFrame(can_id_motors[motor_id], len, rxBuf);
+        return;
+    }
+
+    StepperMotorState* allowed_motor = can_id_motors[motor_id];
+    if (allowed_motor == NULL) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with wrong id : %d", motor_id);
+        debug_error_message = "Unallowed connected motor : ";
+        debug_error_message += std::to_string(motor_id);
+        is_can_connection_ok = false;
+        return;
+    }
+    allowed_motor->setLastTimeRead(time_hw_last_read);
+
+    // 1.1 Check buffer is not empty
+    if (len < 1) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with empty data");
+        return;
+    }
+
+    // 2. If id ok, check control byte and fill data
+    int control_byte = rxBuf[0];
+    if (control_byte >= CAN_DISPATCH_CONTROL_BYTES || can_dispatch_table[motor_id][control_byte].decode == NULL) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Received can frame with unknown control byte");
+        return;
+    }
+
+    const CanDispatchSlot &slot = can_dispatch_table[motor_id][control_byte];
+    (this->*slot.decode)(slot.motor, len, rxBuf);
+}
+
+/*
+ * Conveyor answers are not sent from here : read phase only sets flags,
+ * commands are sent in hardwareControlWrite()
+ */
+void CanCommunication::handleConveyorFrame(StepperMotorState* conveyor, unsigned char len, unsigned char *rxBuf)
+{
+    int conveyor_id = conveyor->getId();
+    bool is_conveyor_1 = (conveyor_id == CAN_MOTOR_CONVEYOR_1_ID);
+
+    if (update_id && old_id == conveyor_id) {
+        conveyor_update_id_pending = true;
+        conveyor_update_id_old = conveyor_id;
+        conveyor_update_id_new = new_id;
+
+        update_id = false;
+        resetConveyor(conveyor_id);
+        // after the id update, frames are expected from the other conveyor id
+        is_conveyor_id_1_connected = !is_conveyor_1;
+        conveyor_id_1_state = !is_conveyor_1;
+        is_conveyor_id_2_connected = is_conveyor_1;
+        conveyor_id_2_state = is_conveyor_1;
+        return;
+    }
+
+    if (is_conveyor_1) {
+        if (!conveyor_id_1_state) {
+            resetConveyor(CAN_MOTOR_CONVEYOR_1_ID);
+            is_conveyor_id_1_connected = false;
         }
+        conveyor_id_1_command_pending = true;
+    }
+    else {
+        if (!conveyor_id_2_state) {
+            resetConveyor(CAN_MOTOR_CONVEYOR_2_ID);
+            is_conveyor_id_2_connected = false;
+        }
+        conveyor_id_2_command_pending = true;
+    }
+
+    if (len >= 4 && rxBuf[0] == CAN_DATA_CONVEYOR_STATE) {
+        conveyor->setConveyorFeedback(rxBuf[1], rxBuf[2], rxBuf[3]);
+    }
+}
+
+void CanCommunication::decodePositionFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf)
+{
+    // check length
+    if (len != 4) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Position can frame should contain 4 data bytes");
+        return;
+    }
+
+    int32_t pos = (rxBuf[1] << 16) + (rxBuf[2] << 8) + rxBuf[3];
+    if (pos & (1 << 15)) {
+        pos = -1 * ((~pos + 1) & 0xFFFF);
+    }
+
+    // fill data
+    if (motor != NULL && motor->isEnabled()) {
+        motor->setPositionState(pos);
+        motor->updateVelocityEstimate(pos, time_hw_last_read, STEPPER_VELOCITY_FILTER_ALPHA);
     }
 }
 
+void CanCommunication::decodeDiagnosticsFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf)
+{
+    // check data length
+    if (len != 4) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Diagnostic can frame should contain 4 data bytes");
+        return;
+    }
+    int driver_temp_raw = (rxBuf[2] << 8) + rxBuf[3];
+    double a = -0.00316;
+    double b = -12.924;
+    double c = 2367.7;
+    double v_temp = driver_temp_raw * 3.3 / 1024.0 * 1000.0;
+    int driver_temp = int((-b - std::sqrt(b*b - 4*a*(c - v_temp)))/(2*a)+30);
+
+    // fill data
+    if (motor != NULL && motor->isEnabled()) {
+        motor->setTemperatureState(driver_temp);
+    }
+}
+
+void CanCommunication::decodeFirmwareVersionFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf)
+{
+    if (len != 4) {
+        RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Firmware version frame should contain 4 bytes");
+        return;
+    }
+    int v_major = rxBuf[1];
+    int v_minor = rxBuf[2];
+    int v_patch = rxBuf[3];
+    std::string version = "";
+    version += std::to_string(v_major); version += ".";
+    version += std::to_string(v_minor); version += ".";
+    version += std::to_string(v_patch);
+
+    // fill data
+    if (motor != NULL && motor->isEnabled()) {
+        motor->setFirmwareVersion(version);
+        updateGroupPositionSupport();
+    }
+}
+
+void CanCommunication::decodeConveyorStateFrame(StepperMotorState* motor, unsigned char len, unsigned char *rxBuf)
+{
+    // convyeor not enabled : do nothing
+    is_conveyor_id_1_connected = conveyor_id_1_state;
+    is_conveyor_id_2_connected = conveyor_id_2_state;
+}
+
 /*
  * Sends a CAN frame per motor (id + control byte + data)
  */
@@ -494,6 +699,7 @@ void CanCommunication::hardwareControlWrite()
 {
     if (rclcpp::Clock().now().seconds() - time_hw_last_write > 1.0/hw_write_frequency) {
         time_hw_last_write += 1.0/hw_write_frequency;
+        can->beginTxBatch();
 
         // write torque ON/OFF
         if (write_torque_on_enable) {
@@ -527,7 +733,11 @@ void CanCommunication::hardwareControlWrite()
         }
 
         // write position
-        if (write_position_enable) {
+        if (write_position_enable && hw_group_position_enabled && group_position_supported) {
+            writeGroupPositionCommand();
+            command_latency.onCommandSent();
+        }
+        else if (write_position_enable) {
             for (int i = 0 ; i < motors.size(); i++) {
                 if (motors.at(i)->isEnabled()) {
                     if (can->sendPositionCommand(motors.at(i)->getId(), motors.at(i)->getPositionCommand()) != CAN_OK) {
@@ -535,6 +745,7 @@ void CanCommunication::hardwareControlWrite()
                     }
                 }
             }
+            command_latency.onCommandSent();
         }
 
         // write micro steps
@@ -575,9 +786,92 @@ void CanCommunication::hardwareControlWrite()
                 RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send Max Effort");
             }
         }
-        // conveyor belt commands
+        // conveyor belt commands (answers to conveyor frames received in read phase)
+        if (conveyor_update_id_pending) {
+            conveyor_update_id_pending = false;
+            if (can->sendUpdateConveyorId(conveyor_update_id_old, conveyor_update_id_new) != CAN_OK) {
+                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send update conveyor with id : %d", conveyor_update_id_old);
+            }
+        }
+        if (conveyor_id_1_command_pending) {
+            conveyor_id_1_command_pending = false;
+            if (can->sendConveyoOnCommand(CAN_MOTOR_CONVEYOR_1_ID, is_conveyor_id_1_on, conveyor_id_1_speed, conveyor_id_1_direction) != CAN_OK) {
+                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send command to the conveyor with id : %d", CAN_MOTOR_CONVEYOR_1_ID);
+            }
+        }
+        if (conveyor_id_2_command_pending) {
+            conveyor_id_2_command_pending = false;
+            if (can->sendConveyoOnCommand(CAN_MOTOR_CONVEYOR_2_ID, is_conveyor_id_2_on, conveyor_id_2_speed, conveyor_id_2_direction) != CAN_OK) {
+                RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send command to the conveyor with id : %d", CAN_MOTOR_CONVEYOR_2_ID);
+            }
+        }
+
+        can->endTxBatch();
+
+        // transmission errors are only known after the frames left the tx queue
+        unsigned int tx_error_count = can->getTxErrorCount();
+        if (tx_error_count != hw_tx_error_count) {
+            RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"%u CAN transmission error(s)", tx_error_count - hw_tx_error_count);
+            hw_tx_error_count = tx_error_count;
+        }
+    }
+}
+
+/*
+ * Sends position commands on broadcast id, one frame for CAN_GROUP_POSITION_MAX_MOTORS
+ * enabled motors with consecutive ids (a motor alone gets a frame with only its position)
+ */
+void CanCommunication::writeGroupPositionCommand()
+{
+    int i = 0;
+    while (i < motors.size()) {
+        if (!motors.at(i)->isEnabled()) {
+            i++;
+            continue;
+        }
+
+        int first_motor_id = motors.at(i)->getId();
+        int cmds[CAN_GROUP_POSITION_MAX_MOTORS];
+        int motor_count = 0;
+
+        while (i < motors.size() && motor_count < CAN_GROUP_POSITION_MAX_MOTORS
+                && motors.at(i)->isEnabled() && motors.at(i)->getId() == first_motor_id + motor_count) {
+            cmds[motor_count] = motors.at(i)->getPositionCommand();
+            motor_count++;
+            i++;
+        }
+
+        if (can->sendGroupPositionCommand(CAN_BROADCAST_ID, first_motor_id, motor_count, cmds) != CAN_OK) {
+            //RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Failed to send group position from motor(%d)", first_motor_id);
+        }
+    }
+}
+
+/*
+ * Group position command is only used when every enabled stepper reported a compatible firmware version
+ * (otherwise one position frame per motor is sent)
+ */
+void CanCommunication::updateGroupPositionSupport()
+{
+    bool supported = true;
+
+    for (int i = 0; i < motors.size(); i++) {
+        if (motors.at(i)->isEnabled()) {
+            int v_major = 0, v_minor = 0, v_patch = 0;
+            sscanf(motors.at(i)->getFirmwareVersion().c_str(), "%d.%d.%d", &v_major, &v_minor, &v_patch);
+            if (v_major < CAN_GROUP_POSITION_FIRMWARE_MAJOR ||
+                    (v_major == CAN_GROUP_POSITION_FIRMWARE_MAJOR && v_minor < CAN_GROUP_POSITION_FIRMWARE_MINOR)) {
+                supported = false;
+                break;
+            }
+        }
+    }
 
+    if (supported != group_position_supported && hw_group_position_enabled) {
+        RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"Stepper position commands sent %s",
+                supported ? "in group frames (broadcast)" : "one frame per motor");
     }
+    group_position_supported = supported;
 }
 
 void CanCommunication::hardwareControlCheckConnection()
@@ -624,26 +918,57 @@ void CanCommunication::hardwareControlCheckConnection()
 void CanCommunication::hardwareControlLoop()
 {
     rclcpp::Rate hw_control_loop_rate(hw_control_loop_frequency);
+    RtLoopTimer hw_control_loop_timer("can_control_loop", hw_control_loop_frequency);
+    setupRtThread("can_control_loop", rt_config);
+
+    bus_jobs.attachOwner();
 
     while (rclcpp::ok()) {
-        if (!hw_is_busy && hw_control_loop_keep_alive) {
-            hw_is_busy = true;
+        if (hw_control_loop_keep_alive) {
+            {
+                std::unique_lock<std::recursive_mutex> bus_lock = bus_jobs.lockBus();
+                uint64_t time_cycle_start = statClockNs();
+                uint64_t time_stage_start = time_cycle_start;
+
+                if (!hw_rx_interrupt_enabled) {
+                    hardwareControlRead();
+                    bus_stats.loop.read.recordSince(time_stage_start);
+                    publishJointState();
+                }
+                applyJointCommand();
+                if (hw_rx_interrupt_enabled) {
+                    // echo positions of disabled motors are not decoded from frames
+                    publishJointState();
+                }
+                time_stage_start = statClockNs();
+                hardwareControlWrite();
+                time_stage_start = bus_stats.loop.write.recordSince(time_stage_start);
+                hardwareControlCheckConnection();
+                uint64_t time_cycle_end = bus_stats.loop.check_connection.recordSince(time_stage_start);
+
+                bus_stats.loop.recordCycle(time_cycle_start, time_cycle_end, hw_control_loop_frequency);
+            }
 
-            hardwareControlRead();
-            hardwareControlWrite();
-            hardwareControlCheckConnection();
+            // out-of-band requests from other threads, between two cycles
+            bus_jobs.runPendingJobs();
 
-            hw_is_busy = false;
-            hw_control_loop_rate.sleep();
+            if (rt_config.enabled) {
+                hw_control_loop_timer.sleep();
+            }
+            else {
+                hw_control_loop_rate.sleep();
+            }
         }
         else {
-
-            //ros::Duration().sleep();
-            sleep_for(TIME_TO_WAIT_IF_BUSY);
+            // paused (scan, calibration) : bus is only used by jobs
+            bus_jobs.runPendingJobs();
+            bus_jobs.waitForJobs(TIME_TO_WAIT_IF_PAUSED);
             resetHardwareControlLoopRates();
-           // RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"HW control loop, wait because is busy");
+            hw_control_loop_timer.reset();
         }
     }
+
+    bus_jobs.detachOwner();
 }
 
 void CanCommunication::synchronizeSteppers(bool begin_traj)
@@ -1098,55 +1423,114 @@ int CanCommunication::autoCalibrationStep2()
     return CAN_STEPPERS_CALIBRATION_OK;
 }
 
+/*
+ * Called from ros2_control write() : command is only published here,
+ * and converted to motor steps by the control loop (applyJointCommand)
+ */
 void CanCommunication::setGoalPositionV1(double axis_1_pos_goal, double axis_2_pos_goal, double axis_3_pos_goal, double axis_4_pos_goal)
 {
     if (hardware_version == 1) {
-        m1.setPositionCommand(rad_pos_to_steps(axis_1_pos_goal, m1.getGearRatio(), m1.getDirection()));
-        m2.setPositionCommand(rad_pos_to_steps(axis_2_pos_goal, m2.getGearRatio(), m2.getDirection()));
-        m3.setPositionCommand(rad_pos_to_steps(axis_3_pos_goal, m3.getGearRatio(), m3.getDirection()));
-        m4.setPositionCommand(rad_pos_to_steps(axis_4_pos_goal, m4.getGearRatio(), m4.getDirection()));
-
-        // if motor disabled, pos_state = pos_cmd (echo position)
-        for (int i = 0 ; i < motors.size(); i++) {
-            if (!motors.at(i)->isEnabled()) {
-                motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
-            }
-        }
+        JointCommandSnapshot &cmd = joint_command_buffer.writeBuffer();
+        cmd.position[0] = axis_1_pos_goal;
+        cmd.position[1] = axis_2_pos_goal;
+        cmd.position[2] = axis_3_pos_goal;
+        cmd.position[3] = axis_4_pos_goal;
+        command_latency.stampCommand(cmd);
+        joint_command_buffer.publish();
     }
 }
 
 void CanCommunication::setGoalPositionV2(double axis_1_pos_goal, double axis_2_pos_goal, double axis_3_pos_goal)
 {
     if (hardware_version == 2) {
-        m1.setPositionCommand(rad_pos_to_steps(axis_1_pos_goal, m1.getGearRatio(), m1.getDirection()));
-        m2.setPositionCommand(rad_pos_to_steps(axis_2_pos_goal, m2.getGearRatio(), m2.getDirection()));
-        m3.setPositionCommand(rad_pos_to_steps(axis_3_pos_goal, m3.getGearRatio(), m3.getDirection()));
-
-        // if motor disabled, pos_state = pos_cmd (echo position)
-        for (int i = 0 ; i < motors.size(); i++) {
-            if (!motors.at(i)->isEnabled()) {
-                motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
-            }
-        }
+        JointCommandSnapshot &cmd = joint_command_buffer.writeBuffer();
+        cmd.position[0] = axis_1_pos_goal;
+        cmd.position[1] = axis_2_pos_goal;
+        cmd.position[2] = axis_3_pos_goal;
+        command_latency.stampCommand(cmd);
+        joint_command_buffer.publish();
     }
 }
 
+/*
+ * Called from ros2_control read() : returns last state published by the hardware thread (no wait)
+ */
 void CanCommunication::getCurrentPositionV1(double *axis_1_pos, double *axis_2_pos, double *axis_3_pos, double *axis_4_pos)
 {
     if (hardware_version == 1) {
-        *axis_1_pos = steps_to_rad_pos(m1.getPositionState(), m1.getGearRatio(), m1.getDirection());
-        *axis_2_pos = steps_to_rad_pos(m2.getPositionState(), m2.getGearRatio(), m2.getDirection());
-        *axis_3_pos = steps_to_rad_pos(m3.getPositionState(), m3.getGearRatio(), m3.getDirection());
-        *axis_4_pos = steps_to_rad_pos(m4.getPositionState(), m4.getGearRatio(), m4.getDirection());
+        joint_state_buffer.update();
+        const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+        *axis_1_pos = state.position[0];
+        *axis_2_pos = state.position[1];
+        *axis_3_pos = state.position[2];
+        *axis_4_pos = state.position[3];
     }
 }
 
 void CanCommunication::getCurrentPositionV2(double *axis_1_pos, double *axis_2_pos, double *axis_3_pos)
 {
     if (hardware_version == 2) {
-        *axis_1_pos = steps_to_rad_pos(m1.getPositionState(), m1.getGearRatio(), m1.getDirection());
-        *axis_2_pos = steps_to_rad_pos(m2.getPositionState(), m2.getGearRatio(), m2.getDirection());
-        *axis_3_pos = steps_to_rad_pos(m3.getPositionState(), m3.getGearRatio(), m3.getDirection());
+        joint_state_buffer.update();
+        const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+        *axis_1_pos = state.position[0];
+        *axis_2_pos = state.position[1];
+        *axis_3_pos = state.position[2];
+    }
+}
+
+void CanCommunication::getCurrentState(double pos[6], double vel[6], double eff[6])
+{
+    joint_state_buffer.update();
+    const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+    for (int i = 0; i < motors.size(); i++) {
+        pos[i] = state.position[i];
+        vel[i] = state.velocity[i];
+        eff[i] = state.effort[i];
+    }
+    command_latency.onRead(state);
+}
+
+/*
+ * Publishes steppers positions and estimated velocities for ros2_control read()
+ * - only called under the bus lock (single writer) : by the thread that decodes position
+ *   frames, and by the control loop after applyJointCommand() in interrupt mode
+ * - no effort feedback from steppers (stays 0)
+ */
+void CanCommunication::publishJointState()
+{
+    JointStateSnapshot &state = joint_state_buffer.writeBuffer();
+    for (int i = 0; i < motors.size(); i++) {
+        StepperMotorState* motor = motors.at(i);
+        state.position[i] = steps_to_rad_pos(motor->getPositionState(), motor->getGearRatio(), motor->getDirection());
+        state.velocity[i] = steps_to_rad_vel(motor->getVelocityEstimate(), motor->getGearRatio(), motor->getDirection());
+    }
+    command_latency.onFeedback(state);
+    joint_state_buffer.publish();
+}
+
+/*
+ * Takes last command published by ros2_control write() (if any) into motors position command
+ */
+void CanCommunication::applyJointCommand()
+{
+    if (!joint_command_buffer.update()) {
+        return;
+    }
+    const JointCommandSnapshot &cmd = joint_command_buffer.readBuffer();
+    command_latency.onCommandApplied(cmd);
+
+    m1.setPositionCommand(rad_pos_to_steps(cmd.position[0], m1.getGearRatio(), m1.getDirection()));
+    m2.setPositionCommand(rad_pos_to_steps(cmd.position[1], m2.getGearRatio(), m2.getDirection()));
+    m3.setPositionCommand(rad_pos_to_steps(cmd.position[2], m3.getGearRatio(), m3.getDirection()));
+    if (hardware_version == 1) {
+        m4.setPositionCommand(rad_pos_to_steps(cmd.position[3], m4.getGearRatio(), m4.getDirection()));
+    }
+
+    // if motor disabled, pos_state = pos_cmd (echo position)
+    for (int i = 0 ; i < motors.size(); i++) {
+        if (!motors.at(i)->isEnabled()) {
+            motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
+        }
     }
 }
 
@@ -1178,6 +1562,42 @@ void CanCommunication::setMaxEffort(std::vector<uint8_t> max_effort_list)
     write_max_effort_enable = true;
 }
 
+/*
+ * Loop timings (window since last call), then counters since start
+ */
+void CanCommunication::getStatistics(HwStatisticsReport &report)
+{
+    report.name = "CAN bus";
+    report.values.clear();
+    loop_stats_window.report(bus_stats.loop, report);
+
+    INT8U rx_error_count = 0;
+    INT8U tx_error_count = 0;
+    can->getErrorCounters(&rx_error_count, &tx_error_count);
+    report.values.push_back(std::make_pair("controller rx error count (REC)", std::to_string(rx_error_count)));
+    report.values.push_back(std::make_pair("controller tx error count (TEC)", std::to_string(tx_error_count)));
+    report.values.push_back(std::make_pair("tx errors", std::to_string(can->getTxErrorCount())));
+    report.values.push_back(std::make_pair("send failures", std::to_string(bus_stats.send_failures.get())));
+    report.values.push_back(std::make_pair("other frames in", std::to_string(bus_stats.other_frames_in.get())));
+    report.values.push_back(std::make_pair("other frames out", std::to_string(bus_stats.other_frames_out.get())));
+
+    for (int id = 0; id < CAN_STAT_MOTOR_ID_COUNT; id++) {
+        for (int control_byte = 0; control_byte < CAN_STAT_CONTROL_BYTE_COUNT; control_byte++) {
+            uint32_t frames_in = bus_stats.frames_in[id][control_byte].get();
+            uint32_t frames_out = bus_stats.frames_out[id][control_byte].get();
+            if (frames_in == 0 && frames_out == 0) {
+                continue;
+            }
+            char key[48];
+            snprintf(key, sizeof(key), "frames motor %d control byte 0x%02X", id, control_byte);
+            report.values.push_back(std::make_pair(std::string(key),
+                        "in " + std::to_string(frames_in) + ", out " + std::to_string(frames_out)));
+        }
+    }
+
+    command_latency.report(report);
+}
+
 void CanCommunication::getHardwareStatus(bool *is_connection_ok, std::string &error_message,
         int *calibration_needed, bool *calibration_in_progress,
         std::vector<std::string> &motor_names, std::vector<std::string> &motor_types,
@@ -1230,26 +1650,25 @@ bool CanCommunication::isConnectionOk()
  * --> error when
  *  - a motor id is not allowed
  *  - a required motor is missing
- *  - can't get access to CAN bus
+ *
+ * Runs on the control loop thread (paused by the caller while scanning, the scan
+ * listens to the bus for 0.25 to 0.5 s). The receive loop is parked meanwhile,
+ * so that it does not take the frames the scan is waiting for.
  */
 int CanCommunication::scanAndCheck()
 {
-    int counter = 0;
+    rx_pause_requested = true;
+    waitReceiveLoopPaused();
 
-    while (hw_is_busy && counter < 100) {
-        //ros::Duration().sleep();
-        sleep_for(TIME_TO_WAIT_IF_BUSY);
-        counter++;
-    }
+    int result = bus_jobs.execute(std::bind(&CanCommunication::scanMotors, this));
 
-    if (counter == 100) {
-        debug_error_message = "Failed to scan motors, CAN bus is too busy. Will retry...";
-        RCLCPP_WARN(rclcpp::get_logger("CanCommunication"),"Failed to scan motors, CAN bus is too busy (counter max : %d)", counter);
-        return CAN_SCAN_BUSY;
-    }
-
-    hw_is_busy = true;
+    rx_pause_requested = false;
+    rx_pause_cv.notify_all();
+    return result;
+}
 
+int CanCommunication::scanMotors()
+{
     // if some motors are disabled, just declare them as connected
     bool m1_ok = !m1.isEnabled();
     bool m2_ok = !m2.isEnabled();
@@ -1288,7 +1707,6 @@ int CanCommunication::scanAndCheck()
             }
             else { // detect unallowed motor
                 RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"Scan CAN bus : Received can frame with wrong id : %d", motor_id);
-                hw_is_busy = false;
                 debug_error_message = "Unallowed connected motor : ";
                 debug_error_message += std::to_string(motor_id);
                 RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"%s", debug_error_message.c_str());
@@ -1305,14 +1723,12 @@ int CanCommunication::scanAndCheck()
             if (!m4_ok) { debug_error_message += m4.getName(); debug_error_message += ", "; }
             debug_error_message += "are not connected";
             is_can_connection_ok = false;
-            hw_is_busy = false;
             RCLCPP_ERROR(rclcpp::get_logger("CanCommunication"),"%s", debug_error_message.c_str());
             return CAN_SCAN_TIMEOUT;
         }
     }
 
     //RCLCPP_INFO(rclcpp::get_logger("CanCommunication"),"CAN Connection ok");
-    hw_is_busy = false;
     is_can_connection_ok = true;
     debug_error_message = "";
     return CAN_SCAN_OK;
@@ -39,6 +39,29 @@ double DxlCommunication::xl430_pos_to_rad_pos(uint32_t position_dxl)
     return (double) ((((double)position_dxl - XL430_MIDDLE_POSITION) * (double)XL430_TOTAL_ANGLE) / (RADIAN_TO_DEGREE * (double)XL430_TOTAL_RANGE_POSITION));
 }
 
+// xl320 speed and load : bits 0-9 value, bit 10 direction (CW)
+double DxlCommunication::xl320_speed_to_rad_vel(uint32_t speed_dxl)
+{
+    double rpm = (double)(speed_dxl & 0x3FF) * XL320_RPM_FOR_1_SPEED;
+    return ((speed_dxl & 0x400) ? -rpm : rpm) * 6.0 / RADIAN_TO_DEGREE; // rpm -> deg/s -> rad/s
+}
+
+double DxlCommunication::xl430_velocity_to_rad_vel(uint32_t velocity_dxl)
+{
+    return (double)((int32_t)velocity_dxl) * XL430_RPM_FOR_1_VELOCITY * 6.0 / RADIAN_TO_DEGREE;
+}
+
+double DxlCommunication::xl320_load_to_effort(uint32_t load_dxl)
+{
+    double load = (double)(load_dxl & 0x3FF) / 1000.0 * XL320_STALL_TORQUE;
+    return (load_dxl & 0x400) ? -load : load;
+}
+
+double DxlCommunication::xl430_load_to_effort(uint32_t load_dxl)
+{
+    return (double)((int16_t)load_dxl) / 1000.0 * XL430_STALL_TORQUE;
+}
+
 DxlCommunication::DxlCommunication()
 {
 }
@@ -62,6 +85,9 @@ int DxlCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     node->get_parameter("dxl_hw_data_read_frequency",hw_data_read_frequency);
     node->get_parameter("dxl_hw_status_read_frequency",hw_status_read_frequency);
     
+    getRtThreadConfig(node, "dxl", rt_config);
+    command_latency.init(node, (hardware_version == 1) ? 4 : 3, (hardware_version == 1) ? 2 : 3);
+
     RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"Start Dxl communication (%lf Hz)", hw_control_loop_frequency);
     RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"Writing data on Dxl at %lf Hz", hw_data_write_frequency);
     RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"Reading data from Dxl at %lf Hz", hw_data_read_frequency);
@@ -74,6 +100,8 @@ int DxlCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
 
     xl320.reset(new XL320Driver(dxlPortHandler, dxlPacketHandler));
     xl430.reset(new XL430Driver(dxlPortHandler, dxlPacketHandler));
+    xl320->setStatistics(&bus_stats);
+    xl430->setStatistics(&bus_stats);
 
     is_dxl_connection_ok = false;
     debug_error_message = "No connection with Dynamixel motors has been made yet";
@@ -153,20 +181,57 @@ int DxlCommunication::init(int hardware_version,rclcpp::Node::SharedPtr node)
     should_reboot_motors = false;
     
     // for hardware control loop
-    hw_is_busy = false;
+    hw_control_loop_keep_alive = false;
     hw_limited_mode = true;
     
     read_position_enable = true;
-    read_velocity_enable = true; // not useful for now
+    read_velocity_enable = true; // exported on velocity state interfaces
     read_torque_enable = true;
     read_hw_status_enable = true;
 
+    bulk_read_enabled = true;
+    node->get_parameter("dxl_bulk_read_enabled", bulk_read_enabled);
+
+    bulk_write_enabled = true;
+    node->get_parameter("dxl_bulk_write_enabled", bulk_write_enabled);
+
+    // Fast Sync/Bulk Read : only used if all motors of a read support it (falls back on sync/bulk read)
+    bool fast_read_enabled = false;
+    node->get_parameter("dxl_fast_read_enabled", fast_read_enabled);
+    xl320->setFastReadEnabled(fast_read_enabled);
+    xl430->setFastReadEnabled(fast_read_enabled);
+
+    // gpio_drain is opt-in : tcdrain() may return milliseconds after the last byte (uart driver sleeps in jiffies)
+    std::string direction_control_name = "gpio_sleep";
+    node->get_parameter("dxl_direction_control", direction_control_name);
+    if (direction_control_name == "rs485") {
+        direction_control = DIRECTION_CONTROL_RS485;
+    }
+    else if (direction_control_name == "gpio_drain") {
+        direction_control = DIRECTION_CONTROL_GPIO_DRAIN;
+    }
+    else {
+        direction_control = DIRECTION_CONTROL_GPIO_SLEEP;
+    }
+
+    adaptive_timeout_enabled = true;
+    timeout_percentile = 0.99;
+    timeout_margin = 1.0;
+    node->get_parameter("dxl_adaptive_timeout_enabled", adaptive_timeout_enabled);
+    node->get_parameter("dxl_timeout_percentile", timeout_percentile);
+    node->get_parameter("dxl_timeout_margin", timeout_margin);
+    RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"Dxl adaptive timeout : %s (percentile %lf, margin %lf ms)",
+            adaptive_timeout_enabled ? "enabled" : "disabled", timeout_percentile, timeout_margin);
+
     // change those values according to the current loaded controller (position, velocity, or torque control)
     setControlMode(DXL_CONTROL_MODE_POSITION);
     write_led_enable = true;
     write_torque_on_enable = true;
     write_tool_enable = false;
 
+    // initial state for ros2_control read(), before the hardware control loop starts
+    publishJointState();
+
     return setupCommunication();
 }
 
@@ -192,6 +257,13 @@ int DxlCommunication::setupCommunication()
         return DXL_FAIL_SETUP_GPIO;
     }
 
+    // half-duplex direction switch : GPIO (sleep or tcdrain), or RTS driven by the uart driver (RS-485 mode)
+    // the RS-485 mode is checked when the port is opened, and tcdrain is used if not supported
+    dxlPortHandler->setDirectionControl(direction_control);
+
+    // status packet timeout learned for each motor, instead of a fixed USB latency
+    dxlPortHandler->setAdaptiveTimeout(adaptive_timeout_enabled, timeout_percentile, timeout_margin);
+
     // Open port
     if (!dxlPortHandler->openPort()) {
         RCLCPP_ERROR(rclcpp::get_logger("DxlCommunication"),"Failed to open Uart port for Dynamixel bus");
@@ -204,6 +276,11 @@ int DxlCommunication::setupCommunication()
         return DXL_FAIL_PORT_SET_BAUDRATE;
     }
 
+    if (dxlPortHandler->getDirectionControl() != direction_control) {
+        RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Dxl : RS-485 mode not supported by uart driver, using tcdrain for direction control");
+        direction_control = dxlPortHandler->getDirectionControl();
+    }
+
     sleep_for(0.1);
     return COMM_SUCCESS;
 }
@@ -230,6 +307,7 @@ void DxlCommunication::startHardwareControlLoop(bool limited_mode)
     write_torque_on_enable = true;
     resetHardwareControlLoopRates();
     hw_control_loop_keep_alive = true;
+    bus_jobs.wakeOwner();
         
     // depends on limited_mode flag
     write_position_enable = !limited_mode;
@@ -252,13 +330,13 @@ void DxlCommunication::stopHardwareControlLoop()
 
 void DxlCommunication::hardwareControlRead()
 {
-    std::vector<uint8_t> xl320_id_list;
-    std::vector<uint8_t> xl430_id_list;
-    
     // used to reduce redundant code after
     // those arrays will contain only enabled motors
-    std::vector<DxlMotorState *> xl320_motor_list; 
-    std::vector<DxlMotorState *> xl430_motor_list;
+    // (members : cleared but not reallocated each cycle)
+    xl320_id_list.clear();
+    xl430_id_list.clear();
+    xl320_motor_list.clear();
+    xl430_motor_list.clear();
 
     for (int i = 0; i < motors.size(); i++) {
         if (motors.at(i)->isEnabled()) {
@@ -291,99 +369,65 @@ void DxlCommunication::hardwareControlRead()
     {
         time_hw_data_last_read += 1.0/hw_data_read_frequency;
         
-        // read position
-        if (read_position_enable) {
-            // Read from XL320 motors
-            if (can_read_xl320) {
-                std::vector<uint32_t> position_list;
-                int read_position_result = xl320->syncReadPosition(xl320_id_list, position_list);
-                if (read_position_result == COMM_SUCCESS) {
+        // read position, velocity and load in one transaction (per motor family, or for all with bulk read)
+        if (read_position_enable || read_velocity_enable || read_torque_enable) {
+            // XL320 and XL430 motors in one bulk read
+            if (bulk_read_enabled && can_read_xl320 && can_read_xl430) {
+                bulk_id_list.assign(xl320_id_list.begin(), xl320_id_list.end());
+                bulk_id_list.insert(bulk_id_list.end(), xl430_id_list.begin(), xl430_id_list.end());
+                bulk_motor_list.assign(xl320_motor_list.begin(), xl320_motor_list.end());
+                bulk_motor_list.insert(bulk_motor_list.end(), xl430_motor_list.begin(), xl430_motor_list.end());
+                bulk_driver_list.assign(xl320_id_list.size(), xl320.get());
+                bulk_driver_list.insert(bulk_driver_list.end(), xl430_id_list.size(), xl430.get());
+
+                int read_state_result = xl320->bulkReadState(bulk_id_list, bulk_driver_list, 
+                        read_position_list, read_velocity_list, read_torque_list);
+                if (read_state_result == COMM_SUCCESS) {
                     xl320_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl320_motor_list.size(); i++) {
-                        xl320_motor_list.at(i)->setPositionState(position_list.at(i));
-                    }
-                }
-                else {
-                    xl320_hw_fail_counter_read++;
-                }
-            }
-
-            // Read from XL430 motors
-            if (can_read_xl430) {
-                std::vector<uint32_t> position_list;
-                int read_position_result = xl430->syncReadPosition(xl430_id_list, position_list);
-                if (read_position_result == COMM_SUCCESS) {
                     xl430_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl430_motor_list.size(); i++) {
-                        xl430_motor_list.at(i)->setPositionState(position_list.at(i));
+                    for (int i = 0; i < bulk_motor_list.size(); i++) {
+                        bulk_motor_list.at(i)->setPositionState(read_position_list.at(i));
+                        bulk_motor_list.at(i)->setVelocityState(read_velocity_list.at(i));
+                        bulk_motor_list.at(i)->setTorqueState(read_torque_list.at(i));
                     }
                 }
                 else {
+                    xl320_hw_fail_counter_read++;
                     xl430_hw_fail_counter_read++;
                 }
             }
-
-        }
-        
-        // read velocity
-        if (read_velocity_enable) {
-            if (can_read_xl320) {
-                std::vector<uint32_t> velocity_list;
-                int read_velocity_result = xl320->syncReadVelocity(xl320_id_list, velocity_list);
-                if (read_velocity_result == COMM_SUCCESS) {
-                    xl320_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl320_motor_list.size(); i++) {
-                        xl320_motor_list.at(i)->setVelocityState(velocity_list.at(i));
+            else {
+                // Read from XL320 motors
+                if (can_read_xl320) {
+                    int read_state_result = xl320->syncReadState(xl320_id_list, read_position_list, read_velocity_list, read_torque_list);
+                    if (read_state_result == COMM_SUCCESS) {
+                        xl320_hw_fail_counter_read = 0;
+                        for (int i = 0; i < xl320_motor_list.size(); i++) {
+                            xl320_motor_list.at(i)->setPositionState(read_position_list.at(i));
+                            xl320_motor_list.at(i)->setVelocityState(read_velocity_list.at(i));
+                            xl320_motor_list.at(i)->setTorqueState(read_torque_list.at(i));
+                        }
                     }
-                }
-                else {
-                    xl320_hw_fail_counter_read++;
-                }
-            }
-           
-            if (can_read_xl430) {
-                std::vector<uint32_t> velocity_list;
-                int read_velocity_result = xl430->syncReadVelocity(xl430_id_list, velocity_list);
-                if (read_velocity_result == COMM_SUCCESS) {
-                    xl430_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl430_motor_list.size(); i++) {
-                        xl430_motor_list.at(i)->setVelocityState(velocity_list.at(i));
+                    else {
+                        xl320_hw_fail_counter_read++;
                     }
                 }
-                else {
-                    xl430_hw_fail_counter_read++;
-                }
-            }
-        }
-        
-        // read load
-        if (read_torque_enable) {
-            if (can_read_xl320) {
-                std::vector<uint32_t> torque_list;
-                int read_torque_result = xl320->syncReadLoad(xl320_id_list, torque_list);
-                if (read_torque_result == COMM_SUCCESS) {
-                    xl320_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl320_motor_list.size(); i++) {
-                        xl320_motor_list.at(i)->setTorqueState(torque_list.at(i));
+
+                // Read from XL430 motors
+                if (can_read_xl430) {
+                    int read_state_result = xl430->syncReadState(xl430_id_list, read_position_list, read_velocity_list, read_torque_list);
+                    if (read_state_result == COMM_SUCCESS) {
+                        xl430_hw_fail_counter_read = 0;
+                        for (int i = 0; i < xl430_motor_list.size(); i++) {
+                            xl430_motor_list.at(i)->setPositionState(read_position_list.at(i));
+                            xl430_motor_list.at(i)->setVelocityState(read_velocity_list.at(i));
+                            xl430_motor_list.at(i)->setTorqueState(read_torque_list.at(i));
+                        }
                     }
-                }
-                else {
-                    xl320_hw_fail_counter_read++;
-                }
-            }
-            
-            if (can_read_xl430) {
-                std::vector<uint32_t> torque_list;
-                int read_torque_result = xl430->syncReadLoad(xl430_id_list, torque_list);
-                if (read_torque_result == COMM_SUCCESS) {
-                    xl430_hw_fail_counter_read = 0;
-                    for (int i = 0; i < xl430_motor_list.size(); i++) {
-                        xl430_motor_list.at(i)->setTorqueState(torque_list.at(i));
+                    else {
+                        xl430_hw_fail_counter_read++;
                     }
                 }
-                else {
-                    xl430_hw_fail_counter_read++;
-                }
             }
         }
         
@@ -395,6 +439,13 @@ void DxlCommunication::hardwareControlRead()
         if (rclcpp::Clock().now().seconds() - time_hw_status_last_read > 1.0/hw_status_read_frequency)
         {
             time_hw_status_last_read += 1.0/hw_status_read_frequency;
+
+            if (direction_control != DIRECTION_CONTROL_RS485) {
+                double turnaround_time, max_turnaround_time;
+                getBusTurnaroundTime(&turnaround_time, &max_turnaround_time);
+                RCLCPP_DEBUG(rclcpp::get_logger("DxlCommunication"),"Dxl bus turnaround time : %lf ms (max %lf ms)",
+                        turnaround_time * 1000.0, max_turnaround_time * 1000.0);
+            }
             
             // read temperature
             if (can_read_xl320) {
@@ -494,15 +545,65 @@ void DxlCommunication::hardwareControlRead()
     }
 }
 
+/*
+ * Write one register (DXL_WRITE_...) on XL320 and XL430 motors.
+ * If both models are present, a single bulk write carries the values for all
+ * of them, else (or if bulk write is disabled) one sync write per model.
+ */
+int DxlCommunication::writeMotorsRegister(int reg, std::vector<uint8_t> &xl320_ids, std::vector<uint32_t> &xl320_data,
+        std::vector<uint8_t> &xl430_ids, std::vector<uint32_t> &xl430_data)
+{
+    if (bulk_write_enabled && xl320_ids.size() > 0 && xl430_ids.size() > 0) {
+        bulk_write_id_list.clear();
+        bulk_write_driver_list.clear();
+        bulk_write_data_list.clear();
+
+        for (int i = 0; i < xl320_ids.size(); i++) {
+            bulk_write_id_list.push_back(xl320_ids.at(i));
+            bulk_write_driver_list.push_back(xl320.get());
+            bulk_write_data_list.push_back(xl320_data.at(i));
+        }
+        for (int i = 0; i < xl430_ids.size(); i++) {
+            bulk_write_id_list.push_back(xl430_ids.at(i));
+            bulk_write_driver_list.push_back(xl430.get());
+            bulk_write_data_list.push_back(xl430_data.at(i));
+        }
+
+        return xl320->bulkWrite(reg, bulk_write_id_list, bulk_write_driver_list, bulk_write_data_list);
+    }
+
+    int xl320_result = COMM_SUCCESS;
+    int xl430_result = COMM_SUCCESS;
+
+    switch (reg) {
+        case DXL_WRITE_TORQUE_ENABLE:
+            xl320_result = xl320->syncWriteTorqueEnable(xl320_ids, xl320_data);
+            xl430_result = xl430->syncWriteTorqueEnable(xl430_ids, xl430_data);
+            break;
+        case DXL_WRITE_GOAL_POSITION:
+            xl320_result = xl320->syncWritePositionGoal(xl320_ids, xl320_data);
+            xl430_result = xl430->syncWritePositionGoal(xl430_ids, xl430_data);
+            break;
+        case DXL_WRITE_GOAL_VELOCITY:
+            xl320_result = xl320->syncWriteVelocityGoal(xl320_ids, xl320_data);
+            xl430_result = xl430->syncWriteVelocityGoal(xl430_ids, xl430_data);
+            break;
+        default:
+            return COMM_NOT_AVAILABLE;
+    }
+
+    return (xl320_result != COMM_SUCCESS) ? xl320_result : xl430_result;
+}
+
 void DxlCommunication::hardwareControlWrite()
 {
-    std::vector<uint8_t> xl320_id_list;
-    std::vector<uint8_t> xl430_id_list;
-    
     // used to reduce redundant code after
     // those arrays will contain only enabled motors
-    std::vector<DxlMotorState *> xl320_motor_list; 
-    std::vector<DxlMotorState *> xl430_motor_list;
+    // (members : cleared but not reallocated each cycle)
+    xl320_id_list.clear();
+    xl430_id_list.clear();
+    xl320_motor_list.clear();
+    xl430_motor_list.clear();
 
     for (int i = 0; i < motors.size(); i++) {
         if (motors.at(i)->isEnabled()) {
@@ -584,10 +685,10 @@ void DxlCommunication::hardwareControlWrite()
                 xl430_torque_enable_list.push_back(torque_on);
             }
 
-            int xl320_result = xl320->syncWriteTorqueEnable(xl320_id_list, xl320_torque_enable_list);
-            int xl430_result = xl430->syncWriteTorqueEnable(xl430_id_list, xl430_torque_enable_list);
+            int result = writeMotorsRegister(DXL_WRITE_TORQUE_ENABLE, xl320_id_list, xl320_torque_enable_list,
+                    xl430_id_list, xl430_torque_enable_list);
 
-            if (xl320_result != COMM_SUCCESS || xl430_result != COMM_SUCCESS) { 
+            if (result != COMM_SUCCESS) { 
                 RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Failed to write torque enable"); 
             }
             else { 
@@ -602,22 +703,25 @@ void DxlCommunication::hardwareControlWrite()
         if (torque_on) {
             // write position (not for tool)
             if (write_position_enable) {
-                std::vector<uint32_t> xl320_position_list;
+                xl320_position_list.clear();
                 for (int i = 0; i < xl320_motor_list.size(); i++) {
                     xl320_position_list.push_back(xl320_motor_list.at(i)->getPositionCommand());
                 }
 
-                std::vector<uint32_t> xl430_position_list;
+                xl430_position_list.clear();
                 for (int i = 0; i < xl430_motor_list.size(); i++) {
                     xl430_position_list.push_back(xl430_motor_list.at(i)->getPositionCommand());
                 }
 
-                int xl320_result = xl320->syncWritePositionGoal(xl320_id_list, xl320_position_list);
-                int xl430_result = xl430->syncWritePositionGoal(xl430_id_list, xl430_position_list);
+                int result = writeMotorsRegister(DXL_WRITE_GOAL_POSITION, xl320_id_list, xl320_position_list,
+                        xl430_id_list, xl430_position_list);
 
-                if (xl320_result != COMM_SUCCESS || xl430_result != COMM_SUCCESS) {
+                if (result != COMM_SUCCESS) {
                     RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Failed to write position");
                 }
+                else {
+                    command_latency.onCommandSent();
+                }
             }
 
             // write velocity (not for tool)
@@ -632,10 +736,10 @@ void DxlCommunication::hardwareControlWrite()
                     xl430_velocity_list.push_back(xl430_motor_list.at(i)->getVelocityCommand());
                 }
 
-                int xl320_result = xl320->syncWriteVelocityGoal(xl320_id_list, xl320_velocity_list);
-                int xl430_result = xl430->syncWriteVelocityGoal(xl430_id_list, xl430_velocity_list);
+                int result = writeMotorsRegister(DXL_WRITE_GOAL_VELOCITY, xl320_id_list, xl320_velocity_list,
+                        xl430_id_list, xl430_velocity_list);
 
-                if (xl320_result != COMM_SUCCESS || xl430_result != COMM_SUCCESS) {
+                if (result != COMM_SUCCESS) {
                     RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Failed to write velocity");
                 }
             }
@@ -710,22 +814,48 @@ void DxlCommunication::hardwareControlWrite()
 void DxlCommunication::hardwareControlLoop()
 {
     rclcpp::Rate hw_control_loop_rate(hw_control_loop_frequency); 
+    RtLoopTimer hw_control_loop_timer("dxl_control_loop", hw_control_loop_frequency);
+    setupRtThread("dxl_control_loop", rt_config);
+
+    bus_jobs.attachOwner();
+
     while (rclcpp::ok()) {
-        if (!hw_is_busy && hw_control_loop_keep_alive) {
-            hw_is_busy = true;
-            
-            hardwareControlRead();
-            hardwareControlWrite();
+        if (hw_control_loop_keep_alive) {
+            {
+                std::unique_lock<std::recursive_mutex> bus_lock = bus_jobs.lockBus();
+                uint64_t time_cycle_start = statClockNs();
+
+                hardwareControlRead();
+                uint64_t time_stage_start = bus_stats.loop.read.recordSince(time_cycle_start);
+                publishJointState();
+                applyJointCommand();
+                time_stage_start = statClockNs();
+                hardwareControlWrite();
+                uint64_t time_cycle_end = bus_stats.loop.write.recordSince(time_stage_start);
+
+                bus_stats.loop.recordCycle(time_cycle_start, time_cycle_end, hw_control_loop_frequency);
+            }
+
+            // out-of-band requests from other threads (tool ping, scan), between two cycles
+            bus_jobs.runPendingJobs();
 
-            hw_is_busy = false;
-            hw_control_loop_rate.sleep();
+            if (rt_config.enabled) {
+                hw_control_loop_timer.sleep();
+            }
+            else {
+                hw_control_loop_rate.sleep();
+            }
         }
         else {
-            sleep_for(TIME_TO_WAIT_IF_BUSY);
+            // paused : bus is only used by jobs
+            bus_jobs.runPendingJobs();
+            bus_jobs.waitForJobs(TIME_TO_WAIT_IF_PAUSED);
             resetHardwareControlLoopRates();
-           // RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"HW control loop, wait because is busy");
+            hw_control_loop_timer.reset();
         }
     }
+
+    bus_jobs.detachOwner();
 }
 /*
  * Only use this method during calibration !!
@@ -764,62 +894,210 @@ void DxlCommunication::setControlMode(int control_mode)
     write_torque_enable = (control_mode == DXL_CONTROL_MODE_TORQUE);     // not implemented yet
 }
 
+/*
+ * Called from ros2_control write() : command is only published here,
+ * and converted to dxl positions by the control loop (applyJointCommand)
+ */
 void DxlCommunication::setGoalPositionV1(double axis_5_pos, double axis_6_pos) 
 {
     if (hardware_version == 1) {
-        // m5_1 and m5_2 have symetric position (rad 0.0 -> position 511 for both)
-        m5_1.setPositionCommand(rad_pos_to_xl320_pos(axis_5_pos));
-        m5_2.setPositionCommand(XL320_MIDDLE_POSITION * 2 - m5_1.getPositionCommand());
-        m6.setPositionCommand(rad_pos_to_xl320_pos(axis_6_pos));
-        
-        // if motor disabled, pos_state = pos_cmd (echo position)
-        for (int i = 0 ; i < motors.size(); i++) {
-            if (!motors.at(i)->isEnabled()) {
-                motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
-            }
-        }
+        JointCommandSnapshot &cmd = joint_command_buffer.writeBuffer();
+        cmd.position[4] = axis_5_pos;
+        cmd.position[5] = axis_6_pos;
+        command_latency.stampCommand(cmd);
+        joint_command_buffer.publish();
     }
 }
 
 void DxlCommunication::setGoalPositionV2(double axis_4_pos, double axis_5_pos, double axis_6_pos)
 {
     if (hardware_version == 2) {
-        m4.setPositionCommand(rad_pos_to_xl430_pos(axis_4_pos));
-        // m5 for V2 is placed at the previous m5_2 place
-        m5.setPositionCommand(XL430_MIDDLE_POSITION * 2 - rad_pos_to_xl430_pos(axis_5_pos));
-        m6.setPositionCommand(rad_pos_to_xl320_pos(axis_6_pos));
-        
-        // if motor disabled, pos_state = pos_cmd (echo position)
-        for (int i = 0 ; i < motors.size(); i++) {
-            if (!motors.at(i)->isEnabled()) {
-                motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
-            }
-        }
+        JointCommandSnapshot &cmd = joint_command_buffer.writeBuffer();
+        cmd.position[3] = axis_4_pos;
+        cmd.position[4] = axis_5_pos;
+        cmd.position[5] = axis_6_pos;
+        command_latency.stampCommand(cmd);
+        joint_command_buffer.publish();
     }
 }
 
+/*
+ * Called from ros2_control read() : returns last state published by the hardware thread (no wait)
+ */
 void DxlCommunication::getCurrentPositionV1(double *axis_5_pos, double *axis_6_pos)
 {
+    if (hardware_version == 1) {
+        joint_state_buffer.update();
+        const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+        *axis_5_pos = state.position[4];
+        *axis_6_pos = state.position[5];
+    }
+}
+
+void DxlCommunication::getCurrentPositionV2(double *axis_4_pos, double *axis_5_pos, double *axis_6_pos)
+{
+    if (hardware_version == 2) {
+        joint_state_buffer.update();
+        const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+        *axis_4_pos = state.position[3];
+        *axis_5_pos = state.position[4];
+        *axis_6_pos = state.position[5];
+    }
+}
+
+void DxlCommunication::getCurrentState(double pos[6], double vel[6], double eff[6])
+{
+    int first_axis = (hardware_version == 1) ? 4 : 3;
+
+    joint_state_buffer.update();
+    const JointStateSnapshot &state = joint_state_buffer.readBuffer();
+    for (int i = first_axis; i < NIRYO_ONE_AXIS_COUNT; i++) {
+        pos[i] = state.position[i];
+        vel[i] = state.velocity[i];
+        eff[i] = state.effort[i];
+    }
+    command_latency.onRead(state);
+}
+
+/*
+ * Publishes dxl motors positions, velocities and efforts for ros2_control read() (called by control loop only)
+ * - symetric motors (axis 5) have opposite velocity and load
+ */
+void DxlCommunication::publishJointState()
+{
+    JointStateSnapshot &state = joint_state_buffer.writeBuffer();
     if (hardware_version == 1) {
         if (m5_1.isEnabled()) {
-            *axis_5_pos = xl320_pos_to_rad_pos(m5_1.getPositionState());
+            state.position[4] = xl320_pos_to_rad_pos(m5_1.getPositionState());
+            state.velocity[4] = xl320_speed_to_rad_vel(m5_1.getVelocityState());
+            state.effort[4] = xl320_load_to_effort(m5_1.getTorqueState());
         }
         else { // in case motor 5_1 is disabled, take motor 5_2 (symetric) position for axis 5
-            *axis_5_pos = xl320_pos_to_rad_pos(XL320_MIDDLE_POSITION * 2 - m5_2.getPositionState());
+            state.position[4] = xl320_pos_to_rad_pos(XL320_MIDDLE_POSITION * 2 - m5_2.getPositionState());
+            state.velocity[4] = m5_2.isEnabled() ? -xl320_speed_to_rad_vel(m5_2.getVelocityState()) : 0.0;
+            state.effort[4] = m5_2.isEnabled() ? -xl320_load_to_effort(m5_2.getTorqueState()) : 0.0;
         }
-        *axis_6_pos = xl320_pos_to_rad_pos(m6.getPositionState());
+        state.position[5] = xl320_pos_to_rad_pos(m6.getPositionState());
+        state.velocity[5] = m6.isEnabled() ? xl320_speed_to_rad_vel(m6.getVelocityState()) : 0.0;
+        state.effort[5] = m6.isEnabled() ? xl320_load_to_effort(m6.getTorqueState()) : 0.0;
     }
+    else if (hardware_version == 2) {
+        state.position[3] = xl430_pos_to_rad_pos(m4.getPositionState());
+        state.velocity[3] = m4.isEnabled() ? xl430_velocity_to_rad_vel(m4.getVelocityState()) : 0.0;
+        state.effort[3] = m4.isEnabled() ? xl430_load_to_effort(m4.getTorqueState()) : 0.0;
+        state.position[4] = xl430_pos_to_rad_pos(XL430_MIDDLE_POSITION * 2 - m5.getPositionState());
+        state.velocity[4] = m5.isEnabled() ? -xl430_velocity_to_rad_vel(m5.getVelocityState()) : 0.0;
+        state.effort[4] = m5.isEnabled() ? -xl430_load_to_effort(m5.getTorqueState()) : 0.0;
+        state.position[5] = xl320_pos_to_rad_pos(m6.getPositionState());
+        state.velocity[5] = m6.isEnabled() ? xl320_speed_to_rad_vel(m6.getVelocityState()) : 0.0;
+        state.effort[5] = m6.isEnabled() ? xl320_load_to_effort(m6.getTorqueState()) : 0.0;
+    }
+    command_latency.onFeedback(state);
+    joint_state_buffer.publish();
 }
 
-void DxlCommunication::getCurrentPositionV2(double *axis_4_pos, double *axis_5_pos, double *axis_6_pos)
+/*
+ * Takes last command published by ros2_control write() (if any) into motors position command
+ */
+void DxlCommunication::applyJointCommand()
 {
-    if (hardware_version == 2) {
-        *axis_4_pos = xl430_pos_to_rad_pos(m4.getPositionState());
-        *axis_5_pos = xl430_pos_to_rad_pos(XL430_MIDDLE_POSITION * 2 - m5.getPositionState());
-        *axis_6_pos = xl320_pos_to_rad_pos(m6.getPositionState());
+    if (!joint_command_buffer.update()) {
+        return;
+    }
+    const JointCommandSnapshot &cmd = joint_command_buffer.readBuffer();
+    command_latency.onCommandApplied(cmd);
+
+    if (hardware_version == 1) {
+        // m5_1 and m5_2 have symetric position (rad 0.0 -> position 511 for both)
+        m5_1.setPositionCommand(rad_pos_to_xl320_pos(cmd.position[4]));
+        m5_2.setPositionCommand(XL320_MIDDLE_POSITION * 2 - m5_1.getPositionCommand());
+        m6.setPositionCommand(rad_pos_to_xl320_pos(cmd.position[5]));
+    }
+    else if (hardware_version == 2) {
+        m4.setPositionCommand(rad_pos_to_xl430_pos(cmd.position[3]));
+        // m5 for V2 is placed at the previous m5_2 place
+        m5.setPositionCommand(XL430_MIDDLE_POSITION * 2 - rad_pos_to_xl430_pos(cmd.position[4]));
+        m6.setPositionCommand(rad_pos_to_xl320_pos(cmd.position[5]));
+    }
+
+    // if motor disabled, pos_state = pos_cmd (echo position)
+    for (int i = 0 ; i < motors.size(); i++) {
+        if (!motors.at(i)->isEnabled()) {
+            motors.at(i)->setPositionState(motors.at(i)->getPositionCommand());
+        }
     }
 }
 
+/*
+ * Time spent writing a packet until the bus is released for the status packet (s)
+ */
+void DxlCommunication::getBusTurnaroundTime(double *turnaround_time, double *max_turnaround_time)
+{
+    *turnaround_time = dxlPortHandler->getTurnaroundTime() / 1000.0;
+    *max_turnaround_time = dxlPortHandler->getMaxTurnaroundTime() / 1000.0;
+}
+
+/*
+ * Response latency learned by the adaptive timeout (ms), -1 if not learned yet
+ */
+void DxlCommunication::getMotorsResponseLatency(std::vector<std::string> &motor_names, std::vector<double> &latencies)
+{
+    motor_names.clear();
+    latencies.clear();
+
+    for (int i = 0; i < motors.size(); i++) {
+        if (motors.at(i)->isEnabled()) {
+            motor_names.push_back(motors.at(i)->getName());
+            latencies.push_back(dxlPortHandler->getResponseLatency(motors.at(i)->getId()));
+        }
+    }
+
+    if (is_tool_connected) {
+        motor_names.push_back(tool.getName());
+        latencies.push_back(dxlPortHandler->getResponseLatency(tool.getId()));
+    }
+}
+
+/*
+ * Loop timings (window since last call), then status packet counters since start
+ */
+void DxlCommunication::getStatistics(HwStatisticsReport &report)
+{
+    report.name = "Dynamixel bus";
+    report.values.clear();
+    loop_stats_window.report(bus_stats.loop, report);
+
+    // not measured in rs485 mode : write() returns before the packet is sent
+    if (direction_control != DIRECTION_CONTROL_RS485) {
+        double turnaround_time, max_turnaround_time;
+        getBusTurnaroundTime(&turnaround_time, &max_turnaround_time); // s
+        report.values.push_back(std::make_pair("bus turnaround [ms]",
+                    std::to_string(turnaround_time * 1000.0) + ", max " + std::to_string(max_turnaround_time * 1000.0)));
+        // max over the report window : reset by the control loop thread, which measures it
+        bus_jobs.submit([this]() { dxlPortHandler->resetTurnaroundTime(); return (int) COMM_SUCCESS; });
+    }
+
+    std::vector<std::string> motor_names;
+    std::vector<double> latencies;
+    getMotorsResponseLatency(motor_names, latencies);
+    for (int i = 0; i < motor_names.size(); i++) {
+        report.values.push_back(std::make_pair("response latency " + motor_names.at(i) + " [ms]", std::to_string(latencies.at(i))));
+    }
+
+    for (int id = 0; id < DXL_STAT_ID_COUNT; id++) {
+        const DxlMotorStatistics &motor = bus_stats.motors[id];
+        if (motor.transactions.get() == 0) {
+            continue;
+        }
+        std::string key = (id == BROADCAST_ID) ? "status packets (group, no id)" : "status packets motor " + std::to_string(id);
+        report.values.push_back(std::make_pair(key,
+                    std::to_string(motor.transactions.get()) + ", timeout " + std::to_string(motor.rx_timeout.get())
+                    + ", corrupt " + std::to_string(motor.rx_corrupt.get()) + ", other errors " + std::to_string(motor.other_errors.get())));
+    }
+
+    command_latency.report(report);
+}
+
 void DxlCommunication::getHardwareStatus(bool *is_connection_ok, std::string &error_message, 
         int *calibration_needed, bool *calibration_in_progress,
         std::vector<std::string> &motor_names, std::vector<std::string> &motor_types,
@@ -921,27 +1199,24 @@ int DxlCommunication::pingAndSetTool(uint8_t id, std::string name)
         return TOOL_STATE_PING_OK;
     }
 
-    while (hw_is_busy) { 
-        sleep_for(TIME_TO_WAIT_IF_BUSY);   
-    }
-    hw_is_busy = true;
-
-    int retries = 3;
-    int ping_result = COMM_RX_FAIL;
+    // pings run on the control loop thread, between two cycles
+    int ping_result = bus_jobs.execute([this, id]() {
+        int retries = 3;
+        int ping_result = COMM_RX_FAIL;
 
-    while (retries > 0) {
-        ping_result = xl320->ping(id);
-        if (ping_result == COMM_SUCCESS) {
-            retries = 0;
-        }
-        else {
-            retries--;
+        while (retries > 0) {
+            ping_result = xl320->ping(id);
+            if (ping_result == COMM_SUCCESS) {
+                retries = 0;
+            }
+            else {
+                retries--;
+            }
         }
-    }
+        return ping_result;
+    });
 
     RCLCPP_INFO(rclcpp::get_logger("DxlCommunication"),"Ping Tool : ping result for id (%d) : %d", id, ping_result);
-
-    hw_is_busy = false;
     
     if (ping_result != COMM_SUCCESS) {
         RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Could not find tool with id: %d", id);
@@ -1093,25 +1368,9 @@ int DxlCommunication::pushAirVacuumPump(uint8_t id, uint16_t push_air_position)
         
 int DxlCommunication::scanAndCheck() 
 {
-    int counter = 0;
-
-    while (hw_is_busy && counter < 100) { 
-        sleep_for(TIME_TO_WAIT_IF_BUSY);    
-        counter++;
-    }
-    
-    if (counter == 100) {
-        debug_error_message = "Failed to scan motors, Dynamixel bus is too busy. Will retry...";
-        RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Failed to scan motors, dxl bus is too busy (counter max : %d). Will retry...", counter);
-        return COMM_PORT_BUSY;
-    }
-   
-    hw_is_busy = true;
-
-    // 1. Get all ids from dxl bus
+    // 1. Get all ids from dxl bus (between two control cycles if the loop is running)
     std::vector<uint8_t> id_list;
-    int result = xl320->scan(id_list);
-    hw_is_busy = false;
+    int result = bus_jobs.execute([this, &id_list]() { return xl320->scan(id_list); });
     
     if (result != COMM_SUCCESS) {
         if (result == COMM_RX_TIMEOUT) { // -3001
@@ -1190,25 +1449,9 @@ int DxlCommunication::scanAndCheck()
 
 int DxlCommunication::detectVersion()
 {
-    int counter = 0;
-
-    while (hw_is_busy && counter < 100) { 
-        sleep_for(TIME_TO_WAIT_IF_BUSY);    
-        counter++;
-    }
-    
-    if (counter == 100) {
-        debug_error_message = "Failed to scan motors, Dynamixel bus is too busy. Will retry...";
-        RCLCPP_WARN(rclcpp::get_logger("DxlCommunication"),"Failed to scan motors, dxl bus is too busy (counter max : %d)", counter);
-        return -1;
-    }
-   
-    hw_is_busy = true;
-
-    // 1. Get all ids from dxl bus
+    // 1. Get all ids from dxl bus (between two control cycles if the loop is running)
     std::vector<uint8_t> id_list;
-    int result = xl320->scan(id_list);
-    hw_is_busy = false;
+    int result = bus_jobs.execute([this, &id_list]() { return xl320->scan(id_list); });
     
     if (result != COMM_SUCCESS) {
         if (result == COMM_RX_TIMEOUT) { // -3001
@@ -1230,7 +1473,7 @@ int DxlCommunication::detectVersion()
     // Check if motor (MOTOR_4, Model : XL-430) is connected --> V2
     if (std::find(id_list.begin(), id_list.end(), DXL_MOTOR_4_ID) != id_list.end()) {
         // found the motor in the list, now check if model number matches XL-430 motors
-        if (xl430->checkModelNumber(DXL_MOTOR_4_ID) == 0) {
+        if (bus_jobs.execute([this]() { return xl430->checkModelNumber(DXL_MOTOR_4_ID); }) == 0) {
             // we are now sure MOTOR_4 is connected and it is a XL-430 motor
             return 2; // --> version 2
         }
@@ -1239,7 +1482,7 @@ int DxlCommunication::detectVersion()
     // Check if motor (MOTOR_5, Model : XL-430) is connected --> V2
     if (std::find(id_list.begin(), id_list.end(), DXL_MOTOR_5_ID) != id_list.end()) {
         // found the motor in the list, now check if model number matches XL-430 motors
-        if (xl430->checkModelNumber(DXL_MOTOR_5_ID) == 0) {
+        if (bus_jobs.execute([this]() { return xl430->checkModelNumber(DXL_MOTOR_5_ID); }) == 0) {
             // we are now sure MOTOR_5 is connected and it is a XL-430 motor
             return 2; // --> version 2
         }
@@ -1248,7 +1491,7 @@ int DxlCommunication::detectVersion()
     // Check if motor (MOTOR_5_1, Model : XL-320) is connected --> V1
     if (std::find(id_list.begin(), id_list.end(), DXL_MOTOR_5_1_ID) != id_list.end()) {
         // found the motor in the list, now check if model number matches XL-320 motors
-        if (xl320->checkModelNumber(DXL_MOTOR_5_1_ID) == 0) {
+        if (bus_jobs.execute([this]() { return xl320->checkModelNumber(DXL_MOTOR_5_1_ID); }) == 0) {
             // we are now sure MOTOR_5_1 is connected and it is a XL-320 motor
             return 1; // --> version 1
         }
@@ -1257,7 +1500,7 @@ int DxlCommunication::detectVersion()
     // Check if motor (MOTOR_5_2, Model : XL-320) is connected --> V1
     if (std::find(id_list.begin(), id_list.end(), DXL_MOTOR_5_2_ID) != id_list.end()) {
         // found the motor in the list, now check if model number matches XL-320 motors
-        if (xl320->checkModelNumber(DXL_MOTOR_5_2_ID) == 0) {
+        if (bus_jobs.execute([this]() { return xl320->checkModelNumber(DXL_MOTOR_5_2_ID); }) == 0) {
             // we are now sure MOTOR_5_2 is connected and it is a XL-320 motor
             return 1; // --> version 1
         }
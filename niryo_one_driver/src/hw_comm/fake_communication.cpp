@@ -117,6 +117,15 @@ void FakeCommunication::getCurrentPosition(double pos[6])
     }
 }
 
+void FakeCommunication::getCurrentState(double pos[6], double vel[6], double eff[6])
+{
+    for (int i = 0 ; i < 6 ; i++) {
+        pos[i] = echo_pos[i];
+        vel[i] = 0.0;
+        eff[i] = 0.0;
+    }
+}
+
 void FakeCommunication::getCurrentGripperPosition(double& pos)
 {
     pos = gripper_pos; 
@@ -156,6 +165,11 @@ void FakeCommunication::getFirmwareVersions(std::vector<std::string> &motor_name
     //RCLCPP_INFO(rclcpp::get_logger("FakeCommunication"),"Get firmware versions");
 }
 
+void FakeCommunication::getHardwareStatistics(std::vector<HwStatisticsReport> &reports)
+{
+    reports.clear();
+}
+
 void FakeCommunication::activateLearningMode(bool activate)
 {
     RCLCPP_INFO(rclcpp::get_logger("FakeCommunication"),"Activate learning mode : %d", activate);
@@ -18,6 +18,7 @@
 */
 
 #include "niryo_one_driver/niryo_one_communication.h"
+#include "niryo_one_driver/tracing.h"
 
 using namespace std::chrono_literals;
 NiryoOneCommunication::NiryoOneCommunication(int hardware_version,rclcpp::Node::SharedPtr node)
@@ -479,6 +480,19 @@ void NiryoOneCommunication::getFirmwareVersions(std::vector<std::string> &motor_
     motor_names.insert(motor_names.end(), can_motor_names.begin(), can_motor_names.end());
 }
 
+void NiryoOneCommunication::getHardwareStatistics(std::vector<HwStatisticsReport> &reports)
+{
+    reports.resize((can_enabled ? 1 : 0) + (dxl_enabled ? 1 : 0));
+    int index = 0;
+
+    if (can_enabled) {
+        canComm->getStatistics(reports.at(index++));
+    }
+    if (dxl_enabled) {
+        dxlComm->getStatistics(reports.at(index++));
+    }
+}
+
 void NiryoOneCommunication::getCurrentPosition(double pos[6])
 {
     if (hardware_version == 1) {
@@ -517,6 +531,38 @@ void NiryoOneCommunication::getCurrentPosition(double pos[6])
     }
 }
 
+/*
+ * Positions, velocities and efforts of the 6 axis, for ros2_control read()
+ * - disabled bus (debug purposes) : default position, zero velocity and effort
+ */
+void NiryoOneCommunication::getCurrentState(double pos[6], double vel[6], double eff[6])
+{
+    for (int i = 0; i < 6; i++) {
+        vel[i] = 0.0;
+        eff[i] = 0.0;
+    }
+
+    if (can_enabled) { canComm->getCurrentState(pos, vel, eff); }
+    if (dxl_enabled) { dxlComm->getCurrentState(pos, vel, eff); }
+
+    if (hardware_version == 1) {
+        if (!can_enabled) {
+            for (int i = 0; i < 4; i++) { pos[i] = pos_can_disabled_v1[i]; }
+        }
+        if (!dxl_enabled) {
+            for (int i = 0; i < 2; i++) { pos[4 + i] = pos_dxl_disabled_v1[i]; }
+        }
+    }
+    else if (hardware_version == 2) {
+        if (!can_enabled) {
+            for (int i = 0; i < 3; i++) { pos[i] = pos_can_disabled_v2[i]; }
+        }
+        if (!dxl_enabled) {
+            for (int i = 0; i < 3; i++) { pos[3 + i] = pos_dxl_disabled_v2[i]; }
+        }
+    }
+}
+
 void NiryoOneCommunication::getCurrentGripperPosition(double& pos)
 {
     if (dxl_enabled){
@@ -538,6 +584,8 @@ void NiryoOneCommunication::sendPositionToRobot(const double cmd[6])
         is_calibration_in_progress = canComm->isCalibrationInProgress();
     }
 
+    NIRYO_TRACEPOINT(send_position_to_robot, cmd, is_calibration_in_progress ? 1 : 0);
+
     // don't send position command when calibrating motors
     if (!is_calibration_in_progress) {
         if (hardware_version == 1) {
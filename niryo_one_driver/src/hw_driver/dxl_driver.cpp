@@ -23,6 +23,13 @@ DxlDriver::DxlDriver(dynamixel::PortHandler *portHandler, dynamixel::PacketHandl
 {
     this->portHandler = portHandler;
     this->packetHandler = packetHandler;
+
+    fast_read_enabled = false;
+    for (int i = 0; i < 256; i++) {
+        fast_read_support[i] = -1;
+    }
+    group_bulk_read_fast_read_fails = 0;
+    statistics = NULL;
 }
 
 int DxlDriver::ping(uint8_t id)
@@ -30,6 +37,7 @@ int DxlDriver::ping(uint8_t id)
     uint8_t dxl_error = 0;
     
     int result = packetHandler->ping(portHandler, id, &dxl_error);
+    recordResult(id, result);
     
     if (dxl_error != 0) {
         return dxl_error; 
@@ -43,6 +51,7 @@ int DxlDriver::getModelNumber(uint8_t id, uint16_t *dxl_model_number)
     uint8_t dxl_error = 0;
 
     int result = packetHandler->ping(portHandler, id, dxl_model_number, &dxl_error);
+    recordResult(id, result);
     
     if (dxl_error != 0) {
         return dxl_error; 
@@ -51,6 +60,24 @@ int DxlDriver::getModelNumber(uint8_t id, uint16_t *dxl_model_number)
     return result;
 }
 
+/*
+ * Fast Sync Read / Fast Bulk Read support, detected once per id from model number and firmware version
+ */
+bool DxlDriver::isFastReadSupported(uint8_t id)
+{
+    if (fast_read_support[id] < 0) {
+        uint16_t model_number = 0;
+        uint32_t firmware_version = 0;
+
+        if (getModelNumber(id, &model_number) != COMM_SUCCESS
+                || readFirmwareVersion(id, &firmware_version) != COMM_SUCCESS) {
+            return false; // not saved : detected again next time
+        }
+        fast_read_support[id] = supportsFastRead(model_number, firmware_version) ? 1 : 0;
+    }
+    return fast_read_support[id] == 1;
+}
+
 int DxlDriver::scan(std::vector<uint8_t> &id_list) 
 {
     return packetHandler->broadcastPing(portHandler, id_list);
@@ -70,98 +97,200 @@ int DxlDriver::reboot(uint8_t id)
 }
 
 /*
- *  -----------------   SYNC WRITE   --------------------
+ *  -----------------   GROUP OBJECTS   --------------------
  */
 
-int DxlDriver::syncWrite1Byte(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+/*
+ * Group sync read/write objects are kept between calls (one per address and data length).
+ * Their params are only rebuilt when the id list changes, so that a control loop
+ * always reading/writing the same motors does not allocate memory.
+ */
+dynamixel::GroupSyncRead *DxlDriver::getGroupSyncRead(uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list)
 {
-    dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, address, DXL_LEN_ONE_BYTE);
+    dynamixel::GroupSyncRead *groupSyncRead = NULL;
 
-    if (id_list.size() != data_list.size()) {
-        return LEN_ID_DATA_NOT_SAME; 
+    for (int i = 0; i < group_sync_read_list.size(); i++) {
+        if (group_sync_read_list.at(i)->getStartAddress() == address 
+                && group_sync_read_list.at(i)->getDataLength() == data_len) {
+            groupSyncRead = group_sync_read_list.at(i).get();
+            break;
+        }
+    }
+    if (groupSyncRead == NULL) {
+        group_sync_read_list.push_back(std::unique_ptr<dynamixel::GroupSyncRead>(
+                    new dynamixel::GroupSyncRead(portHandler, packetHandler, address, data_len)));
+        group_sync_read_fast_read_fails.push_back(0);
+        groupSyncRead = group_sync_read_list.back().get();
     }
 
-    if (id_list.size() == 0) {
-        return COMM_SUCCESS;
+    if (groupSyncRead->getIdList() != id_list) {
+        groupSyncRead->clearParam();
+        bool fast_read = fast_read_enabled;
+        for (int i = 0; i < id_list.size(); i++) {
+            if (!groupSyncRead->addParam(id_list.at(i))) {
+                groupSyncRead->clearParam();
+                return NULL;
+            }
+            fast_read = fast_read && isFastReadSupported(id_list.at(i));
+        }
+        groupSyncRead->setFastRead(fast_read);
+        getFastReadFailCounter(groupSyncRead) = 0;
     }
-    
-    std::vector<uint8_t>::iterator it_id;
-    std::vector<uint32_t>::iterator it_data;
-
-    for (it_id=id_list.begin(), it_data=data_list.begin() ; 
-            it_id < id_list.end() && it_data < data_list.end() ; 
-            it_id++, it_data++) {
-        uint8_t params[1] = { (uint8_t)(*it_data) };
-        if (!groupSyncWrite.addParam(*it_id, params)) {
-            groupSyncWrite.clearParam();
-            return GROUP_SYNC_REDONDANT_ID; 
+    return groupSyncRead;
+}
+
+int &DxlDriver::getFastReadFailCounter(dynamixel::GroupSyncRead *group)
+{
+    for (int i = 0; i < group_sync_read_list.size(); i++) {
+        if (group_sync_read_list.at(i).get() == group) {
+            return group_sync_read_fast_read_fails.at(i);
         }
     }
-    
-    int dxl_comm_result = groupSyncWrite.txPacket();
-    groupSyncWrite.clearParam();
-    return dxl_comm_result;
+    return group_bulk_read_fast_read_fails; // not reached : groups are created by getGroupSyncRead()
 }
 
-int DxlDriver::syncWrite2Bytes(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+int &DxlDriver::getFastReadFailCounter(dynamixel::GroupBulkRead *group)
 {
-    dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, address, DXL_LEN_TWO_BYTES);
+    return group_bulk_read_fast_read_fails;
+}
 
-    if (id_list.size() != data_list.size()) {
-        return LEN_ID_DATA_NOT_SAME; 
+/*
+ * If a fast read fails, the same read is sent again with the normal sync/bulk read instruction.
+ * When the normal read succeeds but the fast read of this group failed DXL_FAST_READ_MAX_FAIL times
+ * in a row, the group stops using fast read (until its motors change). Other groups keep their mode.
+ */
+template <typename Group>
+int DxlDriver::groupReadTxRx(Group *group)
+{
+    if (!group->getFastRead()) {
+        int dxl_comm_result = group->txRxPacket();
+        recordGroupRead(group, dxl_comm_result);
+        return dxl_comm_result;
     }
-    
-    if (id_list.size() == 0) {
-        return COMM_SUCCESS;
+
+    int &fast_read_fail_counter = getFastReadFailCounter(group);
+    int dxl_comm_result = group->txRxPacket();
+    recordGroupRead(group, dxl_comm_result);
+    if (dxl_comm_result == COMM_SUCCESS) {
+        fast_read_fail_counter = 0;
+        return dxl_comm_result;
     }
-    
-    std::vector<uint8_t>::iterator it_id;
-    std::vector<uint32_t>::iterator it_data;
-
-    for (it_id=id_list.begin(), it_data=data_list.begin() ; 
-            it_id < id_list.end() && it_data < data_list.end() ; 
-            it_id++, it_data++) {
-        uint8_t params[2] = { DXL_LOBYTE((uint16_t)(*it_data)), DXL_HIBYTE((uint16_t)(*it_data)) };
-        if (!groupSyncWrite.addParam(*it_id, params)) {
-            groupSyncWrite.clearParam();
-            return GROUP_SYNC_REDONDANT_ID;
-        }
+
+    group->setFastRead(false);
+    dxl_comm_result = group->txRxPacket();
+    recordGroupRead(group, dxl_comm_result);
+
+    if (dxl_comm_result == COMM_SUCCESS) {
+        fast_read_fail_counter++;
+    }
+    if (fast_read_fail_counter < DXL_FAST_READ_MAX_FAIL) {
+        group->setFastRead(true);
+    }
+    else {
+        fast_read_fail_counter = 0;
     }
-    
-    int dxl_comm_result = groupSyncWrite.txPacket();
-    groupSyncWrite.clearParam();
     return dxl_comm_result;
 }
 
-int DxlDriver::syncWrite4Bytes(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+/*
+ * Status packets are read in id order : ids before the failed one answered, later ids were not read.
+ * A failure not attributed to an id (tx error, whole fast read packet) is recorded on the broadcast id.
+ */
+template <typename Group>
+void DxlDriver::recordGroupRead(Group *group, int result)
 {
-    dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, address, DXL_LEN_FOUR_BYTES);
+    if (statistics == NULL) {
+        return;
+    }
+
+    int failed_id = group->getFailedId();
+    if (result != COMM_SUCCESS && failed_id < 0) {
+        statistics->recordResult(BROADCAST_ID, result);
+        return;
+    }
+
+    const std::vector<uint8_t> &id_list = group->getIdList();
+    for (int i = 0; i < id_list.size(); i++) {
+        if (result != COMM_SUCCESS && id_list.at(i) == failed_id) {
+            statistics->recordResult(id_list.at(i), result);
+            return;
+        }
+        statistics->recordResult(id_list.at(i), COMM_SUCCESS);
+    }
+}
+
+dynamixel::GroupSyncWrite *DxlDriver::getGroupSyncWrite(uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list)
+{
+    dynamixel::GroupSyncWrite *groupSyncWrite = NULL;
+
+    for (int i = 0; i < group_sync_write_list.size(); i++) {
+        if (group_sync_write_list.at(i)->getStartAddress() == address 
+                && group_sync_write_list.at(i)->getDataLength() == data_len) {
+            groupSyncWrite = group_sync_write_list.at(i).get();
+            break;
+        }
+    }
+    if (groupSyncWrite == NULL) {
+        group_sync_write_list.push_back(std::unique_ptr<dynamixel::GroupSyncWrite>(
+                    new dynamixel::GroupSyncWrite(portHandler, packetHandler, address, data_len)));
+        groupSyncWrite = group_sync_write_list.back().get();
+    }
+
+    if (groupSyncWrite->getIdList() != id_list) {
+        uint8_t empty_params[DXL_LEN_FOUR_BYTES] = { 0 }; // replaced by changeParam before sending
+        groupSyncWrite->clearParam();
+        for (int i = 0; i < id_list.size(); i++) {
+            if (!groupSyncWrite->addParam(id_list.at(i), empty_params)) {
+                groupSyncWrite->clearParam();
+                return NULL;
+            }
+        }
+    }
+    return groupSyncWrite;
+}
 
+/*
+ *  -----------------   SYNC WRITE   --------------------
+ */
+
+int DxlDriver::syncWrite(uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+{
     if (id_list.size() != data_list.size()) {
         return LEN_ID_DATA_NOT_SAME; 
     }
-    
+
     if (id_list.size() == 0) {
         return COMM_SUCCESS;
     }
-    
-    std::vector<uint8_t>::iterator it_id;
-    std::vector<uint32_t>::iterator it_data;
-
-    for (it_id=id_list.begin(), it_data=data_list.begin() ; 
-            it_id < id_list.end() && it_data < data_list.end() ; 
-            it_id++, it_data++) {
-        uint8_t params[4] = { DXL_LOBYTE(DXL_LOWORD(*it_data)), DXL_HIBYTE(DXL_LOWORD(*it_data)),
-            DXL_LOBYTE(DXL_HIWORD(*it_data)), DXL_HIBYTE(DXL_HIWORD(*it_data)) };
-        if (!groupSyncWrite.addParam(*it_id, params)) {
-            groupSyncWrite.clearParam();
-            return GROUP_SYNC_REDONDANT_ID;
-        }
+
+    dynamixel::GroupSyncWrite *groupSyncWrite = getGroupSyncWrite(address, data_len, id_list);
+    if (groupSyncWrite == NULL) {
+        return GROUP_SYNC_REDONDANT_ID;
     }
-    
-    int dxl_comm_result = groupSyncWrite.txPacket();
-    groupSyncWrite.clearParam();
-    return dxl_comm_result;
+
+    for (int i = 0; i < id_list.size(); i++) {
+        uint32_t data = data_list.at(i);
+        uint8_t params[4] = { DXL_LOBYTE(DXL_LOWORD(data)), DXL_HIBYTE(DXL_LOWORD(data)),
+            DXL_LOBYTE(DXL_HIWORD(data)), DXL_HIBYTE(DXL_HIWORD(data)) }; // only data_len first bytes are used
+        groupSyncWrite->changeParam(id_list.at(i), params);
+    }
+
+    return groupSyncWrite->txPacket();
+}
+
+int DxlDriver::syncWrite1Byte(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+{
+    return syncWrite(address, DXL_LEN_ONE_BYTE, id_list, data_list);
+}
+
+int DxlDriver::syncWrite2Bytes(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+{
+    return syncWrite(address, DXL_LEN_TWO_BYTES, id_list, data_list);
+}
+
+int DxlDriver::syncWrite4Bytes(uint8_t address, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
+{
+    return syncWrite(address, DXL_LEN_FOUR_BYTES, id_list, data_list);
 }
 
 /*
@@ -175,6 +304,7 @@ int DxlDriver::read1Byte(uint8_t address, uint8_t id, uint32_t *data)
 
     uint8_t read_data;
     dxl_comm_result = packetHandler->read1ByteTxRx(portHandler, id, address, &read_data, &dxl_error);
+    recordResult(id, dxl_comm_result);
     (*data) = read_data;
 
     if (dxl_error != 0) {
@@ -191,6 +321,7 @@ int DxlDriver::read2Bytes(uint8_t address, uint8_t id, uint32_t *data)
 
     uint16_t read_data;
     dxl_comm_result = packetHandler->read2ByteTxRx(portHandler, id, address, &read_data, &dxl_error);
+    recordResult(id, dxl_comm_result);
     (*data) = read_data;
 
     if (dxl_error != 0) {
@@ -207,6 +338,7 @@ int DxlDriver::read4Bytes(uint8_t address, uint8_t id, uint32_t *data)
 
     uint32_t read_data;
     dxl_comm_result = packetHandler->read4ByteTxRx(portHandler, id, address, &read_data, &dxl_error);
+    recordResult(id, dxl_comm_result);
     (*data) = read_data;
 
     if (dxl_error != 0) {
@@ -223,41 +355,184 @@ int DxlDriver::read4Bytes(uint8_t address, uint8_t id, uint32_t *data)
 int DxlDriver::syncRead(uint8_t address, uint8_t data_len, std::vector<uint8_t> &id_list, std::vector<uint32_t> &data_list)
 {
     data_list.clear();
-    dynamixel::GroupSyncRead groupSyncRead(portHandler, packetHandler, address, data_len);
+    dynamixel::GroupSyncRead *groupSyncRead = getGroupSyncRead(address, data_len, id_list);
     bool dxl_getdata_result = false;
     int dxl_comm_result = COMM_TX_FAIL;
     std::vector<uint8_t>::iterator it_id;
 
-    for (it_id=id_list.begin() ; it_id < id_list.end() ; it_id++) {
-        if (!groupSyncRead.addParam(*it_id)) {
-            groupSyncRead.clearParam();
-            return GROUP_SYNC_REDONDANT_ID;
-        }
+    if (groupSyncRead == NULL) {
+        return GROUP_SYNC_REDONDANT_ID;
     }
-    dxl_comm_result = groupSyncRead.txRxPacket();
+    dxl_comm_result = groupReadTxRx(groupSyncRead);
 
     if (dxl_comm_result != COMM_SUCCESS) {
-        groupSyncRead.clearParam();
         return dxl_comm_result;
     }
     for (it_id=id_list.begin() ; it_id < id_list.end() ; it_id++) {
-        dxl_getdata_result = groupSyncRead.isAvailable(*it_id, address, data_len);
+        dxl_getdata_result = groupSyncRead->isAvailable(*it_id, address, data_len);
         if (!dxl_getdata_result) {
-            groupSyncRead.clearParam();
             return GROUP_SYNC_READ_RX_FAIL;
         }
         if (data_len == DXL_LEN_ONE_BYTE) {
-            data_list.push_back((uint8_t)groupSyncRead.getData(*it_id, address, data_len));
+            data_list.push_back((uint8_t)groupSyncRead->getData(*it_id, address, data_len));
         }
         else if (data_len == DXL_LEN_TWO_BYTES) {
-            data_list.push_back((uint16_t)groupSyncRead.getData(*it_id, address, data_len));
+            data_list.push_back((uint16_t)groupSyncRead->getData(*it_id, address, data_len));
         }
         else if (data_len == DXL_LEN_FOUR_BYTES) {
-            data_list.push_back((uint32_t)groupSyncRead.getData(*it_id, address, data_len));
+            data_list.push_back((uint32_t)groupSyncRead->getData(*it_id, address, data_len));
+        }
+    }
+
+    return dxl_comm_result;
+
+}
+
+/*
+ * Reads a contiguous register window [address, address + block_len[ on all motors
+ * in one transaction, then decodes each field into its own list (same order as id_list)
+ */
+int DxlDriver::syncReadBlock(uint8_t address, uint8_t block_len, std::vector<uint8_t> &id_list,
+        const DxlBlockField *fields, std::vector<uint32_t> **data_lists, int field_count)
+{
+    for (int f = 0; f < field_count; f++) {
+        data_lists[f]->clear();
+    }
+
+    dynamixel::GroupSyncRead *groupSyncRead = getGroupSyncRead(address, block_len, id_list);
+    int dxl_comm_result = COMM_TX_FAIL;
+    std::vector<uint8_t>::iterator it_id;
+
+    if (groupSyncRead == NULL) {
+        return GROUP_SYNC_REDONDANT_ID;
+    }
+    dxl_comm_result = groupReadTxRx(groupSyncRead);
+
+    if (dxl_comm_result != COMM_SUCCESS) {
+        return dxl_comm_result;
+    }
+    for (it_id=id_list.begin() ; it_id < id_list.end() ; it_id++) {
+        for (int f = 0; f < field_count; f++) {
+            if (!groupSyncRead->isAvailable(*it_id, fields[f].address, fields[f].len)) {
+                return GROUP_SYNC_READ_RX_FAIL;
+            }
+            data_lists[f]->push_back(groupSyncRead->getData(*it_id, fields[f].address, fields[f].len));
+        }
+    }
+
+    return dxl_comm_result;
+}
+
+int DxlDriver::syncReadState(std::vector<uint8_t> &id_list, std::vector<uint32_t> &position_list,
+        std::vector<uint32_t> &velocity_list, std::vector<uint32_t> &load_list)
+{
+    const DxlStateBlock &block = getStateBlock();
+    DxlBlockField fields[3] = { block.position, block.velocity, block.load };
+    std::vector<uint32_t> *data_lists[3] = { &position_list, &velocity_list, &load_list };
+    return syncReadBlock(block.address, block.len, id_list, fields, data_lists, 3);
+}
+
+/*
+ *  -----------------   BULK READ   --------------------
+ */
+
+/*
+ * One bulk read instruction for motors of different models (XL320 + XL430) :
+ * each id reads the state block given by its own driver
+ */
+int DxlDriver::bulkReadState(std::vector<uint8_t> &id_list, std::vector<DxlDriver *> &driver_list,
+        std::vector<uint32_t> &position_list, std::vector<uint32_t> &velocity_list,
+        std::vector<uint32_t> &load_list)
+{
+    position_list.clear();
+    velocity_list.clear();
+    load_list.clear();
+
+    if (id_list.size() != driver_list.size()) {
+        return LEN_ID_DATA_NOT_SAME;
+    }
+
+    if (!group_bulk_read) {
+        group_bulk_read.reset(new dynamixel::GroupBulkRead(portHandler, packetHandler));
+    }
+    int dxl_comm_result = COMM_TX_FAIL;
+
+    // params only rebuilt if motors changed
+    if (group_bulk_read->getIdList() != id_list || group_bulk_read_driver_list != driver_list) {
+        group_bulk_read->clearParam();
+        group_bulk_read_driver_list = driver_list;
+        bool fast_read = fast_read_enabled;
+        for (int i = 0; i < id_list.size(); i++) {
+            const DxlStateBlock &block = driver_list.at(i)->getStateBlock();
+            if (!group_bulk_read->addParam(id_list.at(i), block.address, block.len)) {
+                group_bulk_read->clearParam();
+                group_bulk_read_driver_list.clear();
+                return GROUP_SYNC_REDONDANT_ID;
+            }
+            fast_read = fast_read && driver_list.at(i)->isFastReadSupported(id_list.at(i));
+        }
+        group_bulk_read->setFastRead(fast_read);
+        group_bulk_read_fast_read_fails = 0;
+    }
+    dxl_comm_result = groupReadTxRx(group_bulk_read.get());
+
+    if (dxl_comm_result != COMM_SUCCESS) {
+        return dxl_comm_result;
+    }
+    for (int i = 0; i < id_list.size(); i++) {
+        const DxlStateBlock &block = driver_list.at(i)->getStateBlock();
+        uint8_t id = id_list.at(i);
+        if (!group_bulk_read->isAvailable(id, block.position.address, block.position.len)
+                || !group_bulk_read->isAvailable(id, block.velocity.address, block.velocity.len)
+                || !group_bulk_read->isAvailable(id, block.load.address, block.load.len)) {
+            return GROUP_SYNC_READ_RX_FAIL;
         }
+        position_list.push_back(group_bulk_read->getData(id, block.position.address, block.position.len));
+        velocity_list.push_back(group_bulk_read->getData(id, block.velocity.address, block.velocity.len));
+        load_list.push_back(group_bulk_read->getData(id, block.load.address, block.load.len));
     }
 
-    groupSyncRead.clearParam();
     return dxl_comm_result;
+}
+
+int DxlDriver::bulkWrite(int reg, std::vector<uint8_t> &id_list, std::vector<DxlDriver *> &driver_list,
+        std::vector<uint32_t> &data_list)
+{
+    if (id_list.size() != data_list.size() || id_list.size() != driver_list.size()) {
+        return LEN_ID_DATA_NOT_SAME;
+    }
+
+    if (id_list.size() == 0) {
+        return COMM_SUCCESS;
+    }
+
+    std::unique_ptr<dynamixel::GroupBulkWrite> &group_bulk_write = group_bulk_write_list[reg];
+    if (!group_bulk_write) {
+        group_bulk_write.reset(new dynamixel::GroupBulkWrite(portHandler, packetHandler));
+    }
+
+    // params only rebuilt if motors changed, else data is changed in place
+    bool rebuild_params = (group_bulk_write->getIdList() != id_list || group_bulk_write_driver_list[reg] != driver_list);
+    if (rebuild_params) {
+        group_bulk_write->clearParam();
+        group_bulk_write_driver_list[reg] = driver_list;
+    }
+
+    for (int i = 0; i < id_list.size(); i++) {
+        const DxlBlockField &field = driver_list.at(i)->getWriteRegisters().field[reg];
+        uint32_t data = data_list.at(i);
+        uint8_t params[4] = { DXL_LOBYTE(DXL_LOWORD(data)), DXL_HIBYTE(DXL_LOWORD(data)),
+            DXL_LOBYTE(DXL_HIWORD(data)), DXL_HIBYTE(DXL_HIWORD(data)) }; // only field.len first bytes are used
+
+        if (!rebuild_params) {
+            group_bulk_write->changeParam(id_list.at(i), field.address, field.len, params);
+        }
+        else if (!group_bulk_write->addParam(id_list.at(i), field.address, field.len, params)) {
+            group_bulk_write->clearParam();
+            group_bulk_write_driver_list[reg].clear();
+            return GROUP_SYNC_REDONDANT_ID;
+        }
+    }
 
+    return group_bulk_write->txPacket();
 }
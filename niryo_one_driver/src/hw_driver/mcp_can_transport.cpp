@@ -0,0 +1,238 @@
+/*
+    mcp_can_transport.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/mcp_can_transport.h"
+#include "rclcpp/rclcpp.hpp"
+
+void sleep_for(double seconds);
+
+/*
+ * MCP_CAN takes standard ids in the upper 16 bits of masks and filters
+ * (lower bits are matched against the first two data bytes)
+ */
+static INT32U mcpStandardId(INT32U id)
+{
+    return (id & 0x7FF) << 16;
+}
+
+McpCanTransport::McpCanTransport(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt,
+        std::string rx_filter_profile)
+{
+    mcp_can.reset(new MCP_CAN(spi_channel, spi_baudrate, gpio_can_interrupt));
+    this->rx_filter_profile = rx_filter_profile;
+    is_initialized = false;
+}
+
+INT8U McpCanTransport::setup()
+{
+    if (!mcp_can->setupInterruptGpio()) {
+        RCLCPP_ERROR(rclcpp::get_logger("McpCanTransport"), "Failed to start gpio");
+        return CAN_GPIO_FAILINIT;
+    }
+    if (!mcp_can->setupSpi()) {
+        RCLCPP_ERROR(rclcpp::get_logger("McpCanTransport"), "Failed to start spi");
+        return CAN_SPI_FAILINIT;
+    }
+    return CAN_OK;
+}
+
+bool McpCanTransport::setupInterruptEvent()
+{
+    return mcp_can->setupInterruptEvent();
+}
+
+INT8U McpCanTransport::init(bool tx_queue_enabled, bool tx_interrupt_enabled)
+{
+    // "all" profile : no mask or filter used, receive all messages from CAN bus
+    // other profiles : frames from unknown ids are rejected by MCP2515, without INT nor SPI transfer
+    bool receive_all = (rx_filter_profile == CAN_RX_FILTER_ALL);
+    int result = mcp_can->begin(receive_all ? MCP_ANY : MCP_STDEXT, CAN_1000KBPS, MCP_16MHZ);
+    RCLCPP_INFO(rclcpp::get_logger("Niryo One Can Driver"),"Result begin can : %d", result);
+
+    if (result != CAN_OK) {
+        RCLCPP_ERROR(rclcpp::get_logger("Niryo One Can Driver"),"Failed to init MCP2515 (CAN bus)");
+        return result;
+    }
+
+    if (!receive_all) {
+        result = applyRxFilters();
+        if (result != CAN_OK) {
+            RCLCPP_ERROR(rclcpp::get_logger("Niryo One Can Driver"),"Failed to set MCP2515 masks and filters");
+            return result;
+        }
+    }
+    RCLCPP_INFO(rclcpp::get_logger("Niryo One Can Driver"),"CAN rx filter profile : %s", rx_filter_profile.c_str());
+
+    // set mode to normal
+    mcp_can->setMode(MCP_NORMAL);
+
+    // TX complete/error also pull INT low, so that the rx thread refills TX buffers
+    if (tx_queue_enabled && tx_interrupt_enabled) {
+        mcp_can->setTxInterrupt(true);
+    }
+
+    is_initialized = true;
+    sleep_for(0.05);
+    return result;
+}
+
+/*
+ * RXB0 (mask 0, filters 0-1) : Niryo ids
+ * RXB1 (mask 1, filters 2-5) : Niryo ids for arm profile, device ids for extended profile
+ * - up to MCP_RXB1_FILTER_COUNT device ids are matched exactly
+ * - with more ids, mask 1 only keeps the bits shared by all of them (some other ids may pass)
+ */
+INT8U McpCanTransport::applyRxFilters()
+{
+    INT32U rxb1_mask = MCP_NIRYO_ID_MASK;
+    INT32U rxb1_filters[MCP_RXB1_FILTER_COUNT];
+    for (int i = 0; i < MCP_RXB1_FILTER_COUNT; i++) {
+        rxb1_filters[i] = MCP_NIRYO_ID_FILTER;
+    }
+
+    if (rx_filter_profile == CAN_RX_FILTER_EXTENDED && !device_ids.empty()) {
+        if (device_ids.size() <= MCP_RXB1_FILTER_COUNT) {
+            rxb1_mask = 0x7FF;
+            for (int i = 0; i < MCP_RXB1_FILTER_COUNT; i++) {
+                rxb1_filters[i] = device_ids.at(i % device_ids.size());
+            }
+        }
+        else {
+            INT32U different_bits = 0;
+            for (size_t i = 0; i < device_ids.size(); i++) {
+                different_bits |= device_ids.at(i) ^ device_ids.at(0);
+            }
+            rxb1_mask = 0x7FF & ~different_bits;
+            for (int i = 0; i < MCP_RXB1_FILTER_COUNT; i++) {
+                rxb1_filters[i] = device_ids.at(0) & rxb1_mask;
+            }
+        }
+    }
+
+    INT8U result = MCP2515_OK;
+    result |= mcp_can->init_Mask(0, 0, mcpStandardId(MCP_NIRYO_ID_MASK));
+    result |= mcp_can->init_Filt(0, 0, mcpStandardId(MCP_NIRYO_ID_FILTER));
+    result |= mcp_can->init_Filt(1, 0, mcpStandardId(MCP_NIRYO_ID_FILTER));
+    result |= mcp_can->init_Mask(1, 0, mcpStandardId(rxb1_mask));
+    for (int i = 0; i < MCP_RXB1_FILTER_COUNT; i++) {
+        result |= mcp_can->init_Filt(2 + i, 0, mcpStandardId(rxb1_filters[i]));
+    }
+    return (result == MCP2515_OK) ? CAN_OK : CAN_FAILINIT;
+}
+
+bool McpCanTransport::canReadData()
+{
+    return mcp_can->canReadData();
+}
+
+/*
+ * MCP2515 has no timestamp register : frames get the time they were read at
+ */
+INT8U McpCanTransport::readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times)
+{
+    INT8U count = mcp_can->readMsgBatch(frames, max);
+
+    if (rx_times != NULL && count > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        for (int i = 0; i < count; i++) {
+            rx_times[i] = now.tv_sec + now.tv_nsec / 1e9;
+        }
+    }
+    return count;
+}
+
+INT8U McpCanTransport::waitForInterrupt(int timeout_ms)
+{
+    return mcp_can->waitForInterrupt(timeout_ms);
+}
+
+void McpCanTransport::notifyInterrupt()
+{
+    mcp_can->notifyInterrupt();
+}
+
+INT8U McpCanTransport::sendMsg(INT32U id, INT8U len, INT8U *buf)
+{
+    return mcp_can->sendMsgBuf(id, 0, len, buf);
+}
+
+/*
+ * A full queue is flushed first : the frame is only dropped (CAN_FAILTX)
+ * if no TX buffer got free for the oldest queued frames
+ */
+INT8U McpCanTransport::queueMsg(INT32U id, INT8U len, INT8U *buf)
+{
+    if (mcp_can->getTxQueueCount() >= MCP_TX_QUEUE_SIZE) {
+        mcp_can->flushTxQueue();
+    }
+    return mcp_can->queueMsgBuf(id, len, buf);
+}
+
+INT8U McpCanTransport::flushTxQueue()
+{
+    return mcp_can->flushTxQueue();
+}
+
+INT8U McpCanTransport::serviceTxQueue()
+{
+    return mcp_can->serviceTxQueue();
+}
+
+INT32U McpCanTransport::getTxErrorCount()
+{
+    return mcp_can->getTxErrorCount();
+}
+
+void McpCanTransport::getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count)
+{
+    if (!is_initialized) {
+        *rx_error_count = 0;
+        *tx_error_count = 0;
+        return;
+    }
+    *rx_error_count = mcp_can->errorCountRX();
+    *tx_error_count = mcp_can->errorCountTX();
+}
+
+/*
+ * Only used by extended profile, filters are updated right away if MCP2515 is already running
+ */
+void McpCanTransport::addRxFilter(INT32U id)
+{
+    if (rx_filter_profile == CAN_RX_FILTER_ALL) {
+        return;
+    }
+    if (rx_filter_profile != CAN_RX_FILTER_EXTENDED || (id & 0x80000000)) {
+        RCLCPP_WARN(rclcpp::get_logger("McpCanTransport"), "CAN id 0x%x is rejected by %s rx filter profile",
+                (unsigned int) id, rx_filter_profile.c_str());
+        return;
+    }
+
+    for (size_t i = 0; i < device_ids.size(); i++) {
+        if (device_ids.at(i) == id) {
+            return;
+        }
+    }
+    device_ids.push_back(id);
+
+    if (is_initialized && applyRxFilters() != CAN_OK) {
+        RCLCPP_ERROR(rclcpp::get_logger("McpCanTransport"), "Failed to set MCP2515 filters for CAN id 0x%x", (unsigned int) id);
+    }
+}
@@ -17,58 +17,176 @@
 */
 
 #include "niryo_one_driver/niryo_one_can_driver.h"
+#include "niryo_one_driver/tracing.h"
 #include "rclcpp/rclcpp.hpp"
+#include <string.h>
 
-NiryoCanDriver::NiryoCanDriver(int spi_channel, int spi_baudrate, INT8U gpio_can_interrupt) {
-    mcp_can.reset(new MCP_CAN(spi_channel, spi_baudrate, gpio_can_interrupt)); 
+NiryoCanDriver::NiryoCanDriver(CanTransport *transport) {
+    this->transport.reset(transport);
+    tx_queue_enabled = false;
+    tx_interrupt_enabled = false;
+    tx_batch_open = false;
+    statistics = NULL;
 }
 
-bool NiryoCanDriver::setupInterruptGpio()
+INT8U NiryoCanDriver::setup()
 {
-    if (!mcp_can->setupInterruptGpio()) {
-        printf("Failed to start gpio");
-        return CAN_GPIO_FAILINIT;
+    return transport->setup();
+}
+
+INT8U NiryoCanDriver::init()
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    return transport->init(tx_queue_enabled, tx_interrupt_enabled);
+}
+
+bool NiryoCanDriver::canReadData()
+{
+    return transport->canReadData();
+}
+
+INT8U NiryoCanDriver::readMsgBuf(INT32U *id, INT8U *len, INT8U *buf)
+{
+    CAN_FRAME frame;
+    if (readMsgBatch(&frame, 1) == 0) {
+        return CAN_NOMSG;
     }
+
+    *id = frame.id;
+    *len = frame.len;
+    memcpy(buf, frame.data, frame.len);
     return CAN_OK;
 }
 
-bool NiryoCanDriver::setupSpi()
+/*
+ * Reads every pending frame (up to max)
+ * - returns the number of frames read
+ */
+INT8U NiryoCanDriver::readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times)
 {
-    if (!mcp_can->setupSpi()) {
-        printf("Failed to start spi");
-        return CAN_SPI_FAILINIT;
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    if (tx_queue_enabled) {
+        transport->serviceTxQueue();
     }
-    return CAN_OK;
+    INT8U count = transport->readMsgBatch(frames, max, rx_times);
+
+    for (int i = 0; i < count; i++) {
+        NIRYO_TRACEPOINT(can_frame_rx, frames[i].id, frames[i].len, frames[i].data,
+                (rx_times != NULL) ? rx_times[i] : 0.0);
+    }
+    return count;
 }
 
-INT8U NiryoCanDriver::init()
+void NiryoCanDriver::addRxFilter(INT32U id)
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    transport->addRxFilter(id);
+}
+
+bool NiryoCanDriver::setupInterruptEvent()
+{
+    return transport->setupInterruptEvent();
+}
+
+/*
+ * Blocks until a frame is pending (MCP2515 INT line low, or readable socket) or timeout
+ * - no bus lock here, the wait only relies on the GPIO / socket
+ */
+INT8U NiryoCanDriver::waitForInterrupt(int timeout_ms)
+{
+    return transport->waitForInterrupt(timeout_ms);
+}
+
+void NiryoCanDriver::notifyInterrupt()
+{
+    transport->notifyInterrupt();
+}
+
+void NiryoCanDriver::setTxQueue(bool enabled, bool use_interrupt)
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    tx_queue_enabled = enabled;
+    tx_interrupt_enabled = use_interrupt;
+}
+
+/*
+ * Acknowledges TX interrupt flags and loads queued frames in free TX buffers
+ * - returns the number of frames loaded
+ */
+INT8U NiryoCanDriver::serviceTxQueue()
 {
-    // no mask or filter used, receive all messages from CAN bus
-    // messages with ids != motor_id will be sent to another ROS interface
-    // so we can use many CAN devices with this only driver
-    int result = mcp_can->begin(MCP_ANY, CAN_1000KBPS, MCP_16MHZ);
-    RCLCPP_INFO(rclcpp::get_logger("Niryo One Can Driver"),"Result begin can : %d", result);
-    
-    if (result != CAN_OK) { 
-        RCLCPP_ERROR(rclcpp::get_logger("Niryo One Can Driver"),"Failed to init MCP2515 (CAN bus)");
-        return result; 
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    if (!tx_queue_enabled) {
+        return 0;
     }
-    
-    // set mode to normal
-    mcp_can->setMode(MCP_NORMAL);
-    
-    sleep_for(0.05);
-    return result;
+    return transport->serviceTxQueue();
 }
 
-bool NiryoCanDriver::canReadData()
+INT32U NiryoCanDriver::getTxErrorCount()
 {
-    return mcp_can->canReadData();
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    return transport->getTxErrorCount();
 }
 
-INT8U NiryoCanDriver::readMsgBuf(INT32U *id, INT8U *len, INT8U *buf)
+void NiryoCanDriver::getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count)
 {
-    return mcp_can->readMsgBuf(id, len, buf);
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    transport->getErrorCounters(rx_error_count, tx_error_count);
+}
+
+void NiryoCanDriver::setStatistics(CanBusStatistics *statistics)
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    this->statistics = statistics;
+}
+
+void NiryoCanDriver::beginTxBatch()
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    tx_batch_open = tx_queue_enabled;
+}
+
+/*
+ * Returns the number of frames sent (or loaded in TX buffers)
+ */
+INT8U NiryoCanDriver::endTxBatch()
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    if (!tx_batch_open) {
+        return 0;
+    }
+    tx_batch_open = false;
+    return transport->flushTxQueue();
+}
+
+/*
+ * With tx queue : returns CAN_OK as soon as the frame is queued (CAN_FAILTX if queue is full),
+ * queue is flushed right away unless a tx batch is open
+ * Without : waits until the frame is sent
+ */
+INT8U NiryoCanDriver::sendCanFrame(int id, INT8U len, uint8_t *data)
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    INT8U result;
+    if (tx_queue_enabled) {
+        result = transport->queueMsg(id, len, data);
+        if (!tx_batch_open) {
+            transport->flushTxQueue();
+        }
+    }
+    else {
+        result = transport->sendMsg(id, len, data);
+    }
+    NIRYO_TRACEPOINT(can_frame_tx, id, len, data, result);
+
+    // serialized by bus_mutex : one writer at a time
+    if (statistics != NULL) {
+        statistics->recordFrame(statistics->frames_out, statistics->other_frames_out, id, len, data);
+        if (result != CAN_OK) {
+            statistics->send_failures.increment();
+        }
+    }
+    return result;
 }
 
 INT8U NiryoCanDriver::sendPositionCommand(int id, int cmd)
@@ -76,7 +194,27 @@ INT8U NiryoCanDriver::sendPositionCommand(int id, int cmd)
     uint8_t data[4] = { CAN_CMD_POSITION , (uint8_t) ((cmd >> 16) & 0xFF),
         (uint8_t) ((cmd >> 8) & 0xFF), (uint8_t) (cmd & 0XFF) };
 
-    return mcp_can->sendMsgBuf(id, 0, 4, data);
+    return sendCanFrame(id, 4, data);
+}
+
+/*
+ * One frame for up to CAN_GROUP_POSITION_MAX_MOTORS motors : control byte, first motor id,
+ * then a 24-bit position for first_motor_id, first_motor_id + 1, ...
+ */
+INT8U NiryoCanDriver::sendGroupPositionCommand(int id, int first_motor_id, int motor_count, int *cmds)
+{
+    if (motor_count < 1 || motor_count > CAN_GROUP_POSITION_MAX_MOTORS) {
+        return CAN_FAILTX;
+    }
+
+    uint8_t data[2 + 3 * CAN_GROUP_POSITION_MAX_MOTORS] = { CAN_CMD_GROUP_POSITION, (uint8_t) first_motor_id };
+    for (int i = 0; i < motor_count; i++) {
+        data[2 + 3*i]     = (uint8_t) ((cmds[i] >> 16) & 0xFF);
+        data[2 + 3*i + 1] = (uint8_t) ((cmds[i] >> 8) & 0xFF);
+        data[2 + 3*i + 2] = (uint8_t) (cmds[i] & 0xFF);
+    }
+
+    return sendCanFrame(id, 2 + 3 * motor_count, data);
 }
 
 INT8U NiryoCanDriver::sendRelativeMoveCommand(int id, int steps, int delay)
@@ -84,7 +222,7 @@ INT8U NiryoCanDriver::sendRelativeMoveCommand(int id, int steps, int delay)
     uint8_t data[7] = { CAN_CMD_MOVE_REL, 
         (uint8_t) ((steps >> 16) & 0xFF), (uint8_t) ((steps >> 8) & 0xFF), (uint8_t) (steps & 0XFF),
         (uint8_t) ((delay >> 16) & 0xFF), (uint8_t) ((delay >> 8) & 0xFF), (uint8_t) (delay & 0XFF)};
-    return mcp_can->sendMsgBuf(id, 0, 7, data);
+    return sendCanFrame(id, 7, data);
 }
 
 INT8U NiryoCanDriver::sendTorqueOnCommand(int id, int torque_on)
@@ -92,7 +230,7 @@ INT8U NiryoCanDriver::sendTorqueOnCommand(int id, int torque_on)
     uint8_t data[2] = {0};
     data[0] = CAN_CMD_MODE;
     data[1] = (torque_on) ? STEPPER_CONTROL_MODE_STANDARD : STEPPER_CONTROL_MODE_RELAX; 
-    return mcp_can->sendMsgBuf(id, 0, 2, data);
+    return sendCanFrame(id, 2, data);
 }
 INT8U NiryoCanDriver::sendConveyoOnCommand(int id, bool conveyor_on, int conveyor_speed, int8_t direction)
 {
@@ -108,7 +246,7 @@ INT8U NiryoCanDriver::sendConveyoOnCommand(int id, bool conveyor_on, int conveyo
     data[2] = conveyor_speed;
     data[3] = direction;
 
-    return mcp_can->sendMsgBuf(id, 0, 4, data);
+    return sendCanFrame(id, 4, data);
 }
 INT8U NiryoCanDriver::sendUpdateConveyorId(uint8_t old_id, uint8_t new_id)
 {
@@ -117,7 +255,7 @@ INT8U NiryoCanDriver::sendUpdateConveyorId(uint8_t old_id, uint8_t new_id)
     data[0] = CAN_CMD_MODE;
     data[1] = CAN_UPDATE_CONVEYOR_ID;
     data[2] = new_id;
-    return mcp_can->sendMsgBuf(old_id, 0, 3, data);
+    return sendCanFrame(old_id, 3, data);
 }
 
 INT8U NiryoCanDriver::sendPositionOffsetCommand(int id, int cmd, int absolute_steps_at_offset_position) 
@@ -125,7 +263,7 @@ INT8U NiryoCanDriver::sendPositionOffsetCommand(int id, int cmd, int absolute_st
     uint8_t data[6] = { CAN_CMD_OFFSET , (uint8_t) ((cmd >> 16) & 0xFF),
         (uint8_t) ((cmd >> 8) & 0xFF), (uint8_t) (cmd & 0XFF),
         (uint8_t) ((absolute_steps_at_offset_position >> 8) & 0xFF), (uint8_t) (absolute_steps_at_offset_position & 0xFF)};
-    return mcp_can->sendMsgBuf(id, 0, 6, data);
+    return sendCanFrame(id, 6, data);
 }
 
 INT8U NiryoCanDriver::sendCalibrationCommand(int id, int offset, int delay, int direction, int timeout)
@@ -136,23 +274,23 @@ INT8U NiryoCanDriver::sendCalibrationCommand(int id, int offset, int delay, int
         (uint8_t) ((offset >> 8) & 0xFF), (uint8_t) (offset & 0XFF),
         (uint8_t) ((delay >> 8) & 0xFF), (uint8_t) (delay & 0xFF), 
         (uint8_t)direction, (uint8_t)timeout };
-    return mcp_can->sendMsgBuf(id, 0, 8, data);
+    return sendCanFrame(id, 8, data);
 }
 
 INT8U NiryoCanDriver::sendSynchronizePositionCommand(int id, bool begin_traj)
 {
     uint8_t data[2] = { CAN_CMD_SYNCHRONIZE, (uint8_t) begin_traj };
-    return mcp_can->sendMsgBuf(id, 0, 2, data);
+    return sendCanFrame(id, 2, data);
 }
    
 INT8U NiryoCanDriver::sendMicroStepsCommand(int id, int micro_steps)
 {
     uint8_t data[2] = { CAN_CMD_MICRO_STEPS, (uint8_t) micro_steps };
-    return mcp_can->sendMsgBuf(id, 0, 2, data);
+    return sendCanFrame(id, 2, data);
 }
 
 INT8U NiryoCanDriver::sendMaxEffortCommand(int id, int effort)
 {
     uint8_t data[2] = { CAN_CMD_MAX_EFFORT, (uint8_t) effort };
-    return mcp_can->sendMsgBuf(id, 0, 2, data);
+    return sendCanFrame(id, 2, data);
 }
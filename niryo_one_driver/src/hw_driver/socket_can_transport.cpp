@@ -0,0 +1,366 @@
+/*
+    socket_can_transport.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/socket_can_transport.h"
+#include "rclcpp/rclcpp.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+
+SocketCanTransport::SocketCanTransport(std::string interface_name)
+{
+    this->interface_name = interface_name;
+    socket_fd = -1;
+    wakeup_event_fd = -1;
+    timestamping_enabled = false;
+    tx_queue_count = 0;
+    tx_error_count = 0;
+    controller_rx_error_count = 0;
+    controller_tx_error_count = 0;
+
+    // standard data frames with ids 0x00 - 0x1F (motors and conveyors)
+    struct can_filter niryo_filter;
+    niryo_filter.can_id = 0x00;
+    niryo_filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SOCKET_NIRYO_ID_MASK;
+    rx_filters.push_back(niryo_filter);
+
+    memset(rx_msgs, 0, sizeof(rx_msgs));
+    memset(tx_msgs, 0, sizeof(tx_msgs));
+    for (int i = 0; i < CAN_SOCKET_BATCH_SIZE; i++) {
+        rx_iov[i].iov_base = &rx_frames[i];
+        rx_iov[i].iov_len = sizeof(struct can_frame);
+        rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+        rx_msgs[i].msg_hdr.msg_iovlen = 1;
+
+        tx_iov[i].iov_base = &tx_frames[i];
+        tx_iov[i].iov_len = sizeof(struct can_frame);
+        tx_msgs[i].msg_hdr.msg_iov = &tx_iov[i];
+        tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+SocketCanTransport::~SocketCanTransport()
+{
+    if (socket_fd >= 0) {
+        close(socket_fd);
+    }
+    if (wakeup_event_fd >= 0) {
+        close(wakeup_event_fd);
+    }
+}
+
+INT8U SocketCanTransport::setup()
+{
+    socket_fd = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (socket_fd < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("SocketCanTransport"), "Failed to open CAN socket : %s", strerror(errno));
+        return CAN_FAILINIT;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socket_fd, SIOCGIFINDEX, &ifr) < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("SocketCanTransport"), "No CAN interface %s : %s",
+                interface_name.c_str(), strerror(errno));
+        return CAN_FAILINIT;
+    }
+
+    // filters are set before bind, so that no frame from other ids is queued
+    if (!applyRxFilters()) {
+        return CAN_FAILINIT;
+    }
+
+    // error frames are counted as tx errors (no ack, tx timeout, bus off),
+    // controller error frames give REC / TEC
+    can_err_mask_t err_mask = CAN_ERR_TX_TIMEOUT | CAN_ERR_ACK | CAN_ERR_BUSOFF | CAN_ERR_CRTL;
+    if (setsockopt(socket_fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) < 0) {
+        RCLCPP_WARN(rclcpp::get_logger("SocketCanTransport"), "Failed to set CAN error filter : %s", strerror(errno));
+    }
+
+    int timestamping_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    timestamping_enabled = setsockopt(socket_fd, SOL_SOCKET, SO_TIMESTAMPING,
+            &timestamping_flags, sizeof(timestamping_flags)) == 0;
+    if (!timestamping_enabled) {
+        RCLCPP_WARN(rclcpp::get_logger("SocketCanTransport"), "No kernel rx timestamps : %s", strerror(errno));
+    }
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(socket_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("SocketCanTransport"), "Failed to bind CAN socket to %s : %s",
+                interface_name.c_str(), strerror(errno));
+        return CAN_FAILINIT;
+    }
+
+    return CAN_OK;
+}
+
+/*
+ * The socket is already pollable, the eventfd is only used by notifyInterrupt()
+ */
+bool SocketCanTransport::setupInterruptEvent()
+{
+    if (wakeup_event_fd < 0) {
+        wakeup_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    return wakeup_event_fd >= 0;
+}
+
+/*
+ * Bitrate and tx queue length belong to the interface, only check it is up
+ */
+INT8U SocketCanTransport::init(bool tx_queue_enabled, bool tx_interrupt_enabled)
+{
+    (void) tx_queue_enabled;
+    (void) tx_interrupt_enabled;
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socket_fd, SIOCGIFFLAGS, &ifr) < 0 || !(ifr.ifr_flags & IFF_UP)) {
+        RCLCPP_ERROR(rclcpp::get_logger("SocketCanTransport"), "CAN interface %s is down", interface_name.c_str());
+        return CAN_FAILINIT;
+    }
+
+    RCLCPP_INFO(rclcpp::get_logger("SocketCanTransport"), "SocketCAN started on %s", interface_name.c_str());
+    return CAN_OK;
+}
+
+bool SocketCanTransport::canReadData()
+{
+    struct pollfd fds;
+    fds.fd = socket_fd;
+    fds.events = POLLIN;
+    fds.revents = 0;
+    return poll(&fds, 1, 0) > 0 && (fds.revents & POLLIN);
+}
+
+/*
+ * Reads up to max pending frames with one recvmmsg, without waiting
+ */
+INT8U SocketCanTransport::readMsgBatch(CAN_FRAME *frames, INT8U max, double *rx_times)
+{
+    int batch_size = (max < CAN_SOCKET_BATCH_SIZE) ? max : CAN_SOCKET_BATCH_SIZE;
+    for (int i = 0; i < batch_size; i++) {
+        rx_msgs[i].msg_hdr.msg_control = timestamping_enabled ? rx_control[i] : NULL;
+        rx_msgs[i].msg_hdr.msg_controllen = timestamping_enabled ? sizeof(rx_control[i]) : 0;
+        rx_msgs[i].msg_hdr.msg_flags = 0;
+    }
+
+    int received = recvmmsg(socket_fd, rx_msgs, batch_size, MSG_DONTWAIT, NULL);
+    if (received <= 0) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    INT8U count = 0;
+    for (int i = 0; i < received; i++) {
+        struct can_frame *frame = &rx_frames[i];
+        if (frame->can_id & CAN_ERR_FLAG) {
+            if (frame->can_id & (CAN_ERR_TX_TIMEOUT | CAN_ERR_ACK | CAN_ERR_BUSOFF)) {
+                tx_error_count++;
+            }
+            if (frame->can_id & CAN_ERR_CRTL) {
+                controller_tx_error_count = frame->data[6];
+                controller_rx_error_count = frame->data[7];
+            }
+            continue;
+        }
+
+        // CAN_FRAME uses the same ext (0x80000000) and rtr (0x40000000) flags
+        frames[count].id = frame->can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK);
+        frames[count].len = (frame->can_dlc < MAX_CHAR_IN_MESSAGE) ? frame->can_dlc : MAX_CHAR_IN_MESSAGE;
+        memcpy(frames[count].data, frame->data, frames[count].len);
+
+        if (rx_times != NULL) {
+            struct timespec *stamp = &now;
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&rx_msgs[i].msg_hdr); cmsg != NULL;
+                    cmsg = CMSG_NXTHDR(&rx_msgs[i].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING) {
+                    struct scm_timestamping *timestamps = (struct scm_timestamping *) CMSG_DATA(cmsg);
+                    stamp = &timestamps->ts[0]; // software timestamp
+                }
+            }
+            rx_times[count] = stamp->tv_sec + stamp->tv_nsec / 1e9;
+        }
+        count++;
+    }
+    return count;
+}
+
+INT8U SocketCanTransport::waitForInterrupt(int timeout_ms)
+{
+    struct pollfd fds[2];
+    int nfds = 0;
+    fds[nfds].fd = socket_fd;
+    fds[nfds].events = POLLIN;
+    fds[nfds].revents = 0;
+    nfds++;
+    if (wakeup_event_fd >= 0) {
+        fds[nfds].fd = wakeup_event_fd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        nfds++;
+    }
+
+    int result = poll(fds, nfds, timeout_ms);
+    if (result <= 0) {
+        return CAN_NOMSG; // timeout or EINTR
+    }
+
+    if (nfds > 1 && fds[1].revents) {
+        uint64_t value;
+        while (read(wakeup_event_fd, &value, sizeof(value)) > 0) {}
+    }
+    return CAN_MSGAVAIL;
+}
+
+void SocketCanTransport::notifyInterrupt()
+{
+    if (wakeup_event_fd >= 0) {
+        uint64_t value = 1;
+        if (write(wakeup_event_fd, &value, sizeof(value)) < 0) {
+            RCLCPP_WARN(rclcpp::get_logger("SocketCanTransport"), "Failed to notify interrupt : %s", strerror(errno));
+        }
+    }
+}
+
+void SocketCanTransport::encodeFrame(INT32U id, INT8U len, INT8U *buf, struct can_frame *frame)
+{
+    memset(frame, 0, sizeof(struct can_frame));
+    frame->can_id = id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK);
+    frame->can_dlc = (len < MAX_CHAR_IN_MESSAGE) ? len : MAX_CHAR_IN_MESSAGE;
+    memcpy(frame->data, buf, frame->can_dlc);
+}
+
+/*
+ * Blocks until the frame is in the interface queue (not until it is acknowledged on the bus)
+ */
+INT8U SocketCanTransport::sendMsg(INT32U id, INT8U len, INT8U *buf)
+{
+    struct can_frame frame;
+    encodeFrame(id, len, buf, &frame);
+
+    if (send(socket_fd, &frame, sizeof(frame), 0) != sizeof(frame)) {
+        tx_error_count++;
+        return CAN_FAILTX;
+    }
+    return CAN_OK;
+}
+
+INT8U SocketCanTransport::queueMsg(INT32U id, INT8U len, INT8U *buf)
+{
+    if (tx_queue_count >= CAN_SOCKET_BATCH_SIZE) {
+        flushTxQueue();
+    }
+    if (tx_queue_count >= CAN_SOCKET_BATCH_SIZE) {
+        return CAN_FAILTX;
+    }
+
+    encodeFrame(id, len, buf, &tx_frames[tx_queue_count]);
+    tx_queue_count++;
+    return CAN_OK;
+}
+
+/*
+ * Sends every queued frame with one sendmmsg, without waiting
+ * - frames that don't fit in the interface queue (ENOBUFS) stay queued for next flush
+ * - returns the number of frames sent
+ */
+INT8U SocketCanTransport::flushTxQueue()
+{
+    if (tx_queue_count == 0) {
+        return 0;
+    }
+
+    int sent = sendmmsg(socket_fd, tx_msgs, tx_queue_count, MSG_DONTWAIT);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            return 0;
+        }
+        // interface down : drop queued frames rather than sending old commands later
+        tx_error_count += tx_queue_count;
+        tx_queue_count = 0;
+        return 0;
+    }
+
+    tx_queue_count -= sent;
+    if (tx_queue_count > 0) {
+        memmove(&tx_frames[0], &tx_frames[sent], tx_queue_count * sizeof(struct can_frame));
+    }
+    return sent;
+}
+
+INT8U SocketCanTransport::serviceTxQueue()
+{
+    return flushTxQueue();
+}
+
+INT32U SocketCanTransport::getTxErrorCount()
+{
+    return tx_error_count;
+}
+
+void SocketCanTransport::getErrorCounters(INT8U *rx_error_count, INT8U *tx_error_count)
+{
+    *rx_error_count = controller_rx_error_count;
+    *tx_error_count = controller_tx_error_count;
+}
+
+void SocketCanTransport::addRxFilter(INT32U id)
+{
+    struct can_filter device_filter;
+    device_filter.can_id = id;
+    device_filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | ((id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+
+    for (size_t i = 0; i < rx_filters.size(); i++) {
+        if (rx_filters.at(i).can_id == device_filter.can_id && rx_filters.at(i).can_mask == device_filter.can_mask) {
+            return;
+        }
+    }
+    rx_filters.push_back(device_filter);
+
+    if (socket_fd >= 0) {
+        applyRxFilters();
+    }
+}
+
+bool SocketCanTransport::applyRxFilters()
+{
+    if (setsockopt(socket_fd, SOL_CAN_RAW, CAN_RAW_FILTER, rx_filters.data(),
+                rx_filters.size() * sizeof(struct can_filter)) < 0) {
+        RCLCPP_ERROR(rclcpp::get_logger("SocketCanTransport"), "Failed to set CAN filters : %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
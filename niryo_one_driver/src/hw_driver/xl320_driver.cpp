@@ -39,6 +39,11 @@ int XL320Driver::checkModelNumber(uint8_t id)
     return ping_result;
 }
 
+bool XL320Driver::supportsFastRead(uint16_t model_number, uint32_t firmware_version)
+{
+    return false; // Fast Sync Read / Fast Bulk Read not available on XL-320
+}
+
 /*
  *  -----------------   WRITE   --------------------
  */
@@ -179,6 +184,11 @@ int XL320Driver::readHardwareStatus(uint8_t id, uint32_t *hardware_status)
     return read1Byte(XL320_ADDR_HW_ERROR_STATUS, id, hardware_status);
 }
         
+int XL320Driver::readFirmwareVersion(uint8_t id, uint32_t *firmware_version)
+{
+    return read1Byte(XL320_ADDR_FIRMWARE_VERSION, id, firmware_version);
+}
+
 int XL320Driver::readReturnDelayTime(uint8_t id, uint32_t *return_delay_time)
 {
     return read1Byte(XL320_ADDR_RETURN_DELAY_TIME, id, return_delay_time);
@@ -237,3 +247,24 @@ int XL320Driver::syncReadHwErrorStatus(std::vector<uint8_t> &id_list, std::vecto
 {
     return syncRead(XL320_ADDR_HW_ERROR_STATUS, DXL_LEN_ONE_BYTE, id_list, hw_error_list);
 }
+
+const DxlStateBlock& XL320Driver::getStateBlock()
+{
+    static const DxlStateBlock block = {
+        XL320_STATE_BLOCK_ADDR, XL320_STATE_BLOCK_LEN,
+        { XL320_ADDR_PRESENT_POSITION, DXL_LEN_TWO_BYTES },
+        { XL320_ADDR_PRESENT_SPEED,    DXL_LEN_TWO_BYTES },
+        { XL320_ADDR_PRESENT_LOAD,     DXL_LEN_TWO_BYTES }
+    };
+    return block;
+}
+
+const DxlWriteRegisters& XL320Driver::getWriteRegisters()
+{
+    static const DxlWriteRegisters registers = {{
+        { XL320_ADDR_TORQUE_ENABLE,  DXL_LEN_ONE_BYTE },
+        { XL320_ADDR_GOAL_POSITION,  DXL_LEN_TWO_BYTES },
+        { XL320_ADDR_GOAL_SPEED,     DXL_LEN_TWO_BYTES }
+    }};
+    return registers;
+}
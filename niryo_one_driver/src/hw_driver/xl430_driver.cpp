@@ -39,6 +39,11 @@ int XL430Driver::checkModelNumber(uint8_t id)
     return ping_result;
 }
 
+bool XL430Driver::supportsFastRead(uint16_t model_number, uint32_t firmware_version)
+{
+    return model_number == XL430_MODEL_NUMBER && firmware_version >= XL430_FAST_READ_MIN_FIRMWARE_VERSION;
+}
+
 /*
  *  -----------------   WRITE   --------------------
  */
@@ -185,6 +190,11 @@ int XL430Driver::readHardwareStatus(uint8_t id, uint32_t *hardware_status)
     return read1Byte(XL430_ADDR_HW_ERROR_STATUS, id, hardware_status);
 }
         
+int XL430Driver::readFirmwareVersion(uint8_t id, uint32_t *firmware_version)
+{
+    return read1Byte(XL430_ADDR_FIRMWARE_VERSION, id, firmware_version);
+}
+
 int XL430Driver::readReturnDelayTime(uint8_t id, uint32_t *return_delay_time)
 {
     return read1Byte(XL430_ADDR_RETURN_DELAY_TIME, id, return_delay_time);
@@ -244,3 +254,24 @@ int XL430Driver::syncReadHwErrorStatus(std::vector<uint8_t> &id_list, std::vecto
 {
     return syncRead(XL430_ADDR_HW_ERROR_STATUS, DXL_LEN_ONE_BYTE, id_list, hw_error_list);
 }
+
+const DxlStateBlock& XL430Driver::getStateBlock()
+{
+    static const DxlStateBlock block = {
+        XL430_STATE_BLOCK_ADDR, XL430_STATE_BLOCK_LEN,
+        { XL430_ADDR_PRESENT_POSITION, DXL_LEN_FOUR_BYTES },
+        { XL430_ADDR_PRESENT_VELOCITY, DXL_LEN_FOUR_BYTES },
+        { XL430_ADDR_PRESENT_LOAD,     DXL_LEN_TWO_BYTES }
+    };
+    return block;
+}
+
+const DxlWriteRegisters& XL430Driver::getWriteRegisters()
+{
+    static const DxlWriteRegisters registers = {{
+        { XL430_ADDR_TORQUE_ENABLE,  DXL_LEN_ONE_BYTE },
+        { XL430_ADDR_GOAL_POSITION,  DXL_LEN_FOUR_BYTES },
+        { XL430_ADDR_GOAL_VELOCITY,  DXL_LEN_FOUR_BYTES }
+    }};
+    return registers;
+}
@@ -18,6 +18,7 @@
 */
 
 #include "niryo_one_driver/niryo_one_hardware_interface.h"
+#include "niryo_one_driver/tracing.h"
 
 #include "pluginlib/class_list_macros.hpp"
 
@@ -82,20 +83,26 @@ std::vector<hardware_interface::CommandInterface> NiryoOneHardwareInterface::exp
 }
 hardware_interface::return_type NiryoOneHardwareInterface::write()
 {
+    NIRYO_TRACEPOINT(hw_interface_write, cmd);
     comm->sendPositionToRobot(cmd);
     return hardware_interface::return_type::OK;
 }
 hardware_interface::return_type NiryoOneHardwareInterface::read()
 {
   double pos_to_read[6] = {0.0};
+  double vel_to_read[6] = {0.0};
+  double eff_to_read[6] = {0.0};
 
-  comm->getCurrentPosition(pos_to_read);
+  comm->getCurrentState(pos_to_read, vel_to_read, eff_to_read);
 
   for (uint i = 0; i < 6; i++)
   {
       pos[i] = pos_to_read[i];
+      vel[i] = vel_to_read[i];
+      eff[i] = eff_to_read[i];
   }
 
+  NIRYO_TRACEPOINT(hw_interface_read, pos);
   return hardware_interface::return_type::OK;
 }
 
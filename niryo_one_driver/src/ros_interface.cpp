@@ -341,6 +341,41 @@ void RosInterface::publishHardwareStatus()
     }
 }
 
+/*
+ * Loop timings and bus counters of each hardware control loop, one diagnostic status per bus
+ */
+void RosInterface::publishHardwareStatistics()
+{
+    double publish_hw_statistics_frequency = 1.0;
+    node->get_parameter("publish_hw_statistics_frequency", publish_hw_statistics_frequency);
+    rclcpp::Rate publish_hardware_statistics_rate(publish_hw_statistics_frequency);
+
+    std::vector<HwStatisticsReport> reports;
+
+    while (rclcpp::ok()) {
+        comm->getHardwareStatistics(reports);
+
+        diagnostic_msgs::msg::DiagnosticArray msg;
+        msg.header.stamp = node->now();
+        for (int i = 0; i < reports.size(); i++) {
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+            status.name = "niryo_one_driver: " + reports.at(i).name;
+            status.hardware_id = "niryo_one";
+            status.message = "Hardware control loop statistics";
+            for (int j = 0; j < reports.at(i).values.size(); j++) {
+                diagnostic_msgs::msg::KeyValue key_value;
+                key_value.key = reports.at(i).values.at(j).first;
+                key_value.value = reports.at(i).values.at(j).second;
+                status.values.push_back(key_value);
+            }
+            msg.status.push_back(status);
+        }
+        hardware_statistics_publisher->publish(msg);
+        publish_hardware_statistics_rate.sleep();
+    }
+}
+
 void RosInterface::publishSoftwareVersion()
 {
     
@@ -431,6 +466,9 @@ void RosInterface::startPublishers()
     
     hardware_status_publisher = node->create_publisher<niryo_one_msgs::msg::HardwareStatus>("niryo_one/hardware_status", 10);
     publish_hardware_status_thread.reset(new std::thread(std::bind(&RosInterface::publishHardwareStatus, this))); 
+
+    hardware_statistics_publisher = node->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+    publish_hardware_statistics_thread.reset(new std::thread(std::bind(&RosInterface::publishHardwareStatistics, this)));
     
     software_version_publisher = node->create_publisher<niryo_one_msgs::msg::SoftwareVersion>("niryo_one/software_version", 10);
     publish_software_version_thread.reset(new std::thread(std::bind(&RosInterface::publishSoftwareVersion, this)));
@@ -0,0 +1,104 @@
+/*
+    bus_job_queue.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/bus_job_queue.h"
+
+#include <chrono>
+
+BusJobQueue::BusJobQueue()
+    : has_owner(false), wake_requested(false)
+{
+}
+
+std::future<int> BusJobQueue::submit(std::function<int()> job)
+{
+    std::packaged_task<int()> task(job);
+    std::future<int> result = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (has_owner && std::this_thread::get_id() != owner_id) {
+            jobs.push_back(std::move(task));
+            queue_cv.notify_one();
+            return result;
+        }
+    }
+
+    // no owner to hand the job to (or we are the owner) : run it now
+    std::lock_guard<std::recursive_mutex> bus_lock(bus_mutex);
+    task();
+    return result;
+}
+
+int BusJobQueue::execute(std::function<int()> job)
+{
+    return submit(job).get();
+}
+
+void BusJobQueue::attachOwner()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    owner_id = std::this_thread::get_id();
+    has_owner = true;
+}
+
+void BusJobQueue::detachOwner()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        has_owner = false;
+    }
+    // jobs submitted before has_owner was cleared still wait for their result
+    runPendingJobs();
+}
+
+std::unique_lock<std::recursive_mutex> BusJobQueue::lockBus()
+{
+    return std::unique_lock<std::recursive_mutex>(bus_mutex);
+}
+
+int BusJobQueue::runPendingJobs()
+{
+    std::deque<std::packaged_task<int()>> pending_jobs;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending_jobs.swap(jobs);
+    }
+
+    std::lock_guard<std::recursive_mutex> bus_lock(bus_mutex);
+    for (std::packaged_task<int()> &job : pending_jobs) {
+        job();
+    }
+    return (int) pending_jobs.size();
+}
+
+void BusJobQueue::waitForJobs(double timeout)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_cv.wait_for(lock, std::chrono::duration<double>(timeout),
+            [this] { return !jobs.empty() || wake_requested; });
+    wake_requested = false;
+}
+
+void BusJobQueue::wakeOwner()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    wake_requested = true;
+    queue_cv.notify_one();
+}
@@ -0,0 +1,179 @@
+/*
+    command_latency.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/command_latency.h"
+
+CommandLatencyProbe::CommandLatencyProbe()
+    : enabled(false), first_axis(0), last_axis(0), tolerance(0.005), sequence(0)
+{
+}
+
+void CommandLatencyProbe::init(rclcpp::Node::SharedPtr node, int first_axis, int axis_count)
+{
+    this->first_axis = first_axis;
+    this->last_axis = first_axis + axis_count;
+    node->get_parameter("measure_command_latency", enabled);
+    node->get_parameter("command_latency_tolerance", tolerance);
+
+    if (enabled) {
+        RCLCPP_INFO(rclcpp::get_logger("CommandLatencyProbe"), "Measuring command latency of joints %d to %d (tolerance %lf rad)",
+                first_axis + 1, last_axis, tolerance);
+    }
+}
+
+/*
+ * Called from ros2_control write(), before the command is published
+ */
+void CommandLatencyProbe::stampCommand(JointCommandSnapshot &cmd)
+{
+    if (!enabled) {
+        return;
+    }
+    sequence++;
+    if (sequence == 0) { // 0 means no command
+        sequence++;
+    }
+    cmd.sequence = sequence;
+    cmd.stamp_ns = statClockNs();
+}
+
+/*
+ * Called by the control loop with each new command : starts a probe on changed axes,
+ * unless the previous probe of the axis is still pending or armed
+ */
+void CommandLatencyProbe::onCommandApplied(const JointCommandSnapshot &cmd)
+{
+    if (!enabled || cmd.sequence == 0) {
+        return;
+    }
+
+    for (int i = first_axis; i < last_axis; i++) {
+        AxisProbe &axis = axes[i];
+        double previous_command = axis.last_command;
+        bool changed = axis.has_last_command && cmd.position[i] != previous_command;
+        axis.last_command = cmd.position[i];
+        axis.has_last_command = true;
+
+        if (!changed || axis.pending) {
+            continue;
+        }
+        if (axis.armed_sequence.load(std::memory_order_relaxed) != axis.completed_sequence.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        axis.target = cmd.position[i];
+        axis.direction = (cmd.position[i] > previous_command) ? 1.0 : -1.0;
+        axis.stamp_ns = cmd.stamp_ns;
+        axis.pending_sequence = cmd.sequence;
+        axis.pending = true;
+        axis.started.increment();
+    }
+}
+
+/*
+ * Called by the control loop after position commands have been written on the bus
+ */
+void CommandLatencyProbe::onCommandSent()
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint64_t now = statClockNs();
+    for (int i = first_axis; i < last_axis; i++) {
+        AxisProbe &axis = axes[i];
+        if (axis.pending) {
+            axis.pending = false;
+            axis.command_to_bus.record((uint32_t) ((now - axis.stamp_ns) / 1000));
+            axis.armed_sequence.store(axis.pending_sequence, std::memory_order_release);
+        }
+    }
+}
+
+/*
+ * Called with the joint state about to be published (positions filled) : completes armed
+ * probes and stamps the state with the last reached command of each axis
+ */
+void CommandLatencyProbe::onFeedback(JointStateSnapshot &state)
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint64_t now = statClockNs();
+    for (int i = first_axis; i < last_axis; i++) {
+        AxisProbe &axis = axes[i];
+        uint32_t armed_sequence = axis.armed_sequence.load(std::memory_order_acquire);
+
+        if (armed_sequence != axis.completed_sequence.load(std::memory_order_relaxed)) {
+            if (axis.direction * (state.position[i] - axis.target) >= -tolerance) {
+                axis.command_to_feedback.record((uint32_t) ((now - axis.stamp_ns) / 1000));
+                axis.reached_sequence = armed_sequence;
+                axis.reached_stamp_ns = axis.stamp_ns;
+                axis.completed_sequence.store(armed_sequence, std::memory_order_release);
+            }
+            else if (now - axis.stamp_ns > (uint64_t) (COMMAND_LATENCY_PROBE_TIMEOUT * 1e9)) {
+                axis.timed_out.increment();
+                axis.completed_sequence.store(armed_sequence, std::memory_order_release);
+            }
+        }
+
+        state.command_sequence[i] = axis.reached_sequence;
+        state.command_stamp_ns[i] = axis.reached_stamp_ns;
+    }
+}
+
+/*
+ * Called from ros2_control read() with the state it returns
+ */
+void CommandLatencyProbe::onRead(const JointStateSnapshot &state)
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint64_t now = statClockNs();
+    for (int i = first_axis; i < last_axis; i++) {
+        AxisProbe &axis = axes[i];
+        if (state.command_sequence[i] != 0 && state.command_sequence[i] != axis.read_sequence) {
+            axis.command_to_read.record((uint32_t) ((now - state.command_stamp_ns[i]) / 1000));
+        }
+        axis.read_sequence = state.command_sequence[i];
+    }
+}
+
+/*
+ * Percentiles of each stage over the window since last call, probe counters since start
+ */
+void CommandLatencyProbe::report(HwStatisticsReport &report)
+{
+    if (!enabled) {
+        return;
+    }
+
+    for (int i = first_axis; i < last_axis; i++) {
+        AxisProbe &axis = axes[i];
+        std::string joint = "joint_" + std::to_string(i + 1);
+        axis.command_to_bus_window.report(joint + " command to bus", axis.command_to_bus, report);
+        axis.command_to_feedback_window.report(joint + " command to feedback", axis.command_to_feedback, report);
+        axis.command_to_read_window.report(joint + " command to read", axis.command_to_read, report);
+        report.values.push_back(std::make_pair(joint + " latency probes",
+                    std::to_string(axis.started.get()) + ", timed out " + std::to_string(axis.timed_out.get())));
+    }
+}
@@ -0,0 +1,169 @@
+/*
+    hw_statistics.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/hw_statistics.h"
+
+#include <math.h>
+#include <stdio.h>
+#include "dynamixel_sdk/dynamixel_sdk.h"
+
+#define HISTOGRAM_SUB_BUCKET_COUNT (1 << HISTOGRAM_SUB_BUCKET_BITS)
+
+LatencyHistogram::LatencyHistogram()
+    : max_value(0)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketIndex(uint32_t value_us)
+{
+    if (value_us < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return value_us;
+    }
+    int exponent = 31 - __builtin_clz(value_us);
+    if (exponent >= HISTOGRAM_MAX_EXPONENT) {
+        return HISTOGRAM_BUCKET_COUNT - 1;
+    }
+    int sub_bucket = (value_us >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1);
+    return ((exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS) + sub_bucket;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return index;
+    }
+    int shift = (index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    uint32_t lower = (uint32_t) (HISTOGRAM_SUB_BUCKET_COUNT + (index & (HISTOGRAM_SUB_BUCKET_COUNT - 1))) << shift;
+    return lower + (1U << shift) - 1;
+}
+
+void LatencyHistogram::record(uint32_t value_us)
+{
+    std::atomic<uint32_t> &bucket = counts[bucketIndex(value_us)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (value_us > max_value.load(std::memory_order_relaxed)) {
+        max_value.store(value_us, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::snapshot(HistogramSnapshot &snapshot) const
+{
+    snapshot.count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+}
+
+void HistogramSnapshot::subtract(const HistogramSnapshot &previous)
+{
+    count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        counts[i] -= previous.counts[i];
+        count += counts[i];
+    }
+}
+
+uint32_t HistogramSnapshot::percentile(double quantile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t) ceil(quantile * count);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint32_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        total += counts[i];
+        if (total >= rank) {
+            return LatencyHistogram::bucketUpperBound(i);
+        }
+    }
+    return LatencyHistogram::bucketUpperBound(HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+void LoopStatistics::recordCycle(uint64_t start_ns, uint64_t end_ns, double loop_frequency)
+{
+    cycle.record((uint32_t) ((end_ns - start_ns) / 1000));
+    cycle_count.increment();
+    if ((end_ns - start_ns) * loop_frequency > 1e9) {
+        overrun_count.increment();
+    }
+}
+
+void CanBusStatistics::recordFrame(StatCounter (&frames)[CAN_STAT_MOTOR_ID_COUNT][CAN_STAT_CONTROL_BYTE_COUNT],
+        StatCounter &other_frames, unsigned long id, unsigned char len, const unsigned char *data)
+{
+    if (id >= CAN_STAT_MOTOR_ID_COUNT * 2 || len < 1 || data[0] >= CAN_STAT_CONTROL_BYTE_COUNT) {
+        other_frames.increment();
+        return;
+    }
+    frames[id & 0x0F][data[0]].increment();
+}
+
+void DxlBusStatistics::recordResult(uint8_t id, int result)
+{
+    DxlMotorStatistics &motor = motors[id];
+    motor.transactions.increment();
+
+    if (result == COMM_SUCCESS) {
+        return;
+    }
+    if (result == COMM_RX_TIMEOUT) {
+        motor.rx_timeout.increment();
+    }
+    else if (result == COMM_RX_CORRUPT) {
+        motor.rx_corrupt.increment();
+    }
+    else {
+        motor.other_errors.increment();
+    }
+}
+
+void HistogramWindow::report(const std::string &name, const LatencyHistogram &histogram, HwStatisticsReport &report)
+{
+    histogram.snapshot(current);
+    HistogramSnapshot window = current;
+    window.subtract(last);
+    last = current;
+
+    char value[128];
+    snprintf(value, sizeof(value), "n %u, p50 %u, p90 %u, p99 %u, max %u (since start %u)",
+            window.count, window.percentile(0.5), window.percentile(0.9), window.percentile(0.99),
+            window.percentile(1.0), histogram.getMax());
+    report.values.push_back(std::make_pair(name + " [us]", std::string(value)));
+}
+
+void LoopStatisticsWindow::report(const LoopStatistics &loop, HwStatisticsReport &report)
+{
+    cycle.report("cycle", loop.cycle, report);
+    read.report("read", loop.read, report);
+    write.report("write", loop.write, report);
+    if (loop.check_connection.getMax() > 0) {
+        check_connection.report("check connection", loop.check_connection, report);
+    }
+    report.values.push_back(std::make_pair("cycles", std::to_string(loop.cycle_count.get())));
+    report.values.push_back(std::make_pair("overruns", std::to_string(loop.overrun_count.get())));
+}
@@ -0,0 +1,165 @@
+/*
+    rt_control_loop.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "niryo_one_driver/rt_control_loop.h"
+
+#include <errno.h>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+static std::once_flag memory_lock_flag;
+
+static void timespecAddNs(struct timespec *ts, int64_t ns)
+{
+    ts->tv_nsec += ns % NSEC_PER_SEC;
+    ts->tv_sec += ns / NSEC_PER_SEC;
+    if (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    }
+}
+
+static int64_t timespecDiffNs(const struct timespec *a, const struct timespec *b)
+{
+    return (a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+/*
+ * Touches the stack once, so that page faults don't happen later in the loop
+ */
+static void prefaultStack()
+{
+    volatile unsigned char stack[RT_STACK_PREFAULT_SIZE];
+    for (int i = 0; i < RT_STACK_PREFAULT_SIZE; i += 4096) {
+        stack[i] = 0;
+    }
+    (void) stack[0];
+}
+
+void getRtThreadConfig(rclcpp::Node::SharedPtr node, const std::string &prefix, RtThreadConfig &config)
+{
+    node->get_parameter("rt_enabled", config.enabled);
+    node->get_parameter("rt_lock_memory", config.lock_memory);
+    node->get_parameter(prefix + "_rt_priority", config.priority);
+    node->get_parameter(prefix + "_rt_cpu", config.cpu);
+}
+
+bool setupRtThread(const std::string &thread_name, const RtThreadConfig &config)
+{
+    if (!config.enabled) {
+        return true;
+    }
+
+    bool success = true;
+    rclcpp::Logger logger = rclcpp::get_logger("RtControlLoop");
+
+    if (config.lock_memory) {
+        std::call_once(memory_lock_flag, [&]() {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+                RCLCPP_WARN(logger, "mlockall failed (%s), memory may be paged out", strerror(errno));
+                success = false;
+            }
+        });
+        prefaultStack();
+    }
+
+    if (config.cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(config.cpu, &cpu_set);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (result != 0) {
+            RCLCPP_WARN(logger, "%s : can't run on cpu %d (%s)", thread_name.c_str(), config.cpu, strerror(result));
+            success = false;
+        }
+    }
+
+    if (config.priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = config.priority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            RCLCPP_WARN(logger, "%s : can't use SCHED_FIFO priority %d (%s), keeping default scheduling. "
+                    "Give rtprio to the user (/etc/security/limits.conf) or CAP_SYS_NICE to the process",
+                    thread_name.c_str(), config.priority, strerror(result));
+            success = false;
+        }
+    }
+
+    RCLCPP_INFO(logger, "%s : real-time profile %s (priority %d, cpu %d, memory %s)", thread_name.c_str(),
+            success ? "applied" : "partially applied", config.priority, config.cpu, config.lock_memory ? "locked" : "not locked");
+    return success;
+}
+
+RtLoopTimer::RtLoopTimer(const std::string &name, double frequency)
+{
+    this->name = name;
+    period_ns = (int64_t) (NSEC_PER_SEC / frequency);
+    loop_count = 0;
+    overrun_count = 0;
+    logged_overrun_count = 0;
+    max_lateness = 0.0;
+    time_last_overrun_log = 0.0;
+    reset();
+}
+
+void RtLoopTimer::reset()
+{
+    clock_gettime(CLOCK_MONOTONIC, &next_deadline);
+    timespecAddNs(&next_deadline, period_ns);
+}
+
+bool RtLoopTimer::sleep()
+{
+    loop_count++;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t lateness_ns = timespecDiffNs(&now, &next_deadline);
+
+    if (lateness_ns > 0) {
+        overrun_count++;
+        if (lateness_ns / 1e9 > max_lateness) {
+            max_lateness = lateness_ns / 1e9;
+        }
+
+        double now_sec = now.tv_sec + now.tv_nsec / 1e9;
+        if (now_sec - time_last_overrun_log > RT_OVERRUN_LOG_PERIOD) {
+            RCLCPP_WARN(rclcpp::get_logger("RtControlLoop"), "%s : %lu overrun(s) in %lu loops (max %.3lf ms late)",
+                    name.c_str(), (unsigned long) (overrun_count - logged_overrun_count), (unsigned long) loop_count,
+                    max_lateness * 1000.0);
+            logged_overrun_count = overrun_count;
+            time_last_overrun_log = now_sec;
+        }
+
+        next_deadline = now;
+        timespecAddNs(&next_deadline, period_ns);
+        return false;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_deadline, NULL) == EINTR) { }
+    timespecAddNs(&next_deadline, period_ns);
+    return true;
+}
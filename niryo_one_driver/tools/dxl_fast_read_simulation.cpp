@@ -0,0 +1,434 @@
+/*
+    dxl_fast_read_simulation.cpp
+    Copyright (C) 2017 Niryo
+    All rights reserved.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Simulated XL430 chain on a pseudo terminal, to exercise the Fast Sync Read (0x8A) and
+ * Fast Bulk Read (0x9A) paths of DxlDriver without motors.
+ *
+ * The chain answers ping, read, sync read, bulk read and their fast versions. Bus time is
+ * emulated at 1 Mbps (10 us per byte) plus a turnaround gap before each status packet,
+ * so the round trips of the normal and fast reads can be compared.
+ *
+ * Scenarios :
+ * - sync read / bulk read of the state block, fast read enabled and disabled
+ * - an id with a firmware older than XL430_FAST_READ_MIN_FIRMWARE_VERSION : normal read only
+ * - fallback : the chain ignores the fast reads that address one id. The group reading it
+ *   falls back to the normal read and stops using fast read after DXL_FAST_READ_MAX_FAIL
+ *   failures, while another group keeps using fast read.
+ *
+ * usage : dxl_fast_read_simulation [cycles]
+ */
+
+#include <fcntl.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dynamixel_sdk/dynamixel_sdk.h"
+#include "niryo_one_driver/xl430_driver.h"
+
+#define SIM_CONTROL_TABLE_LEN   147
+#define SIM_BYTE_TIME_US        10.0    // 1 Mbps
+#define SIM_TURNAROUND_US       40.0    // before each status packet
+
+#define SIM_FIRST_ID            2
+#define SIM_ID_COUNT            4       // ids 2 to 5
+#define SIM_OLD_FIRMWARE_ID     5       // firmware too old for fast read
+
+/*
+ * Servo chain answering on the master side of the pty
+ */
+class SimulatedChain {
+
+    public:
+        SimulatedChain(int fd);
+
+        void run();
+        void stop() { keep_alive = false; }
+
+        void setIgnoredFastReadId(int id) { ignored_fast_read_id = id; }
+        void resetInstructionCount();
+        int getInstructionCount(uint8_t instruction);
+
+    private:
+        int fd;
+        std::atomic<bool> keep_alive;
+        std::atomic<int> ignored_fast_read_id; // fast reads addressing this id are not answered (-1 : none)
+
+        uint8_t control_table[256][SIM_CONTROL_TABLE_LEN];
+        bool present[256];
+
+        std::mutex count_mutex;
+        int instruction_count[256];
+
+        void handleInstruction(const uint8_t *packet, int length);
+        void sendStatus(uint8_t id, uint8_t error, const uint8_t *params, int params_length);
+        void sendFastStatus(const std::vector<uint8_t> &id_list, const std::vector<uint16_t> &address_list,
+                const std::vector<uint16_t> &length_list);
+        void sendPacket(uint8_t *packet, int params_end);
+};
+
+static void waitUs(double us)
+{
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1e6 + (now.tv_nsec - start.tv_nsec) / 1e3 < us);
+}
+
+SimulatedChain::SimulatedChain(int fd)
+{
+    this->fd = fd;
+    keep_alive = true;
+    ignored_fast_read_id = -1;
+    memset(control_table, 0, sizeof(control_table));
+    memset(present, 0, sizeof(present));
+    memset(instruction_count, 0, sizeof(instruction_count));
+
+    for (int id = SIM_FIRST_ID; id < SIM_FIRST_ID + SIM_ID_COUNT; id++) {
+        present[id] = true;
+        uint8_t *table = control_table[id];
+        table[XL430_ADDR_MODEL_NUMBER] = DXL_LOBYTE(XL430_MODEL_NUMBER);
+        table[XL430_ADDR_MODEL_NUMBER + 1] = DXL_HIBYTE(XL430_MODEL_NUMBER);
+        table[XL430_ADDR_FIRMWARE_VERSION] = (id == SIM_OLD_FIRMWARE_ID) ?
+            XL430_FAST_READ_MIN_FIRMWARE_VERSION - 1 : XL430_FAST_READ_MIN_FIRMWARE_VERSION + 1;
+        for (int i = XL430_ADDR_PRESENT_LOAD; i < XL430_ADDR_PRESENT_POSITION + 4; i++) {
+            table[i] = (uint8_t)(i + id);
+        }
+    }
+}
+
+void SimulatedChain::resetInstructionCount()
+{
+    std::lock_guard<std::mutex> lock(count_mutex);
+    memset(instruction_count, 0, sizeof(instruction_count));
+}
+
+int SimulatedChain::getInstructionCount(uint8_t instruction)
+{
+    std::lock_guard<std::mutex> lock(count_mutex);
+    return instruction_count[instruction];
+}
+
+void SimulatedChain::run()
+{
+    uint8_t buffer[1024];
+    int length = 0;
+
+    while (keep_alive) {
+        int read_length = read(fd, buffer + length, sizeof(buffer) - length);
+        if (read_length <= 0) {
+            usleep(20);
+            continue;
+        }
+        length += read_length;
+
+        // one instruction packet at a time : FF FF FD 00 ID LEN_L LEN_H INST ... CRC_L CRC_H
+        while (length >= 10) {
+            uint8_t *start = (uint8_t *)memchr(buffer, 0xFF, length);
+            if (start == NULL) {
+                length = 0;
+                break;
+            }
+            if (start != buffer) {
+                length -= start - buffer;
+                memmove(buffer, start, length);
+                continue;
+            }
+            if (buffer[1] != 0xFF || buffer[2] != 0xFD || buffer[3] != 0x00) {
+                length--;
+                memmove(buffer, buffer + 1, length);
+                continue;
+            }
+            int total_length = 7 + DXL_MAKEWORD(buffer[5], buffer[6]);
+            if (total_length > (int)sizeof(buffer)) {
+                length = 0;
+                break;
+            }
+            if (length < total_length) {
+                break;
+            }
+            waitUs(total_length * SIM_BYTE_TIME_US); // instruction packet on the bus
+            handleInstruction(buffer, total_length);
+            length -= total_length;
+            memmove(buffer, buffer + total_length, length);
+        }
+    }
+}
+
+void SimulatedChain::handleInstruction(const uint8_t *packet, int length)
+{
+    uint8_t id = packet[4];
+    uint8_t instruction = packet[7];
+    const uint8_t *params = packet + 8;
+    int params_length = length - 10;
+
+    {
+        std::lock_guard<std::mutex> lock(count_mutex);
+        instruction_count[instruction]++;
+    }
+
+    switch (instruction) {
+        case INST_PING:
+            if (present[id]) {
+                uint8_t ping_params[3] = { control_table[id][XL430_ADDR_MODEL_NUMBER],
+                    control_table[id][XL430_ADDR_MODEL_NUMBER + 1], control_table[id][XL430_ADDR_FIRMWARE_VERSION] };
+                sendStatus(id, 0, ping_params, 3);
+            }
+            break;
+        case INST_READ:
+            if (present[id] && params_length == 4) {
+                uint16_t address = DXL_MAKEWORD(params[0], params[1]);
+                uint16_t data_length = DXL_MAKEWORD(params[2], params[3]);
+                if (address + data_length <= SIM_CONTROL_TABLE_LEN) {
+                    sendStatus(id, 0, &control_table[id][address], data_length);
+                }
+            }
+            break;
+        case INST_SYNC_READ:
+        case INST_FAST_SYNC_READ:
+        {
+            uint16_t address = DXL_MAKEWORD(params[0], params[1]);
+            uint16_t data_length = DXL_MAKEWORD(params[2], params[3]);
+            std::vector<uint8_t> id_list(params + 4, params + params_length);
+            std::vector<uint16_t> address_list(id_list.size(), address);
+            std::vector<uint16_t> length_list(id_list.size(), data_length);
+
+            if (instruction == INST_FAST_SYNC_READ) {
+                sendFastStatus(id_list, address_list, length_list);
+                break;
+            }
+            for (size_t i = 0; i < id_list.size(); i++) {
+                if (present[id_list.at(i)]) {
+                    sendStatus(id_list.at(i), 0, &control_table[id_list.at(i)][address], data_length);
+                }
+            }
+            break;
+        }
+        case INST_BULK_READ:
+        case INST_FAST_BULK_READ:
+        {
+            std::vector<uint8_t> id_list;
+            std::vector<uint16_t> address_list;
+            std::vector<uint16_t> length_list;
+            for (int i = 0; i + 5 <= params_length; i += 5) {
+                id_list.push_back(params[i]);
+                address_list.push_back(DXL_MAKEWORD(params[i + 1], params[i + 2]));
+                length_list.push_back(DXL_MAKEWORD(params[i + 3], params[i + 4]));
+            }
+
+            if (instruction == INST_FAST_BULK_READ) {
+                sendFastStatus(id_list, address_list, length_list);
+                break;
+            }
+            for (size_t i = 0; i < id_list.size(); i++) {
+                if (present[id_list.at(i)]) {
+                    sendStatus(id_list.at(i), 0, &control_table[id_list.at(i)][address_list.at(i)], length_list.at(i));
+                }
+            }
+            break;
+        }
+        default:
+            break; // writes are not answered (sync/bulk write) or not used here
+    }
+}
+
+void SimulatedChain::sendStatus(uint8_t id, uint8_t error, const uint8_t *params, int params_length)
+{
+    uint8_t packet[512];
+    packet[4] = id;
+    packet[8] = error;
+    memcpy(&packet[9], params, params_length);
+    sendPacket(packet, 9 + params_length);
+}
+
+/*
+ * One status packet from BROADCAST_ID : ERR ID DATA CRC16 for each id
+ * (the CRC of each block is not checked by the sdk, the CRC of the packet is)
+ */
+void SimulatedChain::sendFastStatus(const std::vector<uint8_t> &id_list, const std::vector<uint16_t> &address_list,
+        const std::vector<uint16_t> &length_list)
+{
+    uint8_t packet[1024];
+    int index = 8;
+
+    for (size_t i = 0; i < id_list.size(); i++) {
+        uint8_t id = id_list.at(i);
+        if (!present[id] || id == ignored_fast_read_id) {
+            return; // no status packet at all : the driver falls back to the normal read
+        }
+        packet[index++] = 0;
+        packet[index++] = id;
+        memcpy(&packet[index], &control_table[id][address_list.at(i)], length_list.at(i));
+        index += length_list.at(i);
+        packet[index++] = 0;
+        packet[index++] = 0;
+    }
+    index -= 2; // the last block CRC is the packet CRC
+    packet[4] = BROADCAST_ID;
+    sendPacket(packet, index);
+}
+
+// header, length, instruction and CRC around params written from packet[8] to packet[params_end]
+void SimulatedChain::sendPacket(uint8_t *packet, int params_end)
+{
+    uint16_t length = params_end + 2 - 7;
+    packet[0] = 0xFF;
+    packet[1] = 0xFF;
+    packet[2] = 0xFD;
+    packet[3] = 0x00;
+    packet[5] = DXL_LOBYTE(length);
+    packet[6] = DXL_HIBYTE(length);
+    packet[7] = INST_STATUS;
+    uint16_t crc = dynamixel::Crc16::update(0, packet, params_end);
+    packet[params_end] = DXL_LOBYTE(crc);
+    packet[params_end + 1] = DXL_HIBYTE(crc);
+
+    waitUs(SIM_TURNAROUND_US + (params_end + 2) * SIM_BYTE_TIME_US);
+    if (write(fd, packet, params_end + 2) != params_end + 2) {
+        fprintf(stderr, "simulated chain : write failed\n");
+    }
+}
+
+/*
+ *  -----------------   SCENARIOS   --------------------
+ */
+
+struct ReadResult {
+    int success;
+    double round_trip_us;
+};
+
+template <typename ReadFunction>
+static ReadResult runCycles(int cycles, ReadFunction read_function)
+{
+    ReadResult result = { 0, 0.0 };
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < cycles; i++) {
+        if (read_function() == COMM_SUCCESS) {
+            result.success++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result.round_trip_us = ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3) / cycles;
+    return result;
+}
+
+static void printResult(const char *name, int cycles, const ReadResult &result, SimulatedChain &chain)
+{
+    printf("%-36s success %d/%d  round trip %5.0f us  instructions : 0x82 %d  0x8A %d  0x92 %d  0x9A %d\n",
+            name, result.success, cycles, result.round_trip_us,
+            chain.getInstructionCount(INST_SYNC_READ), chain.getInstructionCount(INST_FAST_SYNC_READ),
+            chain.getInstructionCount(INST_BULK_READ), chain.getInstructionCount(INST_FAST_BULK_READ));
+}
+
+int main(int argc, char **argv)
+{
+    int cycles = (argc > 1) ? atoi(argv[1]) : 1000;
+    if (cycles <= 0) {
+        cycles = 1000;
+    }
+
+    int master_fd, slave_fd;
+    char slave_name[64];
+    struct termios raw;
+    memset(&raw, 0, sizeof(raw));
+    cfmakeraw(&raw);
+    if (openpty(&master_fd, &slave_fd, slave_name, &raw, NULL) < 0) {
+        perror("openpty");
+        return 1;
+    }
+    fcntl(master_fd, F_SETFL, O_NONBLOCK); // the chain checks keep_alive between reads
+
+    SimulatedChain chain(master_fd);
+    std::thread chain_thread(&SimulatedChain::run, &chain);
+
+    dynamixel::PortHandler *port = dynamixel::PortHandler::getPortHandler(slave_name);
+    dynamixel::PacketHandler *packet_handler = dynamixel::PacketHandler::getPacketHandler(2.0);
+    if (!port->openPort() || !port->setBaudRate(1000000)) {
+        fprintf(stderr, "failed to open %s\n", slave_name);
+        chain.stop();
+        chain_thread.join();
+        return 1;
+    }
+
+    std::vector<uint8_t> fast_ids = { 2, 3, 4 };
+    std::vector<uint8_t> mixed_ids = { 2, 3, 4, SIM_OLD_FIRMWARE_ID };
+    std::vector<uint32_t> position_list, velocity_list, load_list;
+    ReadResult result;
+
+    for (int fast_read_enabled = 0; fast_read_enabled <= 1; fast_read_enabled++) {
+        XL430Driver driver(port, packet_handler);
+        driver.setFastReadEnabled(fast_read_enabled);
+        std::vector<DxlDriver *> driver_list(fast_ids.size(), &driver);
+        printf("fast read %s\n", fast_read_enabled ? "enabled" : "disabled");
+
+        chain.resetInstructionCount();
+        result = runCycles(cycles, [&]() {
+            return driver.syncReadState(fast_ids, position_list, velocity_list, load_list); });
+        printResult("  sync read state, ids 2-4", cycles, result, chain);
+
+        chain.resetInstructionCount();
+        result = runCycles(cycles, [&]() {
+            return driver.bulkReadState(fast_ids, driver_list, position_list, velocity_list, load_list); });
+        printResult("  bulk read state, ids 2-4", cycles, result, chain);
+
+        chain.resetInstructionCount();
+        result = runCycles(cycles, [&]() {
+            return driver.syncReadState(mixed_ids, position_list, velocity_list, load_list); });
+        printResult("  sync read state, ids 2-5 (old fw)", cycles, result, chain);
+    }
+
+    // fallback : fast reads addressing id 4 are not answered
+    {
+        XL430Driver driver(port, packet_handler);
+        driver.setFastReadEnabled(true);
+        std::vector<uint8_t> other_ids = { 2, 3 };
+        chain.setIgnoredFastReadId(4);
+        printf("fallback (fast reads addressing id 4 are not answered)\n");
+
+        chain.resetInstructionCount();
+        result = runCycles(cycles, [&]() {
+            int state_result = driver.syncReadState(fast_ids, position_list, velocity_list, load_list);
+            int position_result = driver.syncReadPosition(other_ids, position_list);
+            return (state_result != COMM_SUCCESS) ? state_result : position_result; });
+        printResult("  state ids 2-4 + position ids 2-3", cycles, result, chain);
+        printf("  expected : 0x82 %d (state group falls back), 0x8A %d (position group stays fast)\n",
+                cycles, cycles + DXL_FAST_READ_MAX_FAIL);
+        chain.setIgnoredFastReadId(-1);
+    }
+
+    port->closePort();
+    chain.stop();
+    chain_thread.join();
+    close(slave_fd);
+    close(master_fd);
+    return 0;
+}